@@ -0,0 +1,187 @@
+#ifndef __RUBIK_ALGORITHM_CACHE_H__
+#define __RUBIK_ALGORITHM_CACHE_H__
+
+#include <rubik.h>
+#include <move_table.h>
+#include <notation.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+/*    Default number of compiled algorithms kept by a cache    */
+const size_t DEFAULT_ALGORITHM_CACHE_CAPACITY = 1024;
+
+/**
+  * @brief Bounded cache of move sequences compiled to a single facelet permutation. Applying a compiled
+  *        sequence costs one pass over the face elements, whatever its length.
+  *
+  * Sequences are keyed by their normalized notation: quarter turns, with half turns always written
+  * clockwise like MovesToString does, so "R  U2", "R U U" and "R U' U'" share an entry. Keys are stored in
+  * binary, 2 bytes per quarter turn, so lookups don't format any text. When the cache is full, the least
+  * recently used entry is discarded. It is not thread safe: each thread shall use its own cache.
+  */
+template<size_t CUBE_SIZE>
+class AlgorithmCache {
+private:
+    typedef std::list<std::pair<std::string, FaceletPermutation<CUBE_SIZE>>> Entries;
+
+    // Most recently used first
+    Entries entries;
+    std::unordered_map<std::string, typename Entries::iterator> index;
+    size_t capacity;
+    size_t num_hits;
+    size_t num_misses;
+    // Buffers reused by lookups
+    std::vector<Move> moves;
+    std::string key;
+
+    /**
+      * @brief Builds the key of the parsed moves. Pairs of equal quarter turns are made clockwise in 'moves',
+      *        which doesn't change their permutation
+      */
+    void BuildKey();
+
+public:
+    /**
+      * @brief Initializes an empty cache
+      * @param capacity Maximum number of compiled sequences. It shall be positive
+      */
+    explicit AlgorithmCache(size_t capacity = DEFAULT_ALGORITHM_CACHE_CAPACITY);
+
+    /**
+      * @brief Returns the permutation of a move sequence, compiling it if it is not cached
+      * @param notation Moves in standard notation (see ParseMoves)
+      * @return Permutation. It is valid until the entry is discarded by a later call
+      * @throw std::invalid_argument if the notation is not valid
+      */
+    const FaceletPermutation<CUBE_SIZE>& Get(const std::string &notation);
+
+    /**
+      * @brief Returns the permutation of the move sequence of a range of characters (see Get)
+      */
+    const FaceletPermutation<CUBE_SIZE>& Get(const char *begin, const char *end);
+
+    /**
+      * @brief Applies a move sequence to a cube, with one permutation of its face elements
+      * @param notation Moves in standard notation (see ParseMoves)
+      * @param cube Cube to change. Objects move with their face elements
+      * @throw std::invalid_argument if the notation is not valid
+      */
+    template<typename T>
+    void Apply(const std::string &notation, RubikCube<T, CUBE_SIZE> &cube);
+
+    /**
+      * @brief Removes all the entries. Statistics are kept
+      */
+    void Clear();
+
+    size_t GetSize() const;
+    size_t GetCapacity() const;
+    size_t GetNumHits() const;
+    size_t GetNumMisses() const;
+
+    /**
+      * @brief Returns number of quarter turns of the last sequence passed to Get or Apply
+      */
+    size_t GetLastLength() const;
+};
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+template<size_t CUBE_SIZE>
+AlgorithmCache<CUBE_SIZE>::AlgorithmCache(size_t capacity)
+    : capacity(capacity), num_hits(0), num_misses(0)
+{
+    if(capacity == 0)
+        throw std::invalid_argument("Capacity of the cache shall be positive");
+}
+
+template<size_t CUBE_SIZE>
+void AlgorithmCache<CUBE_SIZE>::BuildKey() {
+    key.clear();
+    for(size_t i=0; i<moves.size(); ++i) {
+        if(i+1 < moves.size() && moves[i] == moves[i+1]) {
+            moves[i].clockwise = CLOCKWISE;
+            moves[i+1].clockwise = CLOCKWISE;
+        }
+        const Move &move = moves[i];
+        size_t code = (move.face*CUBE_SIZE + move.depth)*2 + move.clockwise;
+        key += (char)(code & 0xff);
+        key += (char)(code >> 8);
+    }
+}
+
+template<size_t CUBE_SIZE>
+const FaceletPermutation<CUBE_SIZE>& AlgorithmCache<CUBE_SIZE>::Get(const std::string &notation) {
+    return Get(notation.data(), notation.data() + notation.size());
+}
+
+template<size_t CUBE_SIZE>
+const FaceletPermutation<CUBE_SIZE>& AlgorithmCache<CUBE_SIZE>::Get(const char *begin, const char *end) {
+    moves.clear();
+    ParseMoves(begin, end, CUBE_SIZE, moves);
+    BuildKey();
+
+    auto found = index.find(key);
+    if(found != index.end()) {
+        ++num_hits;
+        entries.splice(entries.begin(), entries, found->second);
+        return found->second->second;
+    }
+
+    ++num_misses;
+    if(entries.size() >= capacity) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+    FaceletPermutation<CUBE_SIZE> permutation;
+    MoveTable<CUBE_SIZE>::Get().Compile(moves, permutation);
+    entries.emplace_front(key, permutation);
+    index.emplace(key, entries.begin());
+    return entries.front().second;
+}
+
+template<size_t CUBE_SIZE>
+template<typename T>
+void AlgorithmCache<CUBE_SIZE>::Apply(const std::string &notation, RubikCube<T, CUBE_SIZE> &cube) {
+    cube.PermuteFacelets(Get(notation));
+}
+
+template<size_t CUBE_SIZE>
+void AlgorithmCache<CUBE_SIZE>::Clear() {
+    entries.clear();
+    index.clear();
+}
+
+template<size_t CUBE_SIZE>
+size_t AlgorithmCache<CUBE_SIZE>::GetSize() const {
+    return entries.size();
+}
+
+template<size_t CUBE_SIZE>
+size_t AlgorithmCache<CUBE_SIZE>::GetCapacity() const {
+    return capacity;
+}
+
+template<size_t CUBE_SIZE>
+size_t AlgorithmCache<CUBE_SIZE>::GetNumHits() const {
+    return num_hits;
+}
+
+template<size_t CUBE_SIZE>
+size_t AlgorithmCache<CUBE_SIZE>::GetNumMisses() const {
+    return num_misses;
+}
+
+template<size_t CUBE_SIZE>
+size_t AlgorithmCache<CUBE_SIZE>::GetLastLength() const {
+    return moves.size();
+}
+
+#endif
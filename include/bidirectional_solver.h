@@ -0,0 +1,227 @@
+#ifndef __RUBIK_BIDIRECTIONAL_SOLVER_H__
+#define __RUBIK_BIDIRECTIONAL_SOLVER_H__
+
+#include <rubik.h>
+#include <move_generator.h>
+#include <state_encoding.h>
+#include <state_set.h>
+#include <tools.h>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+/**
+  * Meet in the middle search of shortest solutions: breadth first searches from the cube and from the solved
+  * states (in every orientation) take turns to expand a whole layer, the smaller frontier first, until a state
+  * of one search is found by the other one. A solution of d moves is found after visiting about twice the
+  * states at distance d/2, instead of the states at distance d.
+  *
+  * States are stored encoded (EncodeState3 for 3x3 cubes, PackFacelets for other sizes) in a StateSet, with
+  * the move which reached them, so solutions are rebuilt by following those moves back to the roots.
+  */
+
+/*    Statistics of a bidirectional search    */
+struct BidirectionalStats {
+    uint64_t nodes = 0;        // States generated by both searches, including repeated ones
+    size_t memory = 0;         // Peak bytes of the sets and frontiers
+    double latency = 0.0;      // Seconds
+    size_t forward_depth = 0;  // Layers expanded from the cube
+    size_t backward_depth = 0; // Layers expanded from the solved states
+};
+
+/**
+  * @brief Searches a shortest solution with a bidirectional breadth first search. Solved means each face
+  *        has a single color, in any orientation. Moves are the quarter turns of SolveIDDFS
+  * @param cube Cube to solve
+  * @param max_depth Maximum length of the solution, in quarter turns
+  * @param solution Output solution
+  * @param stats Output statistics of the search. Ignored if null
+  * @return True if a solution was found. False if there is no solution of at most max_depth quarter turns,
+  *         or the cube is not in a valid state
+  */
+template<typename T, size_t CUBE_SIZE>
+bool SolveBidirectional(const RubikCube<T, CUBE_SIZE> &cube, size_t max_depth, std::vector<Move> &solution,
+                        BidirectionalStats *stats = nullptr);
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+/*    Value of the states a search starts from    */
+const uint8_t BIDIRECTIONAL_ROOT = 0xff;
+
+/**
+  * @brief Returns size of the keys of the states of a bidirectional search
+  */
+template<size_t CUBE_SIZE>
+constexpr size_t GetSearchKeySize() {
+    return CUBE_SIZE == 3 ? STATE3_SIZE : GetPackedFaceletsSize(CUBE_SIZE);
+}
+
+/**
+  * @brief Encodes a state of a bidirectional search. 3x3 cubes use coordinates, which are smaller
+  * @return False if the cube is not in a valid state
+  */
+template<typename T>
+bool EncodeSearchKey(const RubikCube<T, 3> &cube, uint8_t *key) {
+    return EncodeState3(cube, key);
+}
+
+template<typename T, size_t CUBE_SIZE>
+bool EncodeSearchKey(const RubikCube<T, CUBE_SIZE> &cube, uint8_t *key) {
+    PackFacelets(cube, key);
+    return true;
+}
+
+/**
+  * @brief Decodes a state encoded by EncodeSearchKey
+  */
+template<typename T>
+void DecodeSearchKey(const uint8_t *key, RubikCube<T, 3> &cube) {
+    DecodeState3(key, cube);
+}
+
+template<typename T, size_t CUBE_SIZE>
+void DecodeSearchKey(const uint8_t *key, RubikCube<T, CUBE_SIZE> &cube) {
+    UnpackFacelets(key, cube);
+}
+
+/**
+  * @brief Returns the solved cube in each orientation, reached by turning all the layers of an axis
+  */
+template<size_t CUBE_SIZE>
+std::vector<RubikCube<int, CUBE_SIZE>> GetSolvedOrientations() {
+    std::vector<RubikCube<int, CUBE_SIZE>> orientations(1);
+    StateSet found(GetSearchKeySize<CUBE_SIZE>(), 24);
+    uint8_t key[GetSearchKeySize<CUBE_SIZE>()];
+    FaceElement axes_faces[2] = {FRONT, TOP};
+
+    EncodeSearchKey(orientations[0], key);
+    found.Insert(key, 0);
+    for(size_t i=0; i<orientations.size(); ++i) {
+        for(int k=0; k<2; ++k) {
+            RubikCube<int, CUBE_SIZE> next = orientations[i];
+            for(size_t depth=0; depth<CUBE_SIZE; ++depth)
+                next.RotateFace(axes_faces[k], CLOCKWISE, depth);
+            EncodeSearchKey(next, key);
+            if(found.Insert(key, 0))
+                orientations.push_back(next);
+        }
+    }
+    return orientations;
+}
+
+/**
+  * @brief Expands a layer of a bidirectional search
+  * @param frontier Keys of the states of the last layer. It is replaced by the next layer
+  * @param visited States of this search, with the move which reached them
+  * @param other States of the other search
+  * @param meeting Output key of a state found by both searches
+  * @param nodes Number of generated states, which is increased
+  * @return True if a state of the other search was found
+  */
+template<size_t CUBE_SIZE>
+bool ExpandBidirectionalLayer(std::vector<uint8_t> &frontier, StateSet &visited, const StateSet &other,
+                              const std::vector<Move> &moves, uint8_t *meeting, uint64_t &nodes) {
+    const size_t key_size = GetSearchKeySize<CUBE_SIZE>();
+    std::vector<uint8_t> next;
+    RubikCube<int, CUBE_SIZE> cube;
+    uint8_t key[GetSearchKeySize<CUBE_SIZE>()];
+    uint8_t value;
+
+    for(size_t i=0; i<frontier.size(); i+=key_size) {
+        DecodeSearchKey(&frontier[i], cube);
+        for(size_t move=0; move<moves.size(); ++move) {
+            cube.RotateFace(moves[move]);
+            EncodeSearchKey(cube, key);
+            cube.RotateFace(moves[move].face, !moves[move].clockwise, moves[move].depth);
+            ++nodes;
+            if(!visited.Insert(key, move))
+                continue;
+            if(other.Find(key, value)) {
+                std::copy(key, key + key_size, meeting);
+                return true;
+            }
+            next.insert(next.end(), key, key + key_size);
+        }
+    }
+    frontier.swap(next);
+    return false;
+}
+
+template<typename T, size_t CUBE_SIZE>
+bool SolveBidirectional(const RubikCube<T, CUBE_SIZE> &cube, size_t max_depth, std::vector<Move> &solution,
+                        BidirectionalStats *stats) {
+    const size_t key_size = GetSearchKeySize<CUBE_SIZE>();
+    // Quarter turns come in pairs of both directions, so the inverse of move i is i^1
+    const std::vector<Move> moves = GetSolverMoves<CUBE_SIZE>();
+    const std::vector<RubikCube<int, CUBE_SIZE>> solved = GetSolvedOrientations<CUBE_SIZE>();
+    StateSet forward(key_size);
+    StateSet backward(key_size, solved.size());
+    std::vector<uint8_t> forward_frontier(key_size);
+    std::vector<uint8_t> backward_frontier;
+    uint8_t meeting[GetSearchKeySize<CUBE_SIZE>()];
+    uint8_t key[GetSearchKeySize<CUBE_SIZE>()];
+    uint8_t value;
+    BidirectionalStats local_stats;
+    double start = get_monotonic_time();
+    bool found = false;
+
+    if(stats == nullptr)
+        stats = &local_stats;
+    *stats = BidirectionalStats();
+    solution.clear();
+    if(!EncodeSearchKey(cube, forward_frontier.data()))
+        return false;
+    forward.Insert(forward_frontier.data(), BIDIRECTIONAL_ROOT);
+    for(size_t i=0; i<solved.size(); ++i) {
+        EncodeSearchKey(solved[i], key);
+        if(backward.Insert(key, BIDIRECTIONAL_ROOT))
+            backward_frontier.insert(backward_frontier.end(), key, key + key_size);
+    }
+
+    found = backward.Find(forward_frontier.data(), value);
+    if(found)
+        std::copy(forward_frontier.begin(), forward_frontier.end(), meeting);
+    // Frontiers become empty when all the reachable states have been visited
+    while(!found && stats->forward_depth + stats->backward_depth < max_depth &&
+          !forward_frontier.empty() && !backward_frontier.empty()) {
+        if(forward_frontier.size() <= backward_frontier.size()) {
+            found = ExpandBidirectionalLayer<CUBE_SIZE>(forward_frontier, forward, backward, moves, meeting, stats->nodes);
+            ++stats->forward_depth;
+        } else {
+            found = ExpandBidirectionalLayer<CUBE_SIZE>(backward_frontier, backward, forward, moves, meeting, stats->nodes);
+            ++stats->backward_depth;
+        }
+        size_t memory = forward.GetMemoryUsage() + backward.GetMemoryUsage() +
+                        forward_frontier.capacity() + backward_frontier.capacity();
+        stats->memory = std::max(stats->memory, memory);
+    }
+
+    if(found) {
+        // Moves from the cube to the meeting state, found backwards, then moves from it to a solved state
+        RubikCube<int, CUBE_SIZE> state;
+        DecodeSearchKey(meeting, state);
+        std::copy(meeting, meeting + key_size, key);
+        while(forward.Find(key, value) && value != BIDIRECTIONAL_ROOT) {
+            solution.push_back(moves[value]);
+            state.RotateFace(moves[value^1]);
+            EncodeSearchKey(state, key);
+        }
+        std::reverse(solution.begin(), solution.end());
+
+        DecodeSearchKey(meeting, state);
+        std::copy(meeting, meeting + key_size, key);
+        while(backward.Find(key, value) && value != BIDIRECTIONAL_ROOT) {
+            solution.push_back(moves[value^1]);
+            state.RotateFace(moves[value^1]);
+            EncodeSearchKey(state, key);
+        }
+    }
+    stats->latency = get_monotonic_time() - start;
+    return found;
+}
+
+#endif
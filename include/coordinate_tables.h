@@ -0,0 +1,164 @@
+#ifndef __RUBIK_COORDINATE_TABLES_H__
+#define __RUBIK_COORDINATE_TABLES_H__
+
+#include <state_encoding.h>
+#include <move_generator.h>
+#include <thread_pool.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+  * Move tables of 3x3 coordinates: small integers which describe a part of the state of the pieces (see
+  * CubieState3), such as the twists of the corners. A move changes a coordinate to a value which only depends
+  * on its previous value, so searches can turn a state made of several coordinates with one table lookup per
+  * coordinate, without face elements.
+  *
+  * Moves are the ones of MoveGenerator<3>(FACE_TURN_METRIC), with the same indices, so searches can also use
+  * its state machine. Tables are built from the pieces moved by RubikCube::RotateFace.
+  */
+
+/*    Coordinates of a 3x3 cube    */
+typedef enum {
+    CORNER_TWIST_COORD = 0,   // Twists of the first 7 corners. The last one is implied
+    EDGE_FLIP_COORD,          // Flips of the first 11 edges. The last one is implied
+    CORNER_PERMUTATION_COORD, // Rank of the permutation of corners
+    SLICE_COORD,              // Slots of the edges of the slice between TOP and BOTTOM, ignoring their order
+    SLICE_PERMUTATION_COORD,  // Slots of the edges of the slice, and their order
+    NUM_COORDINATES
+} Coordinate3;
+
+/*    Number of values of each coordinate    */
+const uint32_t COORDINATE_SIZES[NUM_COORDINATES] = {
+    2187,  // 3^7
+    2048,  // 2^11
+    40320, // 8!
+    495,   // 12 choose 4
+    11880  // 12 choose 4 * 4!
+};
+
+/*    Moves of the tables: quarter and half turns of each face    */
+const size_t NUM_COORDINATE_MOVES = 18;
+
+/*    Values computed by each task of the table generation    */
+const size_t COORDINATE_TABLE_BLOCK = 1024;
+
+const char COORDINATE_FILE_MAGIC[8] = {'R', 'U', 'B', 'I', 'K', 'C', 'R', 'D'};
+const uint32_t COORDINATE_FILE_VERSION = 1;
+
+/**
+  * Layout of a file of tables (little endian): this header, then the table of each coordinate in order, as
+  * COORDINATE_SIZES[c]*NUM_COORDINATE_MOVES uint16_t values
+  */
+struct CoordinateFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_coordinates;
+    uint32_t num_moves;
+    uint32_t sizes[NUM_COORDINATES];
+    uint64_t fingerprint; // Identifies the moves the tables were built from
+    uint8_t reserved[16];
+};
+
+static_assert(sizeof(CoordinateFileHeader) == 64, "Unexpected padding of CoordinateFileHeader");
+
+/**
+  * @brief Returns the name of a coordinate, as written by rubikctl
+  */
+const char* GetCoordinateName(Coordinate3 coordinate);
+
+/**
+  * @brief Computes a coordinate of the pieces of a cube
+  * @return Value in range [0, COORDINATE_SIZES[coordinate])
+  */
+uint32_t GetCoordinate3(const CubieState3 &cubies, Coordinate3 coordinate);
+
+/**
+  * @brief Changes the pieces of a cube so a coordinate has a given value. Other pieces are moved as needed to
+  *        keep a permutation, but the result may not be a reachable state
+  * @pre value < COORDINATE_SIZES[coordinate]
+  */
+void SetCoordinate3(Coordinate3 coordinate, uint32_t value, CubieState3 &cubies);
+
+/**
+  * @brief Applies a state to another one, like applying the moves which reach 'second' from the solved cube
+  *        after the ones which reach 'first'
+  * @param result Output state. It can't be one of the inputs
+  */
+void MultiplyCubies3(const CubieState3 &first, const CubieState3 &second, CubieState3 &result);
+
+
+/**
+  * @brief Move tables of all the coordinates of a 3x3 cube
+  */
+class CoordinateTables {
+private:
+    // Table of coordinate c: tables[c][value*NUM_COORDINATE_MOVES + move]
+    std::vector<uint16_t> tables[NUM_COORDINATES];
+
+public:
+    /**
+      * @brief Generates the tables. Blocks of values are computed in parallel
+      * @param pool Threads which compute the blocks
+      */
+    explicit CoordinateTables(ThreadPool &pool);
+
+    /**
+      * @brief Reads tables written by Save
+      * @throw std::runtime_error if the file could not be read, it is not a valid file of tables, or it was built
+      *        from other moves than the current ones
+      */
+    explicit CoordinateTables(const std::string &filename);
+
+    /**
+      * @brief Writes the tables
+      * @throw std::runtime_error if the file could not be written
+      */
+    void Save(const std::string &filename) const;
+
+    /**
+      * @brief Returns the value of a coordinate after a move
+      * @pre value < COORDINATE_SIZES[coordinate], move < NUM_COORDINATE_MOVES
+      */
+    uint32_t Move(Coordinate3 coordinate, uint32_t value, size_t move) const;
+
+    /**
+      * @brief Returns the table of a coordinate, indexed by value*NUM_COORDINATE_MOVES + move
+      */
+    const uint16_t* GetTable(Coordinate3 coordinate) const;
+
+    /**
+      * @brief Returns the pieces moved by each move of the tables, as seen on a solved cube
+      */
+    static std::vector<CubieState3> GetMoveCubies();
+
+    /**
+      * @brief Returns an identifier of the moves of the tables. Files of tables built from other moves are
+      *        rejected
+      */
+    static uint64_t GetFingerprint();
+};
+
+/**
+  * @brief Reads tables from a file, or generates them and writes the file if it can't be read
+  * @throw std::runtime_error if the tables were generated but the file could not be written
+  */
+CoordinateTables LoadCoordinateTables(const std::string &filename, ThreadPool &pool);
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+inline uint32_t CoordinateTables::Move(Coordinate3 coordinate, uint32_t value, size_t move) const {
+    assert(value < COORDINATE_SIZES[coordinate] && move < NUM_COORDINATE_MOVES);
+    return tables[coordinate][value*NUM_COORDINATE_MOVES + move];
+}
+
+inline const uint16_t* CoordinateTables::GetTable(Coordinate3 coordinate) const {
+    return tables[coordinate].data();
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef __RUBIK_CUBE_GEOMETRY_H__
+#define __RUBIK_CUBE_GEOMETRY_H__
+
+#include <irrlicht.h>
+#include <rubik.h>
+
+/**
+  * @brief Returns normalized rotation axis of a face
+  * @pre face parameter shall not be INVALID
+  * @param face Face of rotation
+  * @return Normalized 3D vector representing rotation axis of a face
+  */
+irr::core::vector3df GetRotationAxis(FaceElement face);
+
+/**
+  * @brief Returns the color of a face element
+  * @pre face parameter shall not be INVALID
+  * @param face Face whose color is returned
+  * @return Color, in ARGB format
+  */
+irr::video::SColor GetFaceColor(FaceElement face);
+
+/**
+  * @brief Creates the material used to draw face elements of a face. Here you can find reflexive properties
+  * @pre face parameter shall not be INVALID
+  * @param face Face whose color is used
+  * @return Material of the face elements
+  */
+irr::video::SMaterial CreateFaceMaterial(FaceElement face);
+
+/**
+  * @brief Returns rotation of a plane mesh (created in XZ plane) which makes it parallel to a face
+  * @pre face parameter shall not be INVALID
+  * @param face Selected face
+  * @return Rotation in Euler angles, in degrees
+  */
+irr::core::vector3df GetFaceRotation(FaceElement face);
+
+/**
+  * @brief Returns a point of a face of the cube, relative to its center
+  * @pre face parameter shall not be INVALID
+  * @param face Face where the point is
+  * @param row_offset Offset from face center, in direction of growing rows. Range [-half_length, half_length]
+  * @param col_offset Offset from face center, in direction of growing columns. Range [-half_length, half_length]
+  * @param half_length Half of the length of the cube edge
+  * @return Point in cube space
+  */
+irr::core::vector3df GetFacePoint(FaceElement face, float row_offset, float col_offset, float half_length);
+
+#endif
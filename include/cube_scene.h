@@ -0,0 +1,429 @@
+#ifndef __RUBIK_CUBE_SCENE_H__
+#define __RUBIK_CUBE_SCENE_H__
+
+#include <irrlicht.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <rubik.h>
+#include <cube_geometry.h>
+#include <irrlicht_tools.h>
+#include <frame_stats.h>
+#include <tools.h>
+
+
+/**
+  * @brief Shows many rubik cubes at once, laid out in a grid. Each cube has its own model
+  *
+  * Cubes outside the view frustum are not drawn at all. Cubes far from the camera are drawn with
+  * one textured quad per face, generated from the colors of the face elements, instead of one
+  * node per face element. The camera orbits the grid (left button), zooms (right button) and
+  * translates (middle button).
+  */
+template<size_t CUBE_SIZE>
+class RubikCubeScene {
+private:
+    static constexpr int NUM_FACES = 6;
+    static constexpr size_t NUM_FACE_ELEMENTS = NUM_FACES*CUBE_SIZE*CUBE_SIZE;
+    // Textures of simplified cubes place the faces in a grid of 3x2 faces
+    static constexpr size_t ATLAS_COLUMNS = 3;
+    static constexpr size_t ATLAS_ROWS = 2;
+    // Period of overlay refresh, in seconds
+    static constexpr double STATS_REFRESH_PERIOD = 0.25;
+
+    struct SceneCube {
+        RubikCube<int, CUBE_SIZE> model;
+        irr::scene::ISceneNode *root;
+        // One node per face element, ordered by face, row and column
+        irr::scene::ISceneNode *detailed;
+        std::array<irr::scene::ISceneNode*, NUM_FACE_ELEMENTS> face_element_nodes;
+        // One textured quad per face
+        irr::scene::ISceneNode *simplified;
+        irr::video::ITexture *texture;
+        // Bounding box in world space
+        irr::core::aabbox3df bounding_box;
+        // Model has changed since nodes or texture were updated
+        bool detailed_dirty;
+        bool texture_dirty;
+    };
+
+    irr::IrrlichtDevice *device;
+    irr::video::IVideoDriver* driver;
+    irr::scene::ISceneManager* smgr;
+    irr::gui::IGUIEnvironment* guienv;
+    irr::scene::ICameraSceneNode *camera;
+    irr::gui::IGUIStaticText *stats_text;
+
+    std::vector<SceneCube> cubes;
+    std::array<irr::video::SMaterial, NUM_FACES> faces_materials;
+    float lod_distance;
+
+    FrameStats frame_stats;
+    double last_frame_time;
+    double last_stats_refresh = 0.0;
+    size_t num_visible = 0;
+    size_t num_detailed = 0;
+
+protected:
+    /**
+      * @brief Creates the mesh shared by all simplified cubes: 6 quads mapped to the texture atlas
+      * @param cube_length Length of the cube edge
+      * @return New mesh. Caller shall drop it
+      */
+    irr::scene::IMesh* CreateSimplifiedMesh(float cube_length) const;
+
+    /**
+      * @brief Creates the scene nodes of a cube
+      * @param cube Cube whose nodes are created
+      * @param position Center of the cube
+      * @param cube_length Length of the cube edge
+      * @param face_element_mesh Mesh of one face element
+      * @param simplified_mesh Mesh of a simplified cube
+      */
+    void GenerateCube(SceneCube &cube, const irr::core::vector3df &position, float cube_length,
+                      irr::scene::IMesh *face_element_mesh, irr::scene::IMesh *simplified_mesh);
+
+    /**
+      * @brief Sets materials of face element nodes from the model
+      */
+    void UpdateDetailed(SceneCube &cube);
+
+    /**
+      * @brief Regenerates the texture of the simplified cube from the model
+      * @param cube_id Index of the cube. Used to name its texture
+      */
+    void UpdateTexture(size_t cube_id);
+
+    /**
+      * @brief Culls cubes out of the view frustum and selects level of detail of the other ones
+      */
+    void UpdateVisibility();
+
+public:
+    /**
+      * @brief Creates a window which shows a grid of solved cubes
+      * @param window_title Title of the window
+      * @param width Width of the window, in pixels
+      * @param height Height of the window, in pixels
+      * @param num_cubes Number of cubes of the grid
+      * @param cube_length Length of the cube edge, in units of Irrlicht
+      */
+    RubikCubeScene(const std::wstring &window_title, size_t width, size_t height, size_t num_cubes, float cube_length);
+
+    /**
+      * @brief It frees resources
+      */
+    ~RubikCubeScene();
+
+    RubikCubeScene(const RubikCubeScene&) = delete;
+    RubikCubeScene& operator=(const RubikCubeScene&) = delete;
+
+    /**
+      * @brief Returns number of cubes of the scene
+      */
+    size_t GetNumCubes() const;
+
+    /**
+      * @brief Returns the model of a cube
+      * @pre cube_id in range [0, GetNumCubes())
+      */
+    const RubikCube<int, CUBE_SIZE>& GetCube(size_t cube_id) const;
+
+    /**
+      * @brief Applies a move to a cube. Scene nodes are updated when the cube is drawn
+      * @pre cube_id in range [0, GetNumCubes())
+      * @param cube_id Index of the cube
+      * @param move Move to apply
+      */
+    void ApplyMove(size_t cube_id, const Move &move);
+
+    /**
+      * @brief Sets distance from the camera where cubes start being drawn simplified
+      * @param distance Distance, in units of Irrlicht
+      */
+    void SetLODDistance(float distance);
+
+    /**
+      * @brief Normal case. Window can continue
+      * @return False if window should close and program should end. True in any other case
+      */
+    bool ShouldContinue() const;
+
+    /**
+      * @brief Draws a new frame
+      */
+    void UpdateFrame();
+};
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+template<size_t CUBE_SIZE>
+irr::scene::IMesh* RubikCubeScene<CUBE_SIZE>::CreateSimplifiedMesh(float cube_length) const {
+    irr::scene::SMeshBuffer *buffer = new irr::scene::SMeshBuffer();
+    irr::scene::SMesh *mesh = new irr::scene::SMesh();
+    float half = cube_length * 0.5f;
+
+    for(int face=0; face<NUM_FACES; ++face) {
+        float u0 = (float)(face % ATLAS_COLUMNS) / ATLAS_COLUMNS;
+        float u1 = (float)(face % ATLAS_COLUMNS + 1) / ATLAS_COLUMNS;
+        float v0 = (float)(face / ATLAS_COLUMNS) / ATLAS_ROWS;
+        float v1 = (float)(face / ATLAS_COLUMNS + 1) / ATLAS_ROWS;
+        irr::core::vector3df normal = GetFacePoint((FaceElement)face, 0.0f, 0.0f, half).normalize();
+        irr::u16 first = buffer->Vertices.size();
+        irr::video::SColor white(255, 255, 255, 255);
+
+        // Texture rows and columns follow rows and columns of the face
+        buffer->Vertices.push_back(irr::video::S3DVertex(GetFacePoint((FaceElement)face, -half, -half, half), normal, white, irr::core::vector2df(u0, v0)));
+        buffer->Vertices.push_back(irr::video::S3DVertex(GetFacePoint((FaceElement)face, -half,  half, half), normal, white, irr::core::vector2df(u1, v0)));
+        buffer->Vertices.push_back(irr::video::S3DVertex(GetFacePoint((FaceElement)face,  half,  half, half), normal, white, irr::core::vector2df(u1, v1)));
+        buffer->Vertices.push_back(irr::video::S3DVertex(GetFacePoint((FaceElement)face,  half, -half, half), normal, white, irr::core::vector2df(u0, v1)));
+        buffer->Indices.push_back(first);
+        buffer->Indices.push_back(first+1);
+        buffer->Indices.push_back(first+2);
+        buffer->Indices.push_back(first);
+        buffer->Indices.push_back(first+2);
+        buffer->Indices.push_back(first+3);
+    }
+
+    // Colors come only from the texture, without filtering, so face elements keep sharp borders
+    buffer->Material.setFlag(irr::video::EMF_LIGHTING, false);
+    buffer->Material.setFlag(irr::video::EMF_BACK_FACE_CULLING, false);
+    buffer->Material.setFlag(irr::video::EMF_BILINEAR_FILTER, false);
+    buffer->Material.setFlag(irr::video::EMF_USE_MIP_MAPS, false);
+    buffer->recalculateBoundingBox();
+
+    mesh->addMeshBuffer(buffer);
+    mesh->recalculateBoundingBox();
+    buffer->drop();
+    return mesh;
+}
+
+template<size_t CUBE_SIZE>
+void RubikCubeScene<CUBE_SIZE>::GenerateCube(SceneCube &cube, const irr::core::vector3df &position, float cube_length,
+                                             irr::scene::IMesh *face_element_mesh, irr::scene::IMesh *simplified_mesh) {
+    float element_size = cube_length / CUBE_SIZE;
+    float half = cube_length * 0.5f;
+    irr::core::vector3df scale = {0.9f, 0.9f, 0.9f};
+    size_t i = 0;
+
+    cube.root = smgr->addEmptySceneNode();
+    cube.root->setPosition(position);
+    cube.detailed = smgr->addEmptySceneNode(cube.root);
+
+    for(int face=0; face<NUM_FACES; ++face) {
+        for(size_t row=0; row<CUBE_SIZE; ++row) {
+            for(size_t col=0; col<CUBE_SIZE; ++col) {
+                float pos_row = element_size * row - half + element_size*0.5f;
+                float pos_col = element_size * col - half + element_size*0.5f;
+                irr::scene::ISceneNode *node = smgr->addMeshSceneNode(face_element_mesh, cube.detailed, -1,
+                                                                      GetFacePoint((FaceElement)face, pos_row, pos_col, half),
+                                                                      GetFaceRotation((FaceElement)face), scale);
+                // The whole cube is culled at once
+                node->setAutomaticCulling(irr::scene::EAC_OFF);
+                node->getMaterial(0) = faces_materials[face];
+                cube.face_element_nodes[i++] = node;
+            }
+        }
+    }
+
+    cube.simplified = smgr->addMeshSceneNode(simplified_mesh, cube.root);
+    cube.simplified->setAutomaticCulling(irr::scene::EAC_OFF);
+    cube.simplified->setVisible(false);
+    cube.texture = nullptr;
+
+    cube.bounding_box = irr::core::aabbox3df(position - irr::core::vector3df(half, half, half),
+                                             position + irr::core::vector3df(half, half, half));
+    cube.detailed_dirty = false;
+    cube.texture_dirty = true;
+}
+
+template<size_t CUBE_SIZE>
+void RubikCubeScene<CUBE_SIZE>::UpdateDetailed(SceneCube &cube) {
+    size_t i = 0;
+    for(int face=0; face<NUM_FACES; ++face)
+        for(size_t row=0; row<CUBE_SIZE; ++row)
+            for(size_t col=0; col<CUBE_SIZE; ++col)
+                cube.face_element_nodes[i++]->getMaterial(0) = faces_materials[cube.model.GetFaceElement((FaceElement)face, row, col)];
+    cube.detailed_dirty = false;
+}
+
+template<size_t CUBE_SIZE>
+void RubikCubeScene<CUBE_SIZE>::UpdateTexture(size_t cube_id) {
+    SceneCube &cube = cubes[cube_id];
+    irr::core::dimension2du size(ATLAS_COLUMNS*CUBE_SIZE, ATLAS_ROWS*CUBE_SIZE);
+    irr::video::IImage *image = driver->createImage(irr::video::ECF_A8R8G8B8, size);
+
+    for(int face=0; face<NUM_FACES; ++face) {
+        size_t x0 = (face % ATLAS_COLUMNS) * CUBE_SIZE;
+        size_t y0 = (face / ATLAS_COLUMNS) * CUBE_SIZE;
+        for(size_t row=0; row<CUBE_SIZE; ++row)
+            for(size_t col=0; col<CUBE_SIZE; ++col)
+                image->setPixel(x0+col, y0+row, GetFaceColor(cube.model.GetFaceElement((FaceElement)face, row, col)));
+    }
+
+    if(cube.texture)
+        driver->removeTexture(cube.texture);
+    cube.texture = driver->addTexture(("cube_lod_" + std::to_string(cube_id)).c_str(), image);
+    cube.simplified->setMaterialTexture(0, cube.texture);
+    image->drop();
+    cube.texture_dirty = false;
+}
+
+template<size_t CUBE_SIZE>
+void RubikCubeScene<CUBE_SIZE>::UpdateVisibility() {
+    const irr::scene::SViewFrustum *frustum = camera->getViewFrustum();
+    irr::core::vector3df camera_position = camera->getAbsolutePosition();
+
+    num_visible = 0;
+    num_detailed = 0;
+    for(size_t i=0; i<cubes.size(); ++i) {
+        SceneCube &cube = cubes[i];
+        bool visible = IsBoxInFrustum(cube.bounding_box, *frustum);
+        bool detailed;
+
+        // Hidden parents skip registration of all their children
+        cube.root->setVisible(visible);
+        if(!visible)
+            continue;
+        ++num_visible;
+
+        detailed = camera_position.getDistanceFrom(cube.bounding_box.getCenter()) < lod_distance;
+        cube.detailed->setVisible(detailed);
+        cube.simplified->setVisible(!detailed);
+        if(detailed) {
+            ++num_detailed;
+            if(cube.detailed_dirty)
+                UpdateDetailed(cube);
+        } else if(cube.texture_dirty) {
+            UpdateTexture(i);
+        }
+    }
+}
+
+template<size_t CUBE_SIZE>
+RubikCubeScene<CUBE_SIZE>::RubikCubeScene(const std::wstring &window_title, size_t width, size_t height,
+                                          size_t num_cubes, float cube_length)
+    : cubes(num_cubes), lod_distance(8.0f*cube_length)
+{
+    size_t num_columns = (size_t)std::ceil(std::sqrt((double)num_cubes));
+    size_t num_rows = num_columns > 0 ? (num_cubes + num_columns-1) / num_columns : 0;
+    float spacing = 1.5f * cube_length;
+    float grid_size = spacing * (num_columns > num_rows ? num_columns : num_rows);
+
+    /* Create a device */
+    device = createDevice(irr::video::EDT_BURNINGSVIDEO,
+                          irr::core::dimension2d<uint32_t>(width, height),
+                          16, false, false, false, nullptr);
+    if(!device)
+        throw std::runtime_error("Error creating a device");
+    device->setWindowCaption(window_title.c_str());
+
+    /* Managers */
+    driver = device->getVideoDriver();
+    smgr = device->getSceneManager();
+    guienv = device->getGUIEnvironment();
+
+    /* Models */
+    for(int i=0; i<NUM_FACES; ++i)
+        faces_materials[i] = CreateFaceMaterial((FaceElement)i);
+
+    // Meshes are shared by all cubes
+    irr::core::dimension2d<float> element_dim = {cube_length / CUBE_SIZE, cube_length / CUBE_SIZE};
+    irr::scene::IMesh *face_element_mesh = smgr->getGeometryCreator()->createPlaneMesh(element_dim, irr::core::dimension2du(1, 1));
+    irr::scene::IMesh *simplified_mesh = CreateSimplifiedMesh(cube_length);
+    for(size_t i=0; i<num_cubes; ++i) {
+        float x = ((float)(i % num_columns) - 0.5f*(num_columns-1)) * spacing;
+        float y = (0.5f*(num_rows-1) - (float)(i / num_columns)) * spacing;
+        GenerateCube(cubes[i], irr::core::vector3df(x, y, 0.0f), cube_length, face_element_mesh, simplified_mesh);
+    }
+    face_element_mesh->drop();
+    simplified_mesh->drop();
+
+    /* Camera */
+    camera = smgr->addCameraSceneNodeMaya(0, -1500.0f, grid_size, grid_size, -1, grid_size);
+    camera->setFarValue(10.0f * grid_size + 100.0f);
+
+    /* Frame statistics overlay */
+    stats_text = guienv->addStaticText(L"", irr::core::rect<int32_t>(10,10,330,85), true);
+    stats_text->setWordWrap(true);
+    stats_text->setBackgroundColor(irr::video::SColor(160, 0, 0, 0));
+    stats_text->setOverrideColor(irr::video::SColor(255, 255, 255, 255));
+
+    last_frame_time = get_monotonic_time();
+}
+
+template<size_t CUBE_SIZE>
+RubikCubeScene<CUBE_SIZE>::~RubikCubeScene() {
+    device->drop();
+}
+
+template<size_t CUBE_SIZE>
+size_t RubikCubeScene<CUBE_SIZE>::GetNumCubes() const {
+    return cubes.size();
+}
+
+template<size_t CUBE_SIZE>
+const RubikCube<int, CUBE_SIZE>& RubikCubeScene<CUBE_SIZE>::GetCube(size_t cube_id) const {
+    assert(cube_id < cubes.size());
+    return cubes[cube_id].model;
+}
+
+template<size_t CUBE_SIZE>
+void RubikCubeScene<CUBE_SIZE>::ApplyMove(size_t cube_id, const Move &move) {
+    assert(cube_id < cubes.size());
+    SceneCube &cube = cubes[cube_id];
+    cube.model.RotateFace(move);
+    cube.detailed_dirty = true;
+    cube.texture_dirty = true;
+}
+
+template<size_t CUBE_SIZE>
+void RubikCubeScene<CUBE_SIZE>::SetLODDistance(float distance) {
+    lod_distance = distance;
+}
+
+template<size_t CUBE_SIZE>
+bool RubikCubeScene<CUBE_SIZE>::ShouldContinue() const {
+    return device->run();
+}
+
+template<size_t CUBE_SIZE>
+void RubikCubeScene<CUBE_SIZE>::UpdateFrame() {
+    double current_time = get_monotonic_time();
+    double frame_duration = current_time - last_frame_time;
+    last_frame_time = current_time;
+
+    {
+        SectionTimer timer(frame_stats, SECTION_UPDATE);
+        UpdateVisibility();
+    }
+
+    {
+        SectionTimer timer(frame_stats, SECTION_RENDER);
+        driver->beginScene(irr::video::ECBF_COLOR | irr::video::ECBF_DEPTH, irr::video::SColor(255,100,101,140));
+        smgr->drawAll();
+        guienv->drawAll();
+        driver->endScene();
+    }
+
+    irr::io::IAttributes *parameters = smgr->getParameters();
+    size_t draw_calls = parameters->getAttributeAsInt("drawn_solid") +
+                        parameters->getAttributeAsInt("drawn_transparent") +
+                        parameters->getAttributeAsInt("drawn_transparent_effect");
+    frame_stats.EndFrame(frame_duration, draw_calls, driver->getPrimitiveCountDrawn());
+    if(current_time - last_stats_refresh >= STATS_REFRESH_PERIOD) {
+        std::wstring text = frame_stats.ToString();
+        text += L"\nCubes: " + std::to_wstring(cubes.size()) + L", visible: " + std::to_wstring(num_visible) +
+                L", detailed: " + std::to_wstring(num_detailed);
+        stats_text->setText(text.c_str());
+        last_stats_refresh = current_time;
+    }
+}
+
+#endif
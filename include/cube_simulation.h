@@ -0,0 +1,215 @@
+#ifndef __RUBIK_CUBE_SIMULATION_H__
+#define __RUBIK_CUBE_SIMULATION_H__
+
+#include <rubik.h>
+#include <lock_free_queue.h>
+#include <triple_buffer.h>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <queue>
+#include <cstdint>
+
+
+/**
+  * @brief State of a rubik cube at some point of the simulation
+  */
+template<size_t CUBE_SIZE>
+struct CubeSnapshot {
+    static constexpr size_t NUM_FACELETS = 6*CUBE_SIZE*CUBE_SIZE;
+
+    // Ordered by face, row and column
+    std::array<FaceElement, NUM_FACELETS> facelets;
+    // Number of moves applied since the simulation started
+    uint64_t num_moves;
+
+    CubeSnapshot()
+        : num_moves(0)
+    {
+        for(size_t i=0; i<NUM_FACELETS; ++i)
+            facelets[i] = (FaceElement)(i / (CUBE_SIZE*CUBE_SIZE));
+    }
+
+    /**
+      * @brief Gets the 'color' of the face element selected
+      * @param face Specifies the face
+      * @param row Specifies the row of the face
+      * @param col Specifies the column of the face
+      */
+    FaceElement GetFaceElement(FaceElement face, size_t row, size_t col) const {
+        assert(face >= 0 && face < INVALID);
+        assert(row < CUBE_SIZE && col < CUBE_SIZE);
+        return facelets[((size_t)face*CUBE_SIZE + row)*CUBE_SIZE + col];
+    }
+};
+
+
+/**
+  * @brief Owns a rubik cube model which is updated in its own thread
+  *
+  * Any thread can push moves. They are applied in the simulation thread, which publishes
+  * a snapshot of the model after each batch of moves. Reading the last snapshot never blocks.
+  */
+template<size_t CUBE_SIZE>
+class CubeSimulation {
+private:
+    static constexpr size_t QUEUE_CAPACITY = 1024;
+    // Time to sleep when there are no pending moves
+    static constexpr std::chrono::microseconds IDLE_SLEEP = std::chrono::microseconds(500);
+
+    // Only accessed from simulation thread
+    RubikCube<int, CUBE_SIZE> model;
+    uint64_t num_moves;
+
+    LockFreeQueue<Move, QUEUE_CAPACITY> pending_moves;
+    // States to load, in order. Each one is marked in 'pending_moves' by a move with INVALID face
+    std::queue<CubeSnapshot<CUBE_SIZE>> pending_states;
+    std::mutex states_mutex;
+    TripleBuffer<CubeSnapshot<CUBE_SIZE>> snapshots;
+    std::atomic<bool> running;
+    std::thread thread;
+
+protected:
+    /**
+      * @brief Main loop of simulation thread
+      */
+    void Run();
+
+    /**
+      * @brief Copies current model into the write snapshot and publishes it
+      */
+    void PublishSnapshot();
+
+public:
+    /**
+      * @brief Starts the simulation thread with a solved cube
+      */
+    CubeSimulation();
+
+    /**
+      * @brief Stops the simulation thread. Pending moves are discarded
+      */
+    ~CubeSimulation();
+
+    CubeSimulation(const CubeSimulation&) = delete;
+    CubeSimulation& operator=(const CubeSimulation&) = delete;
+
+    /**
+      * @brief Enqueues a move. It never blocks, and it can be called from any thread
+      * @param move Move to apply to the model
+      * @return False if the queue is full and the move was discarded. True in other case
+      */
+    bool PushMove(const Move &move);
+
+    /**
+      * @brief Enqueues a state which replaces the model, after the moves pushed before it. Used to seek. It
+      *        takes a lock, so it shall not be used in hot paths
+      * @param state Face elements and number of moves of the new model
+      * @return False if the queue is full and the state was discarded. True in other case
+      */
+    bool PushState(const CubeSnapshot<CUBE_SIZE> &state);
+
+    /**
+      * @brief Fetches the last published snapshot
+      * @pre Called always from the same thread (render thread)
+      * @return True if there is a new snapshot since last call
+      */
+    bool UpdateSnapshot();
+
+    /**
+      * @brief Returns the snapshot fetched by last call to 'UpdateSnapshot'
+      * @pre Called from the same thread as 'UpdateSnapshot'
+      */
+    const CubeSnapshot<CUBE_SIZE>& GetSnapshot() const;
+};
+
+
+
+
+
+
+/******* IMPLEMENTATION ********/
+template<size_t CUBE_SIZE>
+CubeSimulation<CUBE_SIZE>::CubeSimulation()
+    : num_moves(0), running(true)
+{
+    thread = std::thread(&CubeSimulation<CUBE_SIZE>::Run, this);
+}
+
+template<size_t CUBE_SIZE>
+CubeSimulation<CUBE_SIZE>::~CubeSimulation() {
+    running.store(false, std::memory_order_relaxed);
+    thread.join();
+}
+
+template<size_t CUBE_SIZE>
+void CubeSimulation<CUBE_SIZE>::Run() {
+    Move move;
+    while(running.load(std::memory_order_relaxed)) {
+        bool updated = false;
+
+        // Drain the queue, so a burst of moves produces only one snapshot
+        while(pending_moves.Pop(move)) {
+            if(move.face == INVALID) {
+                std::lock_guard<std::mutex> lock(states_mutex);
+                const CubeSnapshot<CUBE_SIZE> &state = pending_states.front();
+                for(int face=0; face<INVALID; ++face)
+                    for(size_t row=0; row<CUBE_SIZE; ++row)
+                        for(size_t col=0; col<CUBE_SIZE; ++col)
+                            model.SetFaceElement((FaceElement)face, row, col, state.GetFaceElement((FaceElement)face, row, col));
+                num_moves = state.num_moves;
+                pending_states.pop();
+            } else {
+                model.RotateFace(move);
+                ++num_moves;
+            }
+            updated = true;
+        }
+
+        if(updated)
+            PublishSnapshot();
+        else
+            std::this_thread::sleep_for(IDLE_SLEEP);
+    }
+}
+
+template<size_t CUBE_SIZE>
+void CubeSimulation<CUBE_SIZE>::PublishSnapshot() {
+    CubeSnapshot<CUBE_SIZE> &snapshot = snapshots.GetWriteBuffer();
+    size_t i = 0;
+    for(size_t face=0; face<model.GetNumFaces(); ++face)
+        for(size_t row=0; row<CUBE_SIZE; ++row)
+            for(size_t col=0; col<CUBE_SIZE; ++col)
+                snapshot.facelets[i++] = model.GetFaceElement((FaceElement)face, row, col);
+    snapshot.num_moves = num_moves;
+    snapshots.Publish();
+}
+
+template<size_t CUBE_SIZE>
+bool CubeSimulation<CUBE_SIZE>::PushMove(const Move &move) {
+    return pending_moves.Push(move);
+}
+
+template<size_t CUBE_SIZE>
+bool CubeSimulation<CUBE_SIZE>::PushState(const CubeSnapshot<CUBE_SIZE> &state) {
+    // The marker is pushed while holding the lock, so the simulation thread waits for the state if it pops
+    // the marker first
+    std::lock_guard<std::mutex> lock(states_mutex);
+    if(!pending_moves.Push({INVALID, CLOCKWISE, 0}))
+        return false;
+    pending_states.push(state);
+    return true;
+}
+
+template<size_t CUBE_SIZE>
+bool CubeSimulation<CUBE_SIZE>::UpdateSnapshot() {
+    return snapshots.Update();
+}
+
+template<size_t CUBE_SIZE>
+const CubeSnapshot<CUBE_SIZE>& CubeSimulation<CUBE_SIZE>::GetSnapshot() const {
+    return snapshots.GetReadBuffer();
+}
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef __RUBIK_CUBE_TYPES_H__
+#define __RUBIK_CUBE_TYPES_H__
+
+#include <cstddef>
+
+/*    Clockwise to rotate face    */
+typedef enum { 
+    CLOCKWISE = 0, COUNTERCLOCKWISE 
+} Clockwise;
+
+/*    Face of the cube. Total: 6    */
+typedef enum
+    { 
+     FRONT = 0, // ORDER IS PART OF THE INTERFACE. DON'T CHANGE IT
+     BACK, 
+     LEFT, 
+     RIGHT, 
+     TOP, 
+     BOTTOM,
+     INVALID
+    } FaceElement;
+
+/*    Quarter turn of a layer. Same arguments as RubikCube::RotateFace    */
+struct Move {
+    FaceElement face;
+    Clockwise clockwise;
+    size_t depth;
+};
+
+#endif
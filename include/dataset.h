@@ -0,0 +1,233 @@
+#ifndef __RUBIK_DATASET_H__
+#define __RUBIK_DATASET_H__
+
+#include <rubik.h>
+#include <move_generator.h>
+#include <move_table.h>
+#include <random_state.h>
+#include <state_file.h>
+#include <thread_pool.h>
+#include <tools.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <future>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+/**
+  * Datasets of labeled states, to train value networks. Each sample is a state reached by a random scramble,
+  * encoded as a tensor of its face elements, and labeled with the length of the scramble: an upper bound of
+  * its distance to the solved state. Scrambles are random walks over the moves of SolveIDDFS (quarter turns)
+  * which skip trivially redundant sequences (see MoveGenerator), so labels of short scrambles are close to
+  * the distance. Lengths are drawn from a distribution of weights, so datasets can be balanced by length.
+  *
+  * Samples are generated in blocks by the threads of a pool: block i uses RandomStream(seed, i), so samples
+  * only depend on the seed and the cube size, not on the encoding or the number of threads. They are written in
+  * order to shards, which are state files (see state_file.h) with a "state" column of tensors (COLUMN_BYTES) and
+  * a "scramble_length" column (COLUMN_UINT8), since labels are not exact distances. Shards are written as blocks
+  * arrive, so only a few blocks per thread and the buffers of StateFileWriter are kept in memory, whatever the
+  * shard size is.
+  */
+
+/*    Encodings of the face elements of a state    */
+typedef enum {
+    COMPACT_TENSOR = 0, // A byte per face element, with its color
+    ONE_HOT_TENSOR      // 6 bytes per face element, one per color: 1 for its color, 0 for the others
+} TensorEncoding;
+
+/*    Samples generated by each task, unless their one-hot tensors take more than DATASET_BLOCK_BYTES    */
+const size_t DATASET_BLOCK = 16384;
+const size_t DATASET_BLOCK_BYTES = 4 << 20;
+
+/*    Blocks in flight per thread. Blocks are written in order, so this bounds buffered samples    */
+const size_t DATASET_BLOCKS_PER_THREAD = 4;
+
+/*    Parameters of a dataset    */
+struct DatasetOptions {
+    std::string prefix;                 // Shards are written as <prefix>-<index> (see GetShardFilename)
+    uint64_t seed = 0;
+    size_t num_samples = 0;
+    size_t shard_size = 1 << 20;        // Samples of each shard. The last one may have less
+    TensorEncoding encoding = COMPACT_TENSOR;
+    std::vector<double> depth_weights;  // Relative frequency of each scramble length, from 0 quarter turns
+};
+
+/*    Statistics of the generation of a dataset    */
+struct DatasetStats {
+    size_t num_samples = 0;
+    size_t num_shards = 0;
+    size_t tensor_size = 0; // Bytes of each tensor
+    double latency = 0.0;   // Seconds
+};
+
+/**
+  * @brief Returns bytes of the tensor of a state
+  */
+size_t GetTensorSize(TensorEncoding encoding, size_t cube_size);
+
+/**
+  * @brief Returns the path of a shard: the prefix, then '-', and the index with 5 digits at least
+  */
+std::string GetShardFilename(const std::string &prefix, size_t shard);
+
+/**
+  * @brief Encodes the state a permutation leaves a solved cube in
+  * @param tensor Output buffer of GetTensorSize(encoding, CUBE_SIZE) bytes
+  */
+template<size_t CUBE_SIZE>
+void EncodeTensor(const FaceletPermutation<CUBE_SIZE> &permutation, TensorEncoding encoding, uint8_t *tensor);
+
+/**
+  * @brief Generates a block of samples
+  * @param depths Cumulative weights of the scramble lengths, from 0 quarter turns
+  * @param tensors Output buffer of num_samples tensors
+  * @param labels Output buffer of num_samples scramble lengths
+  */
+template<size_t CUBE_SIZE>
+void GenerateSamples(const DatasetOptions &options, const std::vector<double> &depths, size_t block,
+                     size_t num_samples, uint8_t *tensors, uint8_t *labels);
+
+/**
+  * @brief Generates a dataset and writes its shards
+  * @param pool Threads which generate the blocks
+  * @return Statistics of the generation
+  * @throw std::invalid_argument if there are no weights, a weight is negative, all of them are zero, or there
+  *        are more than 256 of them (labels are bytes), or the shard size is zero
+  * @throw std::runtime_error if a shard could not be written
+  */
+template<size_t CUBE_SIZE>
+DatasetStats WriteDataset(const DatasetOptions &options, ThreadPool &pool);
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+template<size_t CUBE_SIZE>
+void EncodeTensor(const FaceletPermutation<CUBE_SIZE> &permutation, TensorEncoding encoding, uint8_t *tensor) {
+    const size_t num_facelets = FaceletPermutation<CUBE_SIZE>::NUM_FACELETS;
+    // Face elements of the solved cube have the color of their face
+    if(encoding == COMPACT_TENSOR) {
+        for(size_t i=0; i<num_facelets; ++i)
+            tensor[i] = permutation.GetSource(i) / (CUBE_SIZE*CUBE_SIZE);
+        return;
+    }
+    std::fill(tensor, tensor + 6*num_facelets, 0);
+    for(size_t i=0; i<num_facelets; ++i)
+        tensor[6*i + permutation.GetSource(i) / (CUBE_SIZE*CUBE_SIZE)] = 1;
+}
+
+template<size_t CUBE_SIZE>
+void GenerateSamples(const DatasetOptions &options, const std::vector<double> &depths, size_t block,
+                     size_t num_samples, uint8_t *tensors, uint8_t *labels) {
+    static const MoveGenerator<CUBE_SIZE> generator(QUARTER_TURN_METRIC);
+    const MoveTable<CUBE_SIZE> &table = MoveTable<CUBE_SIZE>::Get();
+    const size_t tensor_size = GetTensorSize(options.encoding, CUBE_SIZE);
+    RandomStream random(options.seed, block);
+
+    for(size_t i=0; i<num_samples; ++i) {
+        // Uniform value in [0, total weight), with the 53 bits of a double
+        double value = (random.Next() >> 11) * 0x1p-53 * depths.back();
+        size_t depth = std::upper_bound(depths.begin(), depths.end(), value) - depths.begin();
+        FaceletPermutation<CUBE_SIZE> permutation;
+        size_t state = MoveGenerator<CUBE_SIZE>::START;
+
+        depth = std::min(depth, depths.size() - 1);
+        for(size_t d=0; d<depth; ++d) {
+            const std::vector<typename MoveGenerator<CUBE_SIZE>::Successor> &successors = generator.GetSuccessors(state);
+            const typename MoveGenerator<CUBE_SIZE>::Successor &successor = successors[random.NextBelow(successors.size())];
+            const SearchMove &move = generator.GetMove(successor.move);
+            for(size_t turn=0; turn<move.num_quarter_turns; ++turn)
+                table.ApplyMove(move.move, permutation);
+            state = successor.state;
+        }
+        EncodeTensor(permutation, options.encoding, tensors + i*tensor_size);
+        labels[i] = depth;
+    }
+}
+
+template<size_t CUBE_SIZE>
+DatasetStats WriteDataset(const DatasetOptions &options, ThreadPool &pool) {
+    // Samples of a block: tensors, then labels
+    typedef std::pair<std::vector<uint8_t>, std::vector<uint8_t>> Block;
+    const size_t tensor_size = GetTensorSize(options.encoding, CUBE_SIZE);
+    // Blocks have the size of the largest tensors, so both encodings give the same samples
+    const size_t block_size = std::max<size_t>(1, std::min(DATASET_BLOCK, DATASET_BLOCK_BYTES / GetTensorSize(ONE_HOT_TENSOR, CUBE_SIZE)));
+    const size_t num_blocks = (options.num_samples + block_size - 1) / block_size;
+    std::vector<double> depths;
+    std::deque<std::future<Block>> pending;
+    std::unique_ptr<StateFileWriter> writer;
+    size_t state_column = 0;
+    size_t length_column = 0;
+    size_t shard_samples = 0;
+    DatasetStats stats;
+    double start = get_monotonic_time();
+    double total = 0.0;
+
+    if(options.depth_weights.empty() || options.depth_weights.size() > 256 || options.shard_size == 0)
+        throw std::invalid_argument("Invalid dataset options");
+    for(size_t i=0; i<options.depth_weights.size(); ++i) {
+        if(!(options.depth_weights[i] >= 0.0))
+            throw std::invalid_argument("Weights of the scramble lengths can't be negative");
+        total += options.depth_weights[i];
+        depths.push_back(total);
+    }
+    if(total <= 0.0)
+        throw std::invalid_argument("Some scramble length needs a positive weight");
+    stats.tensor_size = tensor_size;
+
+    try {
+        for(size_t block=0; block<num_blocks || !pending.empty(); ++block) {
+            if(block < num_blocks) {
+                size_t num_samples = std::min(block_size, options.num_samples - block*block_size);
+                // Tasks own their parameters, since they may still run after an error leaves this function
+                pending.push_back(pool.Submit([options, depths, tensor_size, block, num_samples]() {
+                    Block samples(std::vector<uint8_t>(num_samples * tensor_size), std::vector<uint8_t>(num_samples));
+                    GenerateSamples<CUBE_SIZE>(options, depths, block, num_samples, samples.first.data(), samples.second.data());
+                    return samples;
+                }));
+                if(pending.size() < DATASET_BLOCKS_PER_THREAD * pool.GetNumThreads())
+                    continue;
+            }
+
+            Block samples = pending.front().get();
+            pending.pop_front();
+            for(size_t offset=0; offset<samples.second.size();) {
+                if(!writer) {
+                    size_t num_records = std::min(options.shard_size, options.num_samples - stats.num_samples);
+                    writer.reset(new StateFileWriter(GetShardFilename(options.prefix, stats.num_shards), CUBE_SIZE, num_records));
+                    state_column = writer->AddColumn("state", COLUMN_BYTES, tensor_size);
+                    length_column = writer->AddColumn("scramble_length", COLUMN_UINT8);
+                    shard_samples = 0;
+                    ++stats.num_shards;
+                }
+                size_t count = std::min(samples.second.size() - offset, options.shard_size - shard_samples);
+                writer->Append(state_column, samples.first.data() + offset*tensor_size, count);
+                writer->Append(length_column, samples.second.data() + offset, count);
+                offset += count;
+                shard_samples += count;
+                stats.num_samples += count;
+                if(shard_samples == options.shard_size) {
+                    writer->Close();
+                    writer.reset();
+                }
+            }
+        }
+        if(writer)
+            writer->Close();
+    } catch(...) {
+        // Blocks in flight are waited for, so they don't keep the threads of the pool busy after the error
+        for(size_t i=0; i<pending.size(); ++i)
+            pending[i].wait();
+        throw;
+    }
+
+    stats.latency = get_monotonic_time() - start;
+    return stats;
+}
+
+#endif
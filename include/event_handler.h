@@ -2,13 +2,47 @@
 #define __RUBIK_EVENT_HANDLER_H__
 
 #include <irrlicht.h>
+#include <array>
+#include <cstddef>
+
+/*    Input event saved by RubikCubeEventHandler    */
+struct InputEvent {
+    typedef enum {
+        LEFT_PRESSED = 0,
+        LEFT_RELEASED,
+        RIGHT_PRESSED,
+        RIGHT_RELEASED,
+        MOUSE_MOVED
+    } Type;
+    
+    Type type;
+    // Cursor position when the event was produced
+    irr::core::position2di cursor_position;
+    // Monotonic time when the event was received, in seconds (see get_monotonic_time)
+    double timestamp;
+};
 
 class RubikCubeEventHandler : public irr::IEventReceiver {
 private:
+    // Maximum number of events stored between two calls to PopEvent
+    static const size_t EVENT_BUFFER_SIZE = 256;
+    
     irr::core::position2di _cursor_position;
     bool _left_mouse_pressed;
     bool _right_mouse_pressed;
     
+    // Ring buffer of events which have not been read yet
+    std::array<InputEvent, EVENT_BUFFER_SIZE> _events;
+    size_t _first_event;
+    size_t _num_events;
+    
+    /**
+      * @brief Appends an event to the buffer. If buffer is full, consecutive mouse moves are
+      *        merged, or the oldest event is discarded
+      * @param type Type of the event
+      */
+    void PushEvent(InputEvent::Type type);
+    
 protected:
     /**
       * @brief A callback method called when an event is produced. More info
@@ -22,7 +56,9 @@ public:
       */
     RubikCubeEventHandler()
         : _left_mouse_pressed(false),
-          _right_mouse_pressed(false)
+          _right_mouse_pressed(false),
+          _first_event(0),
+          _num_events(0)
     {
         
     }
@@ -51,6 +87,20 @@ public:
     const irr::core::position2di& GetCursorPosition() const {
         return _cursor_position;
     }
+    
+    /**
+      * @brief Extracts the oldest event which has not been read yet
+      * @param event Extracted event. It is valid only if returned value is true
+      * @return False if there are no pending events. True in other case
+      */
+    bool PopEvent(InputEvent &event);
+    
+    /**
+      * @brief Returns number of events which have not been read yet
+      */
+    size_t GetNumPendingEvents() const {
+        return _num_events;
+    }
 };
 
 #endif
@@ -0,0 +1,61 @@
+#ifndef __RUBIK_FRAME_SCHEDULER_H__
+#define __RUBIK_FRAME_SCHEDULER_H__
+
+#include <cstddef>
+
+/**
+  * @brief Splits elapsed time in fixed steps, so simulation doesn't depend on frame duration
+  *
+  * Usage, once per frame:
+  *     scheduler.BeginFrame();
+  *     while(scheduler.NextStep())
+  *         Update(scheduler.GetStep());
+  *     Render(scheduler.GetInterpolation());
+  */
+class FrameScheduler {
+private:
+    double step;
+    double max_frame_duration;
+    double accumulator;
+    double last_time;
+    double frame_duration;
+
+public:
+    /**
+      * @brief Initializes the scheduler. Time starts counting now
+      * @pre step and max_frame_duration are positive
+      * @param step Duration of each update step, in seconds
+      * @param max_frame_duration Longer frames are clamped to this duration, so a stall doesn't
+      *        produce a burst of updates
+      */
+    FrameScheduler(double step, double max_frame_duration = 0.25);
+
+    /**
+      * @brief Reads the clock and accumulates time elapsed since previous frame
+      */
+    void BeginFrame();
+
+    /**
+      * @brief Consumes one step of accumulated time
+      * @return True if an update step shall be performed. False if there is not enough accumulated time
+      */
+    bool NextStep();
+
+    /**
+      * @brief Returns duration of update steps, in seconds
+      */
+    double GetStep() const;
+
+    /**
+      * @brief Returns how far is current frame between last update step and the next one
+      * @return Value in range [0, 1)
+      */
+    double GetInterpolation() const;
+
+    /**
+      * @brief Returns real duration of last frame, in seconds (not clamped)
+      */
+    double GetFrameDuration() const;
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef __RUBIK_FRAME_STATS_H__
+#define __RUBIK_FRAME_STATS_H__
+
+#include <array>
+#include <string>
+#include <cstddef>
+
+/*    Parts of a frame whose duration is measured    */
+typedef enum {
+    SECTION_UPDATE = 0, // State machine and model updates, picking excluded
+    SECTION_PICKING,    // Ray casting to find pointed face element
+    SECTION_RENDER,     // Scene and GUI drawing
+    NUM_SECTIONS
+} FrameSection;
+
+/**
+  * @brief Keeps durations of last frames to show performance statistics
+  */
+class FrameStats {
+private:
+    static const size_t HISTORY_SIZE = 256;
+
+    std::array<double, HISTORY_SIZE> frame_times;
+    std::array<std::array<double, HISTORY_SIZE>, NUM_SECTIONS> section_times;
+    // Sections measured in the frame that is being processed
+    std::array<double, NUM_SECTIONS> current_sections;
+    size_t num_frames;
+    size_t next_frame;
+    size_t draw_calls;
+    size_t primitives;
+
+public:
+    /**
+      * @brief Initializes empty statistics
+      */
+    FrameStats();
+
+    /**
+      * @brief Adds time spent in some part of current frame. It can be called several times per frame
+      * @param section Measured part of the frame
+      * @param duration Time spent, in seconds
+      */
+    void AddSectionTime(FrameSection section, double duration);
+
+    /**
+      * @brief Returns time accumulated in a section during current frame, in seconds
+      */
+    double GetSectionTime(FrameSection section) const;
+
+    /**
+      * @brief Closes current frame and saves its measures
+      * @param duration Total duration of the frame, in seconds
+      * @param draw_calls Number of draw calls of the frame
+      * @param primitives Number of primitives drawn in the frame
+      */
+    void EndFrame(double duration, size_t draw_calls, size_t primitives);
+
+    /**
+      * @brief Returns average frames per second of the saved frames
+      */
+    double GetFPS() const;
+
+    /**
+      * @brief Returns a percentile of saved frame times
+      * @pre percentile in range [0, 100]
+      * @param percentile Percentile to calculate. For example, 50 returns the median
+      * @return Frame time, in seconds. Zero if there are no saved frames
+      */
+    double GetFrameTimePercentile(double percentile) const;
+
+    /**
+      * @brief Returns average time spent in a section per frame, in seconds
+      */
+    double GetAverageSectionTime(FrameSection section) const;
+
+    /**
+      * @brief Formats statistics as multi-line text, suitable for an overlay
+      */
+    std::wstring ToString() const;
+};
+
+
+/**
+  * @brief Measures time between its construction and its destruction, and adds it to a section
+  */
+class SectionTimer {
+private:
+    FrameStats &stats;
+    FrameSection section;
+    double start;
+
+public:
+    SectionTimer(FrameStats &stats, FrameSection section);
+    ~SectionTimer();
+};
+
+#endif
@@ -1,20 +1,27 @@
+#ifndef __RUBIK_GRAPHICAL_CUBE_H__
+#define __RUBIK_GRAPHICAL_CUBE_H__
+
 #include <irrlicht.h>
 #include <stdexcept>
 #include <string>
 #include <rubik.h>
+#include <cube_simulation.h>
+#include <move_history.h>
 #include <event_handler.h>
 #include <irrlicht_tools.h>
+#include <cube_geometry.h>
+#include <frame_scheduler.h>
+#include <frame_stats.h>
 #include <array>
 #include <unordered_map>
+#include <cstdio>
 
 
-/**
-  * @brief Returns normalized rotation axis of a face
-  * @pre face parameter shall not be INVALID
-  * @param face Face of rotation
-  * @return Normalized 3D vector representing rotation axis of a face
-  */
-irr::core::vector3df GetRotationAxis(FaceElement face);
+/*    How frames are presented    */
+typedef enum {
+    WINDOWED = 0, // Frames are shown in a window
+    HEADLESS      // No display is needed. Frames can only be saved to files
+} RenderMode;
 
 
 template<size_t CUBE_SIZE>
@@ -124,6 +131,11 @@ private:
             return inc_angle * frame_duration;
         }
         
+        // Angle between previous and current update steps. alpha in range [0, 1]
+        float GetInterpolatedAngle(float alpha) const {
+            return prev_angle + alpha * (angle - prev_angle);
+        }
+        
         bool NextAnimationStep(float frame_duration) {
             bool continue_animation;
             prev_angle = angle;
@@ -141,9 +153,21 @@ private:
     };
     
     static constexpr double CAMERA_DISTANCE = 2.0;
+    // Duration of state machine updates, in seconds
+    static constexpr double UPDATE_STEP = 1.0 / 120.0;
+    // Period of overlay refresh, in seconds
+    static constexpr double STATS_REFRESH_PERIOD = 0.25;
+    
+    double frame_duration = UPDATE_STEP;
+    FrameScheduler scheduler = FrameScheduler(UPDATE_STEP);
+    FrameStats frame_stats;
+    double last_stats_refresh = 0.0;
+    irr::gui::IGUIStaticText *stats_text;
     
-    double frame_duration = 0.0f;
-    double last_time = 0.0f;
+    RenderMode render_mode;
+    // Destination of console device output in headless mode
+    FILE *console_output = nullptr;
+    irr::video::SColor background_color = irr::video::SColor(255,100,101,140);
     
     irr::IrrlichtDevice *device;
     irr::video::IVideoDriver* driver;
@@ -153,6 +177,15 @@ private:
     
     State curr_state;
     StateVariables curr_state_variables;
+    // Left button state after last processed event
+    bool left_pressed = false;
+    
+    // Model shared with other threads (solvers, scripts...). Base class only tracks scene nodes
+    CubeSimulation<CUBE_SIZE> simulation;
+    
+    // Moves committed in this window, timed from its creation
+    MoveHistory<CUBE_SIZE> history;
+    double session_start = get_monotonic_time();
     
     irr::scene::ICameraSceneNode *camera;
     float camera_pitch = 0.0f;
@@ -198,10 +231,28 @@ protected:
     StateVariables ReadState() const;
     
     /**
-      * @brief It reads player events and it acts on them
+      * @brief It reads all player events buffered since last call and it acts on them, in order
       */
     void UpdateEvents();
     
+    /**
+      * @brief Runs state machine with one input event
+      * @param event Event read from event handler
+      */
+    void ProcessEvent(const InputEvent &event);
+    
+    /**
+      * @brief Advances states which don't depend on input (animations) by one update step
+      */
+    void UpdateAnimation();
+    
+    /**
+      * @brief Performs actions of the next state and makes it the current one
+      * @param next_state State reached by the state machine
+      * @param next State variables of next state
+      */
+    void ApplyTransition(State next_state, StateVariables &next);
+    
     /**
       * @brief Updates camera
       * @param next State variables of current frame
@@ -226,6 +277,36 @@ protected:
       */
     void UpdateInternalCube(StateVariables &next);
     
+    /**
+      * @brief Applies a move to the base class and to the simulation, once its layer has been rotated
+      * @param move Move whose scene nodes are already in their final position
+      * @param record Adds the move to the history. Undo and redo don't record their moves
+      */
+    void CommitMove(const Move &move, bool record = true);
+    
+    /**
+      * @brief Rotates a layer instantly and commits it without recording it (used by undo and redo)
+      */
+    void ApplyHistoryMove(const Move &move);
+    
+    /**
+      * @brief Colors face elements as stated by a snapshot of the simulation
+      * @pre No layer is being rotated
+      * @param snapshot Last snapshot published by simulation
+      */
+    void ApplySnapshot(const CubeSnapshot<CUBE_SIZE> &snapshot);
+    
+    /**
+      * @brief Draws scene and GUI. Animated layer is drawn between last two update steps
+      * @param alpha Interpolation factor between last two update steps, in range [0, 1]
+      */
+    void DrawScene(float alpha);
+    
+    /**
+      * @brief Closes frame statistics and refreshes the overlay periodically
+      */
+    void UpdateStats();
+    
     /**
       * @brief Returns face element which is in 'pos' position (screen coordinates), or invalid if any face is pointed
       * @param pos Position, in screen space
@@ -264,10 +345,12 @@ public:
     /**
       * @brief Creates a graphical environment which will show a rubik cube 
       * @param window_title Title of the window
-      * @param width Width of the window, in pixels
-      * @param height Height of the window, in pixels
+      * @param width Width of the window (or frames, in headless mode), in pixels
+      * @param height Height of the window (or frames, in headless mode), in pixels
+      * @param mode WINDOWED opens a window. HEADLESS renders with the software renderer without any display
       */
-    GraphicalRubikCube(const std::wstring &window_title, size_t width, size_t height, float cube_length);
+    GraphicalRubikCube(const std::wstring &window_title, size_t width, size_t height, float cube_length,
+                       RenderMode mode = WINDOWED);
     
     /**
       * @brief It frees resources 
@@ -284,66 +367,110 @@ public:
       * @brief Draws a new frame
       */
     void UpdateFrame();
+    
+    /**
+      * @brief Enqueues a move to be applied to the cube. It never blocks, and it can be called from any thread
+      * @param move Move to apply
+      * @return False if the move could not be enqueued. True in other case
+      */
+    bool PushMove(const Move &move);
+    
+    /**
+      * @brief Points the camera to the cube from the given angles
+      * @param pitch Rotation around vertical axis, in radians
+      * @param yaw Elevation, in radians. It is clamped to (-pi/2, pi/2)
+      */
+    void SetCameraOrientation(float pitch, float yaw);
+    
+    /**
+      * @brief Rotates a layer in several steps, so intermediate frames can be captured
+      * @pre No layer is being rotated by the user
+      * @param move Move to apply
+      * @param num_frames Number of intermediate steps. Zero applies the move instantly
+      * @param on_frame Callable object called after each step. Parameters: (frame index)
+      */
+    template<typename FrameCallback>
+    void AnimateMove(const Move &move, size_t num_frames, FrameCallback on_frame);
+    
+    /**
+      * @brief Applies a move instantly
+      * @pre No layer is being rotated by the user
+      * @param move Move to apply
+      */
+    void ApplyMove(const Move &move);
+    
+    /**
+      * @brief Undoes the last move of the history instantly
+      * @pre No layer is being rotated by the user
+      * @return False if there is no move to undo
+      */
+    bool Undo();
+    
+    /**
+      * @brief Applies again the last undone move instantly
+      * @pre No layer is being rotated by the user
+      * @return False if there is no move to redo
+      */
+    bool Redo();
+    
+    /**
+      * @brief Shows the state after some moves of the history. Moves after it can be redone
+      * @pre No layer is being rotated by the user. position <= GetHistory().GetNumMoves()
+      * @param position Number of moves. It costs at most a snapshot interval of move applications
+      */
+    void SeekHistory(size_t position);
+    
+    /**
+      * @brief Returns moves committed since the cube was created, or since the last loaded session
+      */
+    const MoveHistory<CUBE_SIZE>& GetHistory() const;
+    
+    /**
+      * @brief Replaces the history with a session recording and shows its last state
+      * @pre No layer is being rotated by the user
+      * @throw std::runtime_error if the file is not a valid session of this cube size
+      */
+    void LoadSession(const std::string &filename);
+    
+    /**
+      * @brief Colors face elements without rotating layers. History is not changed
+      * @pre No layer is being rotated by the user
+      * @param facelets Face elements, in the order of FaceletsToString
+      * @param num_moves Number of moves reported by the simulation for the new state
+      */
+    void SetState(const FaceElement *facelets, uint64_t num_moves);
+    
+    /**
+      * @brief Renders current scene and saves it to an image file
+      * @param filename Path of the image. Format is selected by its extension (png, ppm, bmp...)
+      * @return Time spent rendering the frame, in seconds. Writing the file is not included
+      * @throw std::runtime_error if the frame could not be captured or written
+      */
+    double RenderToFile(const std::string &filename);
+    
+    /**
+      * @brief Renders current scene without processing events nor saving it
+      * @return Time spent rendering the frame, in seconds
+      */
+    double RenderFrame();
+    
+    /**
+      * @brief Returns face element which is in 'pos' position (screen coordinates)
+      * @param pos Position, in screen space
+      * @return Pointed face element, or INVALID if any face element is pointed. Its row and column are returned in 'row' and 'col'
+      */
+    FaceElement PickFaceElement(const irr::core::position2di &pos, size_t &row, size_t &col);
 };
 
 
 
 
-irr::core::vector3df GetRotationAxis(FaceElement face) {
-    assert(face >= 0 && face < INVALID);
-    irr::core::vector3df rotation_axis;
-    switch(face) {
-    case FRONT:  rotation_axis = irr::core::vector3df { 0.0f,  0.0f,  1.0f}; break;
-    case BACK:   rotation_axis = irr::core::vector3df { 0.0f,  0.0f, -1.0f}; break;
-    case LEFT:   rotation_axis = irr::core::vector3df {-1.0f,  0.0f,  0.0f}; break;
-    case RIGHT:  rotation_axis = irr::core::vector3df { 1.0f,  0.0f,  0.0f}; break;
-    case TOP:    rotation_axis = irr::core::vector3df { 0.0f,  1.0f,  0.0f}; break;
-    case BOTTOM: rotation_axis = irr::core::vector3df { 0.0f, -1.0f,  0.0f}; break;
-    }
-    return rotation_axis;
-}
-
-
-
-
-
 /******* IMPLEMENTATION *******/
 template<size_t CUBE_SIZE>
 void GraphicalRubikCube<CUBE_SIZE>::InitializeFacesColors() {
-    // Colors. Format ARGB. Range [0, 255]
-    std::array<irr::video::SColor, NUM_FACES> faces_colors =
-        {
-         irr::video::SColor {255,   0, 255,   0}, // Front
-         irr::video::SColor {255,   0,   0, 255}, // Back
-         irr::video::SColor {255, 255, 255, 255}, // Left
-         irr::video::SColor {255, 255, 255,   0}, // Right
-         irr::video::SColor {255, 255,   0,   0}, // Top
-         irr::video::SColor {255, 255, 128,   0}  // Bottom
-        };
     // Initialize materials
-    for(int i=0; i<NUM_FACES; ++i) {
-        irr::video::SMaterial *material = new irr::video::SMaterial();
-        
-        // Set material properties
-        //material->setFlag(EMF_GOURAUD_SHADING, false);
-        material->setFlag(irr::video::EMF_LIGHTING, true);
-        material->setFlag(irr::video::EMF_FRONT_FACE_CULLING, false);
-        material->setFlag(irr::video::EMF_BACK_FACE_CULLING, false);
-        material->setFlag(irr::video::EMF_ANISOTROPIC_FILTER, false);
-        material->setFlag(irr::video::EMF_ANTI_ALIASING, false);
-        material->setFlag(irr::video::EMF_COLOR_MATERIAL, true);
-        material->setFlag(irr::video::EMF_USE_MIP_MAPS, false);
-        
-        // Set material colors
-        material->AmbientColor = faces_colors[i];
-        material->DiffuseColor = faces_colors[i];
-        material->SpecularColor = faces_colors[i];
-        material->EmissiveColor = faces_colors[i];
-        material->Shininess = 20.0f;
-        
-        // Save value
-        faces_element_materials[i] = material;
-    }
+    for(int i=0; i<NUM_FACES; ++i)
+        faces_element_materials[i] = new irr::video::SMaterial(CreateFaceMaterial((FaceElement)i));
 }
 
 template<size_t CUBE_SIZE>
@@ -357,20 +484,6 @@ void GraphicalRubikCube<CUBE_SIZE>::GenerateFaces(float cube_length, irr::scene:
     irr::core::dimension2d<float> element_dim = {element_size, element_size};
     irr::core::dimension2d<unsigned int> tiles_per_element = {1, 1};
     
-    float min_val = -cube_length * 0.5f;
-    float max_val =  cube_length * 0.5f;
-    
-    // Yaw, pitch, roll
-    std::array<irr::core::vector3df, NUM_FACES> rotation_table =
-        {
-         irr::core::vector3df { 90.0f, 0.0f,   0.0f}, // Front
-         irr::core::vector3df {270.0f, 0.0f,   0.0f}, // Back
-         irr::core::vector3df {  0.0f, 0.0f,  90.0f}, // Left
-         irr::core::vector3df {  0.0f, 0.0f, 270.0f}, // Right
-         irr::core::vector3df {  0.0f, 0.0f,   0.0f}, // Top
-         irr::core::vector3df {  0.0f, 0.0f, 180.0f}  // Bottom
-        };
-    
     for(int i = 0; i < faces_element_nodes.size(); ++i) {
         FaceElement face;
         int face_id;
@@ -378,7 +491,6 @@ void GraphicalRubikCube<CUBE_SIZE>::GenerateFaces(float cube_length, irr::scene:
         int col;
         float pos_row;
         float pos_col;
-        float x, y, z;
         irr::core::vector3df position;
         irr::core::vector3df rotation;
         irr::core::vector3df scale = {0.9f, 0.9f, 0.9f};
@@ -389,18 +501,8 @@ void GraphicalRubikCube<CUBE_SIZE>::GenerateFaces(float cube_length, irr::scene:
         pos_row = cube_length * (float)row / (float)CUBE_SIZE - cube_length*0.5f + element_size*0.5f;
         pos_col = cube_length * (float)col / (float)CUBE_SIZE - cube_length*0.5f + element_size*0.5f;
         
-        switch(face_id) {
-        case 0:  x = -pos_col; y = -pos_row; z =  max_val; break; // Front
-        case 1:  x =  pos_col; y = -pos_row; z =  min_val; break; // Back
-        case 2:  x =  max_val; y = -pos_row; z =  pos_col; break; // Left
-        case 3:  x =  min_val; y = -pos_row; z = -pos_col; break; // Right
-        case 4:  x = -pos_col; y =  max_val; z =  pos_row; break; // Top
-        case 5:  x = -pos_col; y =  min_val; z = -pos_row; break; // Bottom
-        default: assert(false);
-        }
-        
-        position = irr::core::vector3df {x, y, z};
-        rotation = rotation_table[face_id];
+        position = GetFacePoint(face, pos_row, pos_col, cube_length*0.5f);
+        rotation = GetFaceRotation(face);
         irr::scene::IMesh* plane = creator->createPlaneMesh(element_dim, tiles_per_element, faces_element_materials[face_id]);
         faces_element_nodes[i] = smgr->addMeshSceneNode(plane, parent, initial_cube_id+i, position, rotation, scale);
         irr::scene::ITriangleSelector *triangle_selector = smgr->createTriangleSelector(plane, faces_element_nodes[i]);
@@ -412,9 +514,11 @@ void GraphicalRubikCube<CUBE_SIZE>::GenerateFaces(float cube_length, irr::scene:
 
 template<size_t CUBE_SIZE>
 void GraphicalRubikCube<CUBE_SIZE>::PrepareScene(float cube_length) {
-    /* Message */
-    guienv->addStaticText(L"Hello World! This is Irrlicht with the burnings software renderer!",
-                          irr::core::rect<int32_t>(10,10,260,22), true);
+    /* Frame statistics overlay */
+    stats_text = guienv->addStaticText(L"", irr::core::rect<int32_t>(10,10,330,70), true);
+    stats_text->setWordWrap(true);
+    stats_text->setBackgroundColor(irr::video::SColor(160, 0, 0, 0));
+    stats_text->setOverrideColor(irr::video::SColor(255, 255, 255, 255));
     
     
     /* Models */
@@ -438,10 +542,23 @@ GraphicalRubikCube<CUBE_SIZE>::ReadState() const {
 
 template<size_t CUBE_SIZE>
 void GraphicalRubikCube<CUBE_SIZE>::UpdateEvents() {
-    bool left_pressed = event_handler.GetLeftMousePressed();
-    StateVariables next_state_variables = ReadState();
+    PROFILE_SCOPE("GraphicalRubikCube::UpdateEvents");
+    InputEvent event;
+    // Gestures are computed from every event, so short clicks and fast drags are not lost
+    while(event_handler.PopEvent(event))
+        ProcessEvent(event);
+}
+
+template<size_t CUBE_SIZE>
+void GraphicalRubikCube<CUBE_SIZE>::ProcessEvent(const InputEvent &event) {
+    StateVariables next_state_variables = curr_state_variables;
     State next_state;
-    bool animation_continue;
+    
+    if(event.type == InputEvent::LEFT_PRESSED)
+        left_pressed = true;
+    else if(event.type == InputEvent::LEFT_RELEASED)
+        left_pressed = false;
+    next_state_variables.cursor_pos = event.cursor_position;
     
     switch(curr_state) {
     case IDLE:
@@ -449,7 +566,7 @@ void GraphicalRubikCube<CUBE_SIZE>::UpdateEvents() {
             FaceElement selected;
             size_t depth;
             Clockwise clockwise;
-            PointedFace(curr_state_variables.cursor_pos, selected, depth, clockwise);
+            PointedFace(event.cursor_position, selected, depth, clockwise);
             
             next_state_variables.SetSelected(selected, clockwise, depth, 0.0f, *this);
             
@@ -460,20 +577,37 @@ void GraphicalRubikCube<CUBE_SIZE>::UpdateEvents() {
         break;
         
     case MOVE_CAMERA:
-        if(left_pressed)
-            next_state = MOVE_CAMERA;
-        else
+        if(event.type == InputEvent::LEFT_RELEASED)
             next_state = IDLE;
+        else
+            next_state = MOVE_CAMERA;
         break;
         
     case ROTATE_LAYER:
-        if(left_pressed) {
-            next_state = ROTATE_LAYER;
-        } else {
+        if(event.type == InputEvent::LEFT_RELEASED) {
             next_state = ANIMATION_ROTATE_LAYER;
             next_state_variables.CalcTargetAngle(cube_angle_threshold, cube_animation_inc);
+        } else {
+            next_state = ROTATE_LAYER;
         }
         break;
+        
+    default:
+        // Animations don't depend on input. Only cursor position is tracked
+        curr_state_variables.cursor_pos = event.cursor_position;
+        return;
+    }
+    
+    ApplyTransition(next_state, next_state_variables);
+}
+
+template<size_t CUBE_SIZE>
+void GraphicalRubikCube<CUBE_SIZE>::UpdateAnimation() {
+    StateVariables next_state_variables = ReadState();
+    State next_state;
+    bool animation_continue;
+    
+    switch(curr_state) {
     case ANIMATION_ROTATE_LAYER:
         animation_continue = next_state_variables.NextAnimationStep(frame_duration);
         if(animation_continue)
@@ -485,21 +619,29 @@ void GraphicalRubikCube<CUBE_SIZE>::UpdateEvents() {
         next_state = IDLE;
         next_state_variables.ResetSelected();
         break;
+    default:
+        // Other states are driven by input events
+        return;
     }
     
+    ApplyTransition(next_state, next_state_variables);
+}
+
+template<size_t CUBE_SIZE>
+void GraphicalRubikCube<CUBE_SIZE>::ApplyTransition(State next_state, StateVariables &next) {
     if(next_state == MOVE_CAMERA) {
-        UpdateCamera(next_state_variables);
+        UpdateCamera(next);
     } else if(next_state == ROTATE_LAYER) {
-        UpdateRotateLayer(next_state_variables);
+        UpdateRotateLayer(next);
     } else if(next_state == ANIMATION_ROTATE_LAYER) {
-        UpdateAnimationLayer(next_state_variables);
+        UpdateAnimationLayer(next);
     } else if(next_state == INTERNAL_ROTATE_LAYER) {
-        UpdateAnimationLayer(next_state_variables);
-        UpdateInternalCube(next_state_variables);
+        UpdateAnimationLayer(next);
+        UpdateInternalCube(next);
     }
     
     curr_state = next_state;
-    curr_state_variables = next_state_variables;
+    curr_state_variables = next;
 }
 
 template<size_t CUBE_SIZE>
@@ -556,12 +698,48 @@ void GraphicalRubikCube<CUBE_SIZE>::UpdateInternalCube(StateVariables &next) {
         num_rotates = 4 + num_rotates;
     if(!next.PositiveOffset())
         num_rotates = 4 - num_rotates;
+    Move move = {curr_state_variables.selected_face, curr_state_variables.clockwise, curr_state_variables.depth};
     for(int i=0; i<num_rotates; ++i)
-        this->RotateFace(curr_state_variables.selected_face, curr_state_variables.clockwise, curr_state_variables.depth);
+        CommitMove(move);
+}
+
+template<size_t CUBE_SIZE>
+void GraphicalRubikCube<CUBE_SIZE>::CommitMove(const Move &move, bool record) {
+    // Scene nodes have been rotated, so base class is updated now. Colors will come from the simulation
+    this->RotateFace(move);
+    while(!simulation.PushMove(move))
+        std::this_thread::yield();
+    if(record)
+        history.Push(move, (uint32_t)((get_monotonic_time() - session_start) * 1000.0));
+}
+
+template<size_t CUBE_SIZE>
+void GraphicalRubikCube<CUBE_SIZE>::ApplyHistoryMove(const Move &move) {
+    assert(curr_state == IDLE);
+    StateVariables move_state;
+    move_state.SetSelected(move.face, move.clockwise, move.depth, 0.0f, *this);
+    RotateNodes(move_state.layer, move_state.rotation_axis, cube->getPosition(),
+                (move_state.PositiveOffset() ? 0.5f : -0.5f) * M_PI);
+    CommitMove(move, false);
+}
+
+template<size_t CUBE_SIZE>
+void GraphicalRubikCube<CUBE_SIZE>::ApplySnapshot(const CubeSnapshot<CUBE_SIZE> &snapshot) {
+    for(int face=0; face<NUM_FACES; ++face) {
+        for(size_t row=0; row<CUBE_SIZE; ++row) {
+            for(size_t col=0; col<CUBE_SIZE; ++col) {
+                irr::scene::ISceneNode *node = this->GetFaceObject((FaceElement)face, row, col);
+                FaceElement color = snapshot.GetFaceElement((FaceElement)face, row, col);
+                node->getMaterial(0) = *faces_element_materials[(int)color];
+            }
+        }
+    }
 }
 
 template<size_t CUBE_SIZE>
 void GraphicalRubikCube<CUBE_SIZE>::PointedFaceElement(const irr::core::position2di &pos, FaceElement &face_element, size_t &row, size_t &col) {
+    PROFILE_SCOPE("GraphicalRubikCube::Picking");
+    SectionTimer timer(frame_stats, SECTION_PICKING);
     irr::scene::ISceneCollisionManager *picker = smgr->getSceneCollisionManager();
     irr::core::line3d<float> intersect_ray = picker->getRayFromScreenCoordinates(pos, camera);
     irr::scene::ISceneNode *selected;
@@ -686,16 +864,34 @@ void GraphicalRubikCube<CUBE_SIZE>::GetCoordsFromID(int id, FaceElement &face, i
 }
 
 template<size_t CUBE_SIZE>
-GraphicalRubikCube<CUBE_SIZE>::GraphicalRubikCube(const std::wstring &window_title, size_t width, size_t height, float cube_length) {
+GraphicalRubikCube<CUBE_SIZE>::GraphicalRubikCube(const std::wstring &window_title, size_t width, size_t height, float cube_length,
+                                                  RenderMode mode) {
     curr_state = IDLE;
-    last_time = get_current_time();
+    render_mode = mode;
     
     /* Create a device */
-    device = createDevice(irr::video::EDT_BURNINGSVIDEO,
-                          irr::core::dimension2d<uint32_t>(width, height),
-                          16, false, false, false, &event_handler);
-    if(!device)
+    irr::SIrrlichtCreationParameters parameters;
+    parameters.DriverType = irr::video::EDT_BURNINGSVIDEO;
+    parameters.WindowSize = irr::core::dimension2d<uint32_t>(width, height);
+    parameters.Bits = 16;
+    parameters.Fullscreen = false;
+    parameters.Stencilbuffer = false;
+    parameters.Vsync = false;
+    parameters.EventReceiver = &event_handler;
+    if(mode == HEADLESS) {
+        // Console device renders to memory without any display. Its ASCII art output is discarded
+        console_output = fopen("/dev/null", "w");
+        if(!console_output)
+            throw std::runtime_error("Error opening /dev/null");
+        parameters.DeviceType = irr::EIDT_CONSOLE;
+        parameters.WindowId = console_output;
+    }
+    device = irr::createDeviceEx(parameters);
+    if(!device) {
+        if(console_output)
+            fclose(console_output);
         throw std::runtime_error("Error creating a device");
+    }
     
     /* Set title */
     device->setWindowCaption(window_title.c_str());
@@ -707,11 +903,15 @@ GraphicalRubikCube<CUBE_SIZE>::GraphicalRubikCube(const std::wstring &window_tit
     
     /* Prepare scene */
     PrepareScene(cube_length);
+    if(mode == HEADLESS)
+        stats_text->setVisible(false);
 }
 
 template<size_t CUBE_SIZE>
 GraphicalRubikCube<CUBE_SIZE>::~GraphicalRubikCube() {
     device->drop();
+    if(console_output)
+        fclose(console_output);
     for(int i=0; i<faces_element_materials.size(); ++i)
         delete faces_element_materials[i];
 }
@@ -721,19 +921,206 @@ bool GraphicalRubikCube<CUBE_SIZE>::ShouldContinue() const {
     return device->run();
 }
 
+template<size_t CUBE_SIZE>
+void GraphicalRubikCube<CUBE_SIZE>::DrawScene(float alpha) {
+    PROFILE_SCOPE("GraphicalRubikCube::DrawScene");
+    SectionTimer timer(frame_stats, SECTION_RENDER);
+    bool interpolate = curr_state == ANIMATION_ROTATE_LAYER;
+    float offset = 0.0f;
+    
+    // Animated layer is moved back to the interpolated angle only while drawing
+    if(interpolate) {
+        offset = curr_state_variables.GetInterpolatedAngle(alpha) - curr_state_variables.angle;
+        RotateNodes(curr_state_variables.layer, curr_state_variables.rotation_axis, cube->getPosition(), offset);
+    }
+    
+    driver->beginScene(irr::video::ECBF_COLOR | irr::video::ECBF_DEPTH, background_color);
+    smgr->drawAll();
+    guienv->drawAll();
+    driver->endScene();
+    
+    if(interpolate)
+        RotateNodes(curr_state_variables.layer, curr_state_variables.rotation_axis, cube->getPosition(), -offset);
+}
+
+template<size_t CUBE_SIZE>
+void GraphicalRubikCube<CUBE_SIZE>::UpdateStats() {
+    // Scene manager counts nodes drawn in each pass. Each face element is a single mesh buffer, so a draw call
+    irr::io::IAttributes *parameters = smgr->getParameters();
+    size_t draw_calls = parameters->getAttributeAsInt("drawn_solid") +
+                        parameters->getAttributeAsInt("drawn_transparent") +
+                        parameters->getAttributeAsInt("drawn_transparent_effect");
+    frame_stats.EndFrame(scheduler.GetFrameDuration(), draw_calls, driver->getPrimitiveCountDrawn());
+    
+    double current_time = get_monotonic_time();
+    if(current_time - last_stats_refresh >= STATS_REFRESH_PERIOD) {
+        stats_text->setText(frame_stats.ToString().c_str());
+        last_stats_refresh = current_time;
+    }
+}
+
 template<size_t CUBE_SIZE>
 void GraphicalRubikCube<CUBE_SIZE>::UpdateFrame() {
-    double current_time;
-    current_time = get_current_time();
-    frame_duration = current_time - last_time;
-    last_time = current_time;
+    PROFILE_SCOPE("GraphicalRubikCube::UpdateFrame");
+    double update_start;
+    double picking_start;
     
-    driver->beginScene(irr::video::ECBF_COLOR | irr::video::ECBF_DEPTH, irr::video::SColor(255,100,101,140));
+    scheduler.BeginFrame();
+    frame_duration = scheduler.GetStep();
+    
+    update_start = get_monotonic_time();
+    picking_start = frame_stats.GetSectionTime(SECTION_PICKING);
     
     UpdateEvents();
+    while(scheduler.NextStep())
+        UpdateAnimation();
+    
+    // Moves pushed by other threads are shown once the cube is not being manipulated
+    if(curr_state == IDLE && simulation.UpdateSnapshot())
+        ApplySnapshot(simulation.GetSnapshot());
+    
+    // Picking is measured on its own section
+    frame_stats.AddSectionTime(SECTION_UPDATE, get_monotonic_time() - update_start -
+                                               (frame_stats.GetSectionTime(SECTION_PICKING) - picking_start));
     
+    DrawScene(scheduler.GetInterpolation());
+    UpdateStats();
+}
+
+template<size_t CUBE_SIZE>
+bool GraphicalRubikCube<CUBE_SIZE>::PushMove(const Move &move) {
+    return simulation.PushMove(move);
+}
+
+template<size_t CUBE_SIZE>
+void GraphicalRubikCube<CUBE_SIZE>::SetCameraOrientation(float pitch, float yaw) {
+    float camera_limits = 0.01;
+    camera_pitch = pitch;
+    camera_yaw = yaw;
+    if(camera_yaw <= -0.5f*M_PI+camera_limits)
+        camera_yaw = -0.5f*M_PI+camera_limits;
+    else if(camera_yaw >= 0.5f*M_PI-camera_limits)
+        camera_yaw = 0.5f*M_PI-camera_limits;
+    SetCameraAngles(camera, camera_pitch, camera_yaw, cube->getPosition(), CAMERA_DISTANCE);
+}
+
+template<size_t CUBE_SIZE>
+template<typename FrameCallback>
+void GraphicalRubikCube<CUBE_SIZE>::AnimateMove(const Move &move, size_t num_frames, FrameCallback on_frame) {
+    assert(curr_state == IDLE);
+    StateVariables move_state;
+    float target_angle;
+    float angle = 0.0f;
+    
+    // A quarter turn in the direction of the move, as if the user had dragged the layer
+    move_state.SetSelected(move.face, move.clockwise, move.depth, 0.0f, *this);
+    target_angle = (move_state.PositiveOffset() ? 0.5f : -0.5f) * M_PI;
+    
+    for(size_t frame=0; frame<num_frames; ++frame) {
+        float next_angle = target_angle * (frame+1) / num_frames;
+        RotateNodes(move_state.layer, move_state.rotation_axis, cube->getPosition(), next_angle - angle);
+        angle = next_angle;
+        on_frame(frame);
+    }
+    if(num_frames == 0)
+        RotateNodes(move_state.layer, move_state.rotation_axis, cube->getPosition(), target_angle);
+    
+    CommitMove(move);
+}
+
+template<size_t CUBE_SIZE>
+void GraphicalRubikCube<CUBE_SIZE>::ApplyMove(const Move &move) {
+    AnimateMove(move, 0, [](size_t) {});
+}
+
+template<size_t CUBE_SIZE>
+bool GraphicalRubikCube<CUBE_SIZE>::Undo() {
+    if(!history.CanUndo())
+        return false;
+    ApplyHistoryMove(history.Undo());
+    return true;
+}
+
+template<size_t CUBE_SIZE>
+bool GraphicalRubikCube<CUBE_SIZE>::Redo() {
+    if(!history.CanRedo())
+        return false;
+    ApplyHistoryMove(history.Redo());
+    return true;
+}
+
+template<size_t CUBE_SIZE>
+void GraphicalRubikCube<CUBE_SIZE>::SeekHistory(size_t position) {
+    std::array<FaceElement, NUM_FACES*CUBE_SIZE*CUBE_SIZE> facelets;
+    history.GetFacelets(position, facelets.data());
+    history.Seek(position);
+    SetState(facelets.data(), position);
+}
+
+template<size_t CUBE_SIZE>
+const MoveHistory<CUBE_SIZE>& GraphicalRubikCube<CUBE_SIZE>::GetHistory() const {
+    return history;
+}
+
+template<size_t CUBE_SIZE>
+void GraphicalRubikCube<CUBE_SIZE>::LoadSession(const std::string &filename) {
+    history.Load(filename);
+    SeekHistory(history.GetNumMoves());
+}
+
+template<size_t CUBE_SIZE>
+void GraphicalRubikCube<CUBE_SIZE>::SetState(const FaceElement *facelets, uint64_t num_moves) {
+    assert(curr_state == IDLE);
+    CubeSnapshot<CUBE_SIZE> state;
+    std::copy(facelets, facelets + state.NUM_FACELETS, state.facelets.begin());
+    state.num_moves = num_moves;
+    for(int face=0; face<NUM_FACES; ++face)
+        for(size_t row=0; row<CUBE_SIZE; ++row)
+            for(size_t col=0; col<CUBE_SIZE; ++col)
+                this->SetFaceElement((FaceElement)face, row, col, state.GetFaceElement((FaceElement)face, row, col));
+    // Colors are shown now, and the simulation model is replaced after the moves pushed before
+    ApplySnapshot(state);
+    while(!simulation.PushState(state))
+        std::this_thread::yield();
+}
+
+template<size_t CUBE_SIZE>
+double GraphicalRubikCube<CUBE_SIZE>::RenderToFile(const std::string &filename) {
+    PROFILE_SCOPE("GraphicalRubikCube::RenderToFile");
+    double start = get_monotonic_time();
+    double render_time;
+    irr::video::IImage *frame;
+    bool written;
+    
+    driver->beginScene(irr::video::ECBF_COLOR | irr::video::ECBF_DEPTH, background_color);
     smgr->drawAll();
     guienv->drawAll();
-    
+    frame = driver->createScreenShot();
     driver->endScene();
+    render_time = get_monotonic_time() - start;
+    
+    if(!frame)
+        throw std::runtime_error("Error capturing frame");
+    written = driver->writeImageToFile(frame, filename.c_str());
+    frame->drop();
+    if(!written)
+        throw std::runtime_error("Error writing frame to " + filename);
+    
+    return render_time;
+}
+
+template<size_t CUBE_SIZE>
+double GraphicalRubikCube<CUBE_SIZE>::RenderFrame() {
+    double start = get_monotonic_time();
+    DrawScene(1.0f);
+    return get_monotonic_time() - start;
+}
+
+template<size_t CUBE_SIZE>
+FaceElement GraphicalRubikCube<CUBE_SIZE>::PickFaceElement(const irr::core::position2di &pos, size_t &row, size_t &col) {
+    FaceElement face_element;
+    PointedFaceElement(pos, face_element, row, col);
+    return face_element;
 }
+
+#endif
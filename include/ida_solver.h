@@ -0,0 +1,156 @@
+#ifndef __RUBIK_IDA_SOLVER_H__
+#define __RUBIK_IDA_SOLVER_H__
+
+#include <rubik.h>
+#include <move_generator.h>
+#include <coordinate_tables.h>
+#include <pruning_tables.h>
+#include <state_encoding.h>
+#include <vector>
+#include <cstdint>
+
+/**
+  * IDA* search of shortest 3x3 solutions: an iterative deepening search where each node carries the
+  * coordinates of its state, and moves after which a pruning table bounds the distance above the remaining
+  * moves are skipped. Moves and their order are the ones of SolveIDDFS, so both find the same solution if
+  * the centers are at their solved positions (otherwise the search runs with the orientation undone, and
+  * may find another solution of the same length).
+  *
+  * Most of the time of a search goes to pruning table entries which are not cached. Batched evaluation
+  * turns all the children of a node at once: their coordinates are read a coordinate at a time, then
+  * the pruning table entries of every child are prefetched, and then all of them are read, so the memory
+  * accesses of the children overlap instead of waiting one after the other. Pruning table lookups are
+  * scalar, but the coordinates, indices, distances and bounds after every move are computed in loops over
+  * IDA_BATCH moves, which GCC vectorizes at -O2 (see -fopt-info-vec-optimized).
+  */
+
+/*    How the bounds of the children of a node are evaluated    */
+typedef enum {
+    SINGLE_EVALUATION = 0, // A child at a time, before visiting it
+    BATCHED_EVALUATION     // All the children of a node together, prefetching their pruning table entries
+} HeuristicEvaluation;
+
+/*    Moves of a batch: the coordinate moves, padded to whole 8 byte vectors of distances    */
+const size_t IDA_BATCH = 24;
+
+static_assert(IDA_BATCH >= NUM_COORDINATE_MOVES, "A batch must hold all the coordinate moves");
+
+/*    Statistics of an IDA* search    */
+struct IDAStarStats {
+    uint64_t nodes = 0;     // Visited states: children are counted in order until a solution is found
+    double latency = 0.0;   // Seconds
+    size_t iterations = 0;  // Bounds searched
+};
+
+/**
+  * @brief IDA* solver of 3x3 cubes, on coordinate move tables and pruning tables
+  */
+class IDAStarSolver3 {
+private:
+    /*    Search state of a node    */
+    struct Node {
+        uint32_t coordinates[NUM_COORDINATES];
+        uint8_t distances[NUM_PRUNING_TABLES]; // Distance of the entry of each pruning table
+    };
+
+    const CoordinateTables &coordinates;
+    const PruningTables &pruning;
+    MoveGenerator<3> generator;
+    std::vector<size_t> coordinate_moves;   // Move of the coordinate tables of each move of the generator
+    std::vector<CubieState3> move_cubies;   // Pieces moved by each move of the coordinate tables
+    Node solved;
+
+    /**
+      * @brief Returns the largest distance of the pruning tables
+      */
+    uint8_t GetBound(const Node &node) const;
+
+    /**
+      * @brief Finds the distances of the pruning tables of a child of a node, once its coordinates are set
+      */
+    void SetDistances(const Node &parent, Node &child) const;
+
+    /**
+      * @brief Checks if a path of generator moves solves the pieces. Coordinates don't cover the
+      *        permutation of the edges out of the slice, so nodes with solved coordinates are checked here
+      */
+    bool IsSolving(const CubieState3 &cubies, const std::vector<uint16_t> &path) const;
+
+    /**
+      * @brief Depth-limited search from a node
+      * @param path Generator moves from the root. The moves leading to a solution are kept
+      */
+    bool Search(const CubieState3 &cubies, const Node &node, size_t state, size_t remaining,
+                std::vector<uint16_t> &path, HeuristicEvaluation evaluation, uint64_t &nodes) const;
+
+    /**
+      * @brief Searches a solution of the pieces of a cube, with its orientation undone
+      * @param solution Output generator moves
+      */
+    bool SolveCubies(const CubieState3 &cubies, size_t max_depth, std::vector<uint16_t> &solution,
+                     HeuristicEvaluation evaluation, IDAStarStats &stats) const;
+
+public:
+    /**
+      * @brief Prepares a solver. Tables are used by reference, so they must outlive it
+      */
+    IDAStarSolver3(const CoordinateTables &coordinates, const PruningTables &pruning);
+
+    /**
+      * @brief Searches a shortest solution. Solved means each face has a single color, in any orientation
+      * @param cube Cube to solve
+      * @param max_depth Maximum length of the solution, in quarter turns
+      * @param solution Output solution
+      * @param evaluation How the bounds of the children of a node are evaluated. Both find the same solution
+      * @param stats Output statistics of the search. Ignored if null
+      * @return True if a solution was found. False if there is no solution of at most max_depth quarter turns,
+      *         or the cube is not in a valid state
+      */
+    template<typename T>
+    bool Solve(const RubikCube<T, 3> &cube, size_t max_depth, std::vector<Move> &solution,
+               HeuristicEvaluation evaluation = BATCHED_EVALUATION, IDAStarStats *stats = nullptr) const;
+};
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+template<typename T>
+bool IDAStarSolver3::Solve(const RubikCube<T, 3> &cube, size_t max_depth, std::vector<Move> &solution,
+                           HeuristicEvaluation evaluation, IDAStarStats *stats) const {
+    FaceElement facelets[NUM_FACELETS3];
+    FaceElement faces[INVALID];
+    CubieState3 cubies;
+    unsigned orientation;
+    std::vector<uint16_t> moves;
+    IDAStarStats local_stats;
+    size_t i = 0;
+
+    if(stats == nullptr)
+        stats = &local_stats;
+    *stats = IDAStarStats();
+    solution.clear();
+    for(int face=0; face<INVALID; ++face)
+        for(size_t row=0; row<3; ++row)
+            for(size_t col=0; col<3; ++col)
+                facelets[i++] = cube.GetFaceElement((FaceElement)face, row, col);
+    if(!FaceletsToCubies3(facelets, cubies, orientation))
+        return false;
+    if(!SolveCubies(cubies, max_depth, moves, evaluation, *stats))
+        return false;
+
+    // Moves were found with the orientation undone: a turn of the face of a color is a turn of the face
+    // where the center of that color is
+    CubiesToFacelets3(GetSolvedCubies3(), orientation, facelets);
+    for(int face=0; face<INVALID; ++face)
+        faces[facelets[face*9 + 4]] = (FaceElement)face;
+    for(i=0; i<moves.size(); ++i)
+        generator.AppendMove(moves[i], solution);
+    for(i=0; i<solution.size(); ++i)
+        solution[i].face = faces[solution[i].face];
+    return true;
+}
+
+#endif
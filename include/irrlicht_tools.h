@@ -40,6 +40,18 @@ void RotateNode(irr::scene::ISceneNode *node, const irr::core::vector3df &rotati
 void RotateNodes(const std::vector<irr::scene::ISceneNode*> &nodes, const irr::core::vector3df &rotation_axis, const irr::core::vector3df &center, float angle);
 
 
+/**
+  * @brief Checks if a box may be seen through a view frustum
+  *
+  * Conservative test: the box is only discarded if all its corners are outside of the same
+  * frustum plane, so some boxes near frustum corners are reported as visible.
+  * @param box Box to check, in world space
+  * @param frustum View frustum, in world space
+  * @return False if the box is completely outside of the frustum
+  */
+bool IsBoxInFrustum(const irr::core::aabbox3df &box, const irr::scene::SViewFrustum &frustum);
+
+
 /**
   * @brief Prints color value, in {R, G, B, A} format
   * @param os Output stream to print
@@ -0,0 +1,121 @@
+#ifndef __RUBIK_LOCK_FREE_QUEUE_H__
+#define __RUBIK_LOCK_FREE_QUEUE_H__
+
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+  * @brief Bounded queue which can be used by several producers and one consumer without locks
+  *
+  * Each cell stores a sequence number which tells if the cell is ready to be written (sequence == position)
+  * or ready to be read (sequence == position+1). Producers reserve a position with a CAS, so no thread
+  * ever blocks another one. CAPACITY shall be a power of two.
+  */
+template<typename T, size_t CAPACITY>
+class LockFreeQueue {
+private:
+    static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY-1)) == 0, "Capacity of the queue shall be a power of two");
+
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr size_t INDEX_MASK = CAPACITY - 1;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::array<Cell, CAPACITY> cells;
+    // Producers and consumer positions live in different cache lines to avoid false sharing
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueue_pos;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeue_pos;
+
+public:
+    /**
+      * @brief Initializes an empty queue
+      */
+    LockFreeQueue();
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    /**
+      * @brief Appends an element at the end of the queue. It can be called from any thread
+      * @param value Element to append
+      * @return False if the queue is full, so the element was not appended. True in other case
+      */
+    bool Push(const T &value);
+
+    /**
+      * @brief Extracts the first element of the queue
+      * @pre Only one thread calls this method
+      * @param value Extracted element. It is valid only if returned value is true
+      * @return False if the queue is empty. True in other case
+      */
+    bool Pop(T &value);
+
+    /**
+      * @brief Returns maximum number of elements stored at the same time
+      */
+    size_t GetCapacity() const;
+};
+
+
+
+
+
+
+/******* IMPLEMENTATION ********/
+template<typename T, size_t CAPACITY>
+LockFreeQueue<T, CAPACITY>::LockFreeQueue()
+    : enqueue_pos(0), dequeue_pos(0)
+{
+    for(size_t i=0; i<CAPACITY; ++i)
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template<typename T, size_t CAPACITY>
+bool LockFreeQueue<T, CAPACITY>::Push(const T &value) {
+    Cell *cell;
+    size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    for(;;) {
+        cell = &cells[pos & INDEX_MASK];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if(diff == 0) {
+            // Cell is free. Reserve it, unless other producer was faster
+            if(enqueue_pos.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed))
+                break;
+        } else if(diff < 0) {
+            // Consumer has not released this cell yet: queue is full
+            return false;
+        } else {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+    cell->data = value;
+    cell->sequence.store(pos+1, std::memory_order_release);
+    return true;
+}
+
+template<typename T, size_t CAPACITY>
+bool LockFreeQueue<T, CAPACITY>::Pop(T &value) {
+    size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+    Cell *cell = &cells[pos & INDEX_MASK];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    if(sequence != pos+1)
+        return false;
+    value = cell->data;
+    // Cell will be reused by producers in the next lap
+    cell->sequence.store(pos+CAPACITY, std::memory_order_release);
+    dequeue_pos.store(pos+1, std::memory_order_relaxed);
+    return true;
+}
+
+template<typename T, size_t CAPACITY>
+size_t LockFreeQueue<T, CAPACITY>::GetCapacity() const {
+    return CAPACITY;
+}
+
+#endif
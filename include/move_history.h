@@ -0,0 +1,304 @@
+#ifndef __RUBIK_MOVE_HISTORY_H__
+#define __RUBIK_MOVE_HISTORY_H__
+
+#include <rubik.h>
+#include <move_table.h>
+#include <notation.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+/*    Default number of moves between snapshots of a history    */
+const size_t DEFAULT_SNAPSHOT_INTERVAL = 64;
+
+/*    Largest cube size whose moves fit in a byte (see PackMove)    */
+const size_t MAX_PACKED_MOVE_CUBE_SIZE = 21;
+
+/**
+  * @brief Encodes a move in a byte: (face*cube_size + depth)*2 + clockwise
+  * @pre cube_size is at most MAX_PACKED_MOVE_CUBE_SIZE, and the move is valid for that size
+  */
+uint8_t PackMove(const Move &move, size_t cube_size);
+
+/**
+  * @brief Decodes a move encoded by PackMove
+  * @throw std::invalid_argument if the byte is not a move of that cube size
+  */
+Move UnpackMove(uint8_t packed, size_t cube_size);
+
+/**
+  * @brief Writes a session recording: moves and the time, in milliseconds since the start of the session,
+  *        when each one was made
+  *
+  * Layout (little endian): "RUBIKSES", uint32 version, uint32 cube size, uint64 number of moves, then the
+  * packed moves (1 byte each) and their times (uint32 each).
+  * @throw std::runtime_error if the file could not be written
+  */
+void WriteSessionFile(const std::string &filename, size_t cube_size, const std::vector<uint8_t> &moves,
+                      const std::vector<uint32_t> &times);
+
+/**
+  * @brief Reads a session recording written by WriteSessionFile
+  * @throw std::runtime_error if the file could not be read, or it is not a valid session
+  */
+void ReadSessionFile(const std::string &filename, size_t &cube_size, std::vector<uint8_t> &moves,
+                     std::vector<uint32_t> &times);
+
+
+/**
+  * @brief Timestamped log of moves, with undo and redo. Moves take 1 byte and 4 bytes of timestamp.
+  *
+  * The state after every 'snapshot_interval' moves is kept, so the state after any number of moves is
+  * rebuilt applying at most snapshot_interval-1 moves. Undoing and then pushing a new move discards the
+  * undone moves, like text editors do.
+  */
+template<size_t CUBE_SIZE>
+class MoveHistory {
+private:
+    static_assert(CUBE_SIZE <= MAX_PACKED_MOVE_CUBE_SIZE, "Moves of this cube size don't fit in a byte");
+
+    std::vector<uint8_t> moves;
+    std::vector<uint32_t> times;
+    // snapshots[i] is the state after i*snapshot_interval moves
+    std::vector<FaceletPermutation<CUBE_SIZE>> snapshots;
+    // State after all the moves of the log, so pushing a move doesn't need a seek
+    FaceletPermutation<CUBE_SIZE> last_state;
+    size_t snapshot_interval;
+    size_t position;
+
+public:
+    /**
+      * @brief Initializes an empty history
+      * @param snapshot_interval Moves between snapshots. Greater values save memory, and make seeks slower
+      */
+    explicit MoveHistory(size_t snapshot_interval = DEFAULT_SNAPSHOT_INTERVAL);
+
+    /**
+      * @brief Records a move at current position. Undone moves after it are discarded
+      * @param move Move, already applied to the cube
+      * @param time Time of the move, in milliseconds since the start of the session
+      */
+    void Push(const Move &move, uint32_t time = 0);
+
+    bool CanUndo() const;
+    bool CanRedo() const;
+
+    /**
+      * @brief Steps back one move
+      * @pre CanUndo()
+      * @return Move which undoes the last applied one
+      */
+    Move Undo();
+
+    /**
+      * @brief Steps forward one move
+      * @pre CanRedo()
+      * @return Move to apply again
+      */
+    Move Redo();
+
+    /**
+      * @brief Returns number of applied moves. Moves after it can be redone
+      */
+    size_t GetPosition() const;
+
+    /**
+      * @brief Returns number of moves of the log, including the ones which can be redone
+      */
+    size_t GetNumMoves() const;
+
+    /**
+      * @brief Returns a move of the log
+      * @pre index < GetNumMoves()
+      */
+    Move GetMove(size_t index) const;
+
+    /**
+      * @brief Returns time of a move of the log, in milliseconds
+      * @pre index < GetNumMoves()
+      */
+    uint32_t GetTime(size_t index) const;
+
+    /**
+      * @brief Returns number of moves made up to a time: position of the session at that time
+      * @pre Times of the moves don't decrease
+      */
+    size_t FindPosition(uint32_t time) const;
+
+    /**
+      * @brief Returns the state after some moves of the log, applying at most snapshot_interval-1 moves
+      * @pre position <= GetNumMoves()
+      */
+    FaceletPermutation<CUBE_SIZE> GetState(size_t position) const;
+
+    /**
+      * @brief Writes face elements of the state after some moves, in the order of FaceletsToString
+      * @pre position <= GetNumMoves()
+      * @param facelets Output array of 6*CUBE_SIZE*CUBE_SIZE face elements
+      */
+    void GetFacelets(size_t position, FaceElement *facelets) const;
+
+    /**
+      * @brief Moves current position. Moves after it can be redone
+      * @pre position <= GetNumMoves()
+      */
+    void Seek(size_t position);
+
+    /**
+      * @brief Removes all the moves
+      */
+    void Clear();
+
+    /**
+      * @brief Saves all the moves as a session recording (see WriteSessionFile)
+      */
+    void Save(const std::string &filename) const;
+
+    /**
+      * @brief Replaces the history with a session recording. Position is set at its end
+      * @throw std::runtime_error if the file is not valid, or it was recorded with other cube size
+      */
+    void Load(const std::string &filename);
+};
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+template<size_t CUBE_SIZE>
+MoveHistory<CUBE_SIZE>::MoveHistory(size_t snapshot_interval)
+    : snapshots(1), snapshot_interval(snapshot_interval), position(0)
+{
+    if(snapshot_interval == 0)
+        throw std::invalid_argument("Snapshot interval shall be positive");
+}
+
+template<size_t CUBE_SIZE>
+void MoveHistory<CUBE_SIZE>::Push(const Move &move, uint32_t time) {
+    if(position < moves.size()) {
+        // Undone moves are discarded, with the snapshots taken after them
+        moves.resize(position);
+        times.resize(position);
+        snapshots.resize(position/snapshot_interval + 1);
+        last_state = GetState(position);
+    }
+    moves.push_back(PackMove(move, CUBE_SIZE));
+    times.push_back(time);
+    MoveTable<CUBE_SIZE>::Get().ApplyMove(move, last_state);
+    ++position;
+    if(position % snapshot_interval == 0)
+        snapshots.push_back(last_state);
+}
+
+template<size_t CUBE_SIZE>
+bool MoveHistory<CUBE_SIZE>::CanUndo() const {
+    return position > 0;
+}
+
+template<size_t CUBE_SIZE>
+bool MoveHistory<CUBE_SIZE>::CanRedo() const {
+    return position < moves.size();
+}
+
+template<size_t CUBE_SIZE>
+Move MoveHistory<CUBE_SIZE>::Undo() {
+    assert(CanUndo());
+    --position;
+    return InverseMove(UnpackMove(moves[position], CUBE_SIZE));
+}
+
+template<size_t CUBE_SIZE>
+Move MoveHistory<CUBE_SIZE>::Redo() {
+    assert(CanRedo());
+    return UnpackMove(moves[position++], CUBE_SIZE);
+}
+
+template<size_t CUBE_SIZE>
+size_t MoveHistory<CUBE_SIZE>::GetPosition() const {
+    return position;
+}
+
+template<size_t CUBE_SIZE>
+size_t MoveHistory<CUBE_SIZE>::GetNumMoves() const {
+    return moves.size();
+}
+
+template<size_t CUBE_SIZE>
+Move MoveHistory<CUBE_SIZE>::GetMove(size_t index) const {
+    assert(index < moves.size());
+    return UnpackMove(moves[index], CUBE_SIZE);
+}
+
+template<size_t CUBE_SIZE>
+uint32_t MoveHistory<CUBE_SIZE>::GetTime(size_t index) const {
+    assert(index < times.size());
+    return times[index];
+}
+
+template<size_t CUBE_SIZE>
+size_t MoveHistory<CUBE_SIZE>::FindPosition(uint32_t time) const {
+    return std::upper_bound(times.begin(), times.end(), time) - times.begin();
+}
+
+template<size_t CUBE_SIZE>
+FaceletPermutation<CUBE_SIZE> MoveHistory<CUBE_SIZE>::GetState(size_t position) const {
+    assert(position <= moves.size());
+    const MoveTable<CUBE_SIZE> &table = MoveTable<CUBE_SIZE>::Get();
+    size_t snapshot = position / snapshot_interval;
+    FaceletPermutation<CUBE_SIZE> state = snapshots[snapshot];
+    for(size_t i=snapshot*snapshot_interval; i<position; ++i)
+        table.ApplyMove(UnpackMove(moves[i], CUBE_SIZE), state);
+    return state;
+}
+
+template<size_t CUBE_SIZE>
+void MoveHistory<CUBE_SIZE>::GetFacelets(size_t position, FaceElement *facelets) const {
+    FaceletPermutation<CUBE_SIZE> state = GetState(position);
+    for(size_t i=0; i<FaceletPermutation<CUBE_SIZE>::NUM_FACELETS; ++i)
+        facelets[i] = (FaceElement)(state.GetSource(i) / (CUBE_SIZE*CUBE_SIZE));
+}
+
+template<size_t CUBE_SIZE>
+void MoveHistory<CUBE_SIZE>::Seek(size_t position) {
+    assert(position <= moves.size());
+    this->position = position;
+}
+
+template<size_t CUBE_SIZE>
+void MoveHistory<CUBE_SIZE>::Clear() {
+    moves.clear();
+    times.clear();
+    snapshots.resize(1);
+    last_state = FaceletPermutation<CUBE_SIZE>();
+    position = 0;
+}
+
+template<size_t CUBE_SIZE>
+void MoveHistory<CUBE_SIZE>::Save(const std::string &filename) const {
+    WriteSessionFile(filename, CUBE_SIZE, moves, times);
+}
+
+template<size_t CUBE_SIZE>
+void MoveHistory<CUBE_SIZE>::Load(const std::string &filename) {
+    size_t cube_size;
+    std::vector<uint8_t> loaded_moves;
+    std::vector<uint32_t> loaded_times;
+
+    ReadSessionFile(filename, cube_size, loaded_moves, loaded_times);
+    if(cube_size != CUBE_SIZE)
+        throw std::runtime_error("Session " + filename + " was recorded with other cube size");
+    Clear();
+    try {
+        for(size_t i=0; i<loaded_moves.size(); ++i)
+            Push(UnpackMove(loaded_moves[i], CUBE_SIZE), loaded_times[i]);
+    } catch(const std::invalid_argument &e) {
+        Clear();
+        throw std::runtime_error("Session " + filename + " has invalid moves");
+    }
+}
+
+#endif
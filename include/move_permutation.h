@@ -0,0 +1,317 @@
+#ifndef __RUBIK_MOVE_PERMUTATION_H__
+#define __RUBIK_MOVE_PERMUTATION_H__
+
+#include <cube_types.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+  * Compile time description of the quarter turns of a NxN cube. Face elements are identified by their
+  * position in the order of FaceletsToString: (face*cube_size + row)*cube_size + col.
+  *
+  * Tables are constexpr, so they are built by the compiler and stored in read only data: applying a move
+  * only reads them, and there is no setup at startup.
+  */
+
+/**
+  * @brief Returns position of a face element
+  */
+constexpr size_t GetFaceletPosition(size_t cube_size, FaceElement face, size_t row, size_t col) {
+    return ((size_t)face*cube_size + row)*cube_size + col;
+}
+
+/**
+  * @brief Returns position of an element of a layer. Elements are counted in clockwise order around the axis
+  * @pre depth < cube_size
+  * @param axis_face LEFT, TOP or FRONT. Selects axis X, Y or Z
+  * @param element_pos Position of the element in the layer. It is taken modulo 4*cube_size
+  * @param depth Depth of the layer, from RIGHT, TOP or FRONT faces
+  */
+constexpr size_t GetLayerFaceletPosition(size_t cube_size, FaceElement axis_face, long element_pos, size_t depth) {
+    const size_t num_layer_elements = 4*cube_size;
+    const size_t pos = (size_t)(((element_pos % (long)num_layer_elements) + (long)num_layer_elements) % (long)num_layer_elements);
+    const size_t face_element_pos = pos % cube_size;
+    const size_t neg_face_element_pos = cube_size-1 - face_element_pos;
+    const size_t neg_depth = cube_size-1 - depth;
+    const size_t side = pos / cube_size;
+    const size_t axis = axis_face == LEFT ? 0 : (axis_face == TOP ? 1 : 2);
+    const FaceElement face_selector[3][4] = {
+        { TOP,   BACK,   BOTTOM, FRONT }, // X axis
+        { FRONT, LEFT,   BACK,   RIGHT }, // Y axis
+        { RIGHT, BOTTOM, LEFT,   TOP   }  // Z axis
+    };
+    const size_t row_selector[3][4] = {
+        { neg_face_element_pos, face_element_pos, neg_face_element_pos, neg_face_element_pos }, // X axis
+        { depth,                depth,            depth,                depth                }, // Y axis
+        { face_element_pos,     depth,            neg_face_element_pos, neg_depth            }  // Z axis
+    };
+    const size_t col_selector[3][4] = {
+        { neg_depth,            depth,                neg_depth,            neg_depth            }, // X axis
+        { neg_face_element_pos, neg_face_element_pos, neg_face_element_pos, neg_face_element_pos }, // Y axis
+        { depth,                neg_face_element_pos, neg_depth,            face_element_pos     }  // Z axis
+    };
+    return GetFaceletPosition(cube_size, face_selector[axis][side], row_selector[axis][side], col_selector[axis][side]);
+}
+
+/**
+  * @brief Returns position of an element of a ring of a face. Elements are counted clockwise from the top left
+  *        corner of the ring
+  * @pre 2*padding+1 < cube_size
+  * @param face Face of the ring
+  * @param element_pos Position of the element in the ring. It is taken modulo the perimeter of the ring
+  * @param padding Distance of the ring to the border of the face
+  */
+constexpr size_t GetRingFaceletPosition(size_t cube_size, FaceElement face, long element_pos, size_t padding) {
+    const size_t min = padding;
+    const size_t max = cube_size-1 - padding;
+    const size_t edge_size = max-min;
+    const long perimeter = 4*edge_size;
+    const size_t pos = (size_t)(((element_pos % perimeter) + perimeter) % perimeter);
+    size_t row = max - (pos - 3*edge_size);
+    size_t col = min;
+    if(pos < edge_size) {
+        row = min;
+        col = min + pos;
+    } else if(pos < 2*edge_size) {
+        row = min + (pos - edge_size);
+        col = max;
+    } else if(pos < 3*edge_size) {
+        row = max;
+        col = max - (pos - 2*edge_size);
+    }
+    return GetFaceletPosition(cube_size, face, row, col);
+}
+
+/**
+  * @brief Returns index of a quarter turn in move tables: (face*cube_size + depth)*2 + clockwise
+  */
+constexpr size_t GetMoveIndex(size_t cube_size, const Move &move) {
+    return ((size_t)move.face*cube_size + move.depth)*2 + (size_t)move.clockwise;
+}
+
+/**
+  * @brief Face elements changed by a quarter turn. The one at positions[i] comes from sources[i]
+  */
+template<size_t CUBE_SIZE>
+struct SparseMovePermutation {
+    // A face and the lateral rows of its layer, at most
+    static constexpr size_t MAX_MOVED = CUBE_SIZE*CUBE_SIZE + 4*CUBE_SIZE;
+
+    size_t num_positions;
+    std::array<uint16_t, MAX_MOVED> positions;
+    std::array<uint16_t, MAX_MOVED> sources;
+};
+
+/**
+  * @brief Computes the face elements changed by a quarter turn
+  * @pre Depth of the move is less than CUBE_SIZE
+  *
+  * Turning a layer rotates its lateral elements CUBE_SIZE positions, and outer layers also rotate the rings
+  * of their face. After the turn, the element at position p of a ring comes from position p+offset. Face
+  * and lateral elements don't overlap, and none of them stays in place, so each one is listed once.
+  */
+template<size_t CUBE_SIZE>
+constexpr SparseMovePermutation<CUBE_SIZE> MakeSparseMovePermutation(const Move &move) {
+    SparseMovePermutation<CUBE_SIZE> permutation = {};
+
+    // Face of the layer. Deepest layer is the opposite face, turned the other way
+    FaceElement face = INVALID;
+    Clockwise face_clockwise = move.clockwise;
+    if(move.depth == 0) {
+        face = move.face;
+    } else if(move.depth+1 == CUBE_SIZE) {
+        face = (FaceElement)(move.face ^ 1);
+        face_clockwise = move.clockwise == CLOCKWISE ? COUNTERCLOCKWISE : CLOCKWISE;
+    }
+    if(face != INVALID) {
+        for(size_t ring=0; ring<CUBE_SIZE/2; ++ring) {
+            const long border_length = CUBE_SIZE-1 - 2*ring;
+            const long offset = face_clockwise == CLOCKWISE ? -border_length : border_length;
+            for(long pos=0; pos<4*border_length; ++pos) {
+                permutation.positions[permutation.num_positions] = GetRingFaceletPosition(CUBE_SIZE, face, pos, ring);
+                permutation.sources[permutation.num_positions] = GetRingFaceletPosition(CUBE_SIZE, face, pos+offset, ring);
+                ++permutation.num_positions;
+            }
+        }
+    }
+
+    // Lateral elements. Layers are numbered from RIGHT, TOP or FRONT faces
+    const FaceElement axis_face = (move.face == LEFT || move.face == RIGHT) ? LEFT :
+                                  ((move.face == TOP || move.face == BOTTOM) ? TOP : FRONT);
+    const bool positive_face = move.face == FRONT || move.face == RIGHT || move.face == TOP;
+    const size_t depth = positive_face ? move.depth : CUBE_SIZE-1 - move.depth;
+    long offset = positive_face ? (long)CUBE_SIZE : -(long)CUBE_SIZE;
+    if(move.clockwise == CLOCKWISE)
+        offset = -offset;
+    for(long pos=0; pos<(long)(4*CUBE_SIZE); ++pos) {
+        permutation.positions[permutation.num_positions] = GetLayerFaceletPosition(CUBE_SIZE, axis_face, pos, depth);
+        permutation.sources[permutation.num_positions] = GetLayerFaceletPosition(CUBE_SIZE, axis_face, pos+offset, depth);
+        ++permutation.num_positions;
+    }
+    return permutation;
+}
+
+/**
+  * @brief Computes the face elements changed by all the quarter turns, indexed by GetMoveIndex
+  */
+template<size_t CUBE_SIZE>
+constexpr std::array<SparseMovePermutation<CUBE_SIZE>, 12*CUBE_SIZE> MakeSparseMovePermutations() {
+    std::array<SparseMovePermutation<CUBE_SIZE>, 12*CUBE_SIZE> permutations = {};
+    for(size_t face=0; face<6; ++face) {
+        for(size_t depth=0; depth<CUBE_SIZE; ++depth) {
+            for(size_t clockwise=0; clockwise<2; ++clockwise) {
+                Move move = {(FaceElement)face, (Clockwise)clockwise, depth};
+                permutations[GetMoveIndex(CUBE_SIZE, move)] = MakeSparseMovePermutation<CUBE_SIZE>(move);
+            }
+        }
+    }
+    return permutations;
+}
+
+/**
+  * @brief Checks if applying a sequence of moves some times leaves all the face elements in place
+  * @param moves Table of quarter turns (see MakeSparseMovePermutations)
+  * @param sequence Moves of the sequence
+  * @param num_moves Number of moves of the sequence
+  * @param repetitions Times the sequence is applied
+  * @param source Identity permutation of the face elements, used as scratch space. It is restored before
+  *               returning
+  *
+  * The sequence is applied once, so source[p] is the position the element at p comes from, and repetitions
+  * follow source from each position. Only positions changed by the moves can be out of place, so only they
+  * are checked and restored. Loops use plain arrays, which compilers evaluate several times faster than
+  * std::array, so checking the tables of a 20x20 cube takes about a second of compilation.
+  */
+template<size_t CUBE_SIZE>
+constexpr bool IsIdentitySequence(const std::array<SparseMovePermutation<CUBE_SIZE>, 12*CUBE_SIZE> &moves,
+                                  const Move *sequence, size_t num_moves, size_t repetitions, uint16_t *source) {
+    uint16_t moved[SparseMovePermutation<CUBE_SIZE>::MAX_MOVED] = {};
+    bool identity = true;
+    for(size_t i=0; i<num_moves; ++i) {
+        const SparseMovePermutation<CUBE_SIZE> &move = moves[GetMoveIndex(CUBE_SIZE, sequence[i])];
+        const uint16_t *positions = move.positions.data();
+        const uint16_t *sources = move.sources.data();
+        for(size_t j=0; j<move.num_positions; ++j)
+            moved[j] = source[sources[j]];
+        for(size_t j=0; j<move.num_positions; ++j)
+            source[positions[j]] = moved[j];
+    }
+    for(size_t i=0; i<num_moves && identity; ++i) {
+        const SparseMovePermutation<CUBE_SIZE> &move = moves[GetMoveIndex(CUBE_SIZE, sequence[i])];
+        const uint16_t *positions = move.positions.data();
+        for(size_t j=0; j<move.num_positions && identity; ++j) {
+            size_t position = positions[j];
+            for(size_t repetition=0; repetition<repetitions; ++repetition)
+                position = source[position];
+            identity = position == positions[j];
+        }
+    }
+    for(size_t i=0; i<num_moves; ++i) {
+        const SparseMovePermutation<CUBE_SIZE> &move = moves[GetMoveIndex(CUBE_SIZE, sequence[i])];
+        const uint16_t *positions = move.positions.data();
+        for(size_t j=0; j<move.num_positions; ++j)
+            source[positions[j]] = positions[j];
+    }
+    return identity;
+}
+
+/**
+  * @brief Checks that every quarter turn is undone by its inverse, and by applying it three more times
+  *
+  * With source[p] the position the element at p comes from after the turn, the inverse shall bring each one
+  * back from source[p] to p. Sources are replaced by an invalid position once used, so the inverse can't
+  * bring two elements to the same position.
+  */
+template<size_t CUBE_SIZE>
+constexpr bool HasMoveInverses(const std::array<SparseMovePermutation<CUBE_SIZE>, 12*CUBE_SIZE> &moves) {
+    const size_t num_facelets = 6*CUBE_SIZE*CUBE_SIZE;
+    uint16_t source[num_facelets] = {};
+    for(size_t i=0; i<num_facelets; ++i)
+        source[i] = i;
+    for(size_t face=0; face<6; ++face) {
+        for(size_t depth=0; depth<CUBE_SIZE; ++depth) {
+            const Move turn[1] = {{(FaceElement)face, CLOCKWISE, depth}};
+            const SparseMovePermutation<CUBE_SIZE> &move = moves[GetMoveIndex(CUBE_SIZE, turn[0])];
+            const SparseMovePermutation<CUBE_SIZE> &inverse =
+                moves[GetMoveIndex(CUBE_SIZE, {(FaceElement)face, COUNTERCLOCKWISE, depth})];
+            bool valid = move.num_positions == inverse.num_positions &&
+                         IsIdentitySequence<CUBE_SIZE>(moves, turn, 1, 4, source);
+
+            for(size_t j=0; j<move.num_positions; ++j)
+                source[move.positions.data()[j]] = move.sources.data()[j];
+            for(size_t j=0; j<inverse.num_positions && valid; ++j) {
+                const uint16_t position = inverse.positions.data()[j];
+                const uint16_t from = inverse.sources.data()[j];
+                valid = from != position && source[from] == position;
+                source[from] = num_facelets;
+            }
+            for(size_t j=0; j<move.num_positions; ++j)
+                source[move.positions.data()[j]] = move.positions.data()[j];
+            if(!valid)
+                return false;
+        }
+    }
+    return true;
+}
+
+/**
+  * @brief Checks that the sexy move, R U R' U', has order 6
+  */
+template<size_t CUBE_SIZE>
+constexpr bool HasSexyMoveOrder(const std::array<SparseMovePermutation<CUBE_SIZE>, 12*CUBE_SIZE> &moves) {
+    const Move sequence[4] = {
+        {RIGHT, CLOCKWISE, 0}, {TOP, CLOCKWISE, 0}, {RIGHT, COUNTERCLOCKWISE, 0}, {TOP, COUNTERCLOCKWISE, 0}
+    };
+    uint16_t source[6*CUBE_SIZE*CUBE_SIZE] = {};
+    for(size_t i=0; i<6*CUBE_SIZE*CUBE_SIZE; ++i)
+        source[i] = i;
+    return IsIdentitySequence<CUBE_SIZE>(moves, sequence, 4, 6, source) &&
+           !IsIdentitySequence<CUBE_SIZE>(moves, sequence, 4, 3, source) &&
+           !IsIdentitySequence<CUBE_SIZE>(moves, sequence, 4, 2, source);
+}
+
+/**
+  * @brief Checks that turning all the layers of an axis (a whole cube rotation, like x) four times leaves the
+  *        cube unchanged, and that layers of the same axis commute: R L R' L' is the identity
+  */
+template<size_t CUBE_SIZE>
+constexpr bool HasCommutingLayers(const std::array<SparseMovePermutation<CUBE_SIZE>, 12*CUBE_SIZE> &moves) {
+    const FaceElement axis_faces[3] = { RIGHT, TOP, FRONT };
+    uint16_t source[6*CUBE_SIZE*CUBE_SIZE] = {};
+    for(size_t i=0; i<6*CUBE_SIZE*CUBE_SIZE; ++i)
+        source[i] = i;
+    for(size_t axis=0; axis<3; ++axis) {
+        Move rotation[CUBE_SIZE] = {};
+        for(size_t depth=0; depth<CUBE_SIZE; ++depth)
+            rotation[depth] = {axis_faces[axis], CLOCKWISE, depth};
+        const FaceElement opposite = (FaceElement)(axis_faces[axis] ^ 1);
+        const Move commutator[4] = {
+            {axis_faces[axis], CLOCKWISE, 0}, {opposite, CLOCKWISE, 0},
+            {axis_faces[axis], COUNTERCLOCKWISE, 0}, {opposite, COUNTERCLOCKWISE, 0}
+        };
+        if(!IsIdentitySequence<CUBE_SIZE>(moves, rotation, CUBE_SIZE, 4, source) ||
+           IsIdentitySequence<CUBE_SIZE>(moves, rotation, CUBE_SIZE, 2, source) ||
+           !IsIdentitySequence<CUBE_SIZE>(moves, commutator, 4, 1, source))
+            return false;
+    }
+    return true;
+}
+
+/**
+  * @brief Quarter turns of a NxN cube, computed at compile time. Group identities are checked when it is
+  *        instantiated, so a wrong table doesn't compile
+  */
+template<size_t CUBE_SIZE>
+struct SparseMoveTable {
+    static_assert(CUBE_SIZE >= 2, "Cube size shall be at least 2");
+
+    static constexpr std::array<SparseMovePermutation<CUBE_SIZE>, 12*CUBE_SIZE> MOVES =
+        MakeSparseMovePermutations<CUBE_SIZE>();
+
+    static_assert(HasMoveInverses<CUBE_SIZE>(MOVES), "Quarter turns shall have order 4, and be undone by their inverses");
+    static_assert(HasSexyMoveOrder<CUBE_SIZE>(MOVES), "(R U R' U') shall have order 6");
+    static_assert(HasCommutingLayers<CUBE_SIZE>(MOVES), "Whole cube rotations shall have order 4, and R L = L R");
+};
+
+#endif
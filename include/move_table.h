@@ -0,0 +1,249 @@
+#ifndef __RUBIK_MOVE_TABLE_H__
+#define __RUBIK_MOVE_TABLE_H__
+
+#include <rubik.h>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+/**
+  * @brief Permutation of the face elements of a NxN cube. Face elements are indexed in the order of
+  *        FaceletsToString: (face*CUBE_SIZE + row)*CUBE_SIZE + col
+  *
+  * After applying the permutation, the face element at position i is the one which was at source[i].
+  */
+template<size_t CUBE_SIZE>
+class FaceletPermutation {
+public:
+    static const size_t NUM_FACELETS = 6*CUBE_SIZE*CUBE_SIZE;
+    typedef typename std::conditional<NUM_FACELETS <= 256, uint8_t, uint16_t>::type Index;
+
+private:
+    std::array<Index, NUM_FACELETS> source;
+
+public:
+    /**
+      * @brief Initializes the identity permutation
+      */
+    constexpr FaceletPermutation();
+
+    /**
+      * @brief Returns the permutation of a quarter turn, from the tables computed at compile time
+      * @param move Move of the permutation
+      */
+    static constexpr FaceletPermutation FromMove(const Move &move);
+
+    /**
+      * @brief Returns source position of the face element moved to 'position'
+      */
+    constexpr size_t GetSource(size_t position) const;
+
+    /**
+      * @brief Returns the permutation which applies this one and then 'next'
+      */
+    constexpr FaceletPermutation Then(const FaceletPermutation &next) const;
+
+    /**
+      * @brief Composes a permutation which only moves some positions after this one, in place. Faster than Then
+      *        for single moves, which leave most of the face elements in place
+      * @param positions Positions changed by the permutation
+      * @param sources Source of each position of 'positions'
+      * @param num_positions Number of changed positions
+      */
+    void ThenSparse(const uint16_t *positions, const uint16_t *sources, size_t num_positions);
+
+    /**
+      * @brief Returns the permutation which undoes this one
+      */
+    constexpr FaceletPermutation Inverse() const;
+
+    /**
+      * @brief Permutes an array of face elements
+      * @param input Array of NUM_FACELETS values
+      * @param output Permuted array. It shall not overlap 'input'
+      */
+    template<typename Value>
+    void Apply(const Value *input, Value *output) const;
+
+    /**
+      * @brief Checks if the permutation leaves a solved cube solved, in any orientation
+      */
+    constexpr bool IsSolving() const;
+
+    /**
+      * @brief Checks if two permutations move every face element alike
+      */
+    constexpr bool operator==(const FaceletPermutation &other) const;
+};
+
+
+/**
+  * @brief Permutations of all the quarter turns of a NxN cube, computed at compile time. Single moves are
+  *        applied with the sparse tables of move_permutation.h
+  */
+template<size_t CUBE_SIZE>
+class MoveTable {
+private:
+    std::array<FaceletPermutation<CUBE_SIZE>, 6*2*CUBE_SIZE> moves;
+
+    /**
+      * @brief Returns index of a move in the tables
+      */
+    static constexpr size_t GetMoveIndex(const Move &move);
+
+    constexpr MoveTable();
+
+public:
+    /**
+      * @brief Returns the table of this cube size. It is a constant, stored in read only data
+      */
+    static const MoveTable& Get();
+
+    /**
+      * @brief Returns the permutation of a quarter turn
+      * @pre Depth of the move is less than CUBE_SIZE
+      */
+    constexpr const FaceletPermutation<CUBE_SIZE>& GetMove(const Move &move) const;
+
+    /**
+      * @brief Composes the permutations of a sequence of moves
+      * @param moves Moves, in order
+      * @param permutation Permutation of the moves is composed after this one
+      */
+    void Compile(const std::vector<Move> &moves, FaceletPermutation<CUBE_SIZE> &permutation) const;
+
+    /**
+      * @brief Composes the permutation of a move after a permutation, in place
+      */
+    void ApplyMove(const Move &move, FaceletPermutation<CUBE_SIZE> &permutation) const;
+};
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+template<size_t CUBE_SIZE>
+constexpr FaceletPermutation<CUBE_SIZE>::FaceletPermutation()
+    : source()
+{
+    for(size_t i=0; i<NUM_FACELETS; ++i)
+        source[i] = i;
+}
+
+template<size_t CUBE_SIZE>
+constexpr FaceletPermutation<CUBE_SIZE> FaceletPermutation<CUBE_SIZE>::FromMove(const Move &move) {
+    const SparseMovePermutation<CUBE_SIZE> &sparse = SparseMoveTable<CUBE_SIZE>::MOVES[GetMoveIndex(CUBE_SIZE, move)];
+    FaceletPermutation permutation;
+    for(size_t i=0; i<sparse.num_positions; ++i)
+        permutation.source[sparse.positions[i]] = sparse.sources[i];
+    return permutation;
+}
+
+template<size_t CUBE_SIZE>
+constexpr size_t FaceletPermutation<CUBE_SIZE>::GetSource(size_t position) const {
+    assert(position < NUM_FACELETS);
+    return source[position];
+}
+
+template<size_t CUBE_SIZE>
+constexpr FaceletPermutation<CUBE_SIZE> FaceletPermutation<CUBE_SIZE>::Then(const FaceletPermutation &next) const {
+    FaceletPermutation result;
+    for(size_t i=0; i<NUM_FACELETS; ++i)
+        result.source[i] = source[next.source[i]];
+    return result;
+}
+
+template<size_t CUBE_SIZE>
+void FaceletPermutation<CUBE_SIZE>::ThenSparse(const uint16_t *positions, const uint16_t *sources, size_t num_positions) {
+    // Sources are read before writing, because they may be overwritten
+    Index moved[NUM_FACELETS];
+    for(size_t i=0; i<num_positions; ++i)
+        moved[i] = source[sources[i]];
+    for(size_t i=0; i<num_positions; ++i)
+        source[positions[i]] = moved[i];
+}
+
+template<size_t CUBE_SIZE>
+constexpr FaceletPermutation<CUBE_SIZE> FaceletPermutation<CUBE_SIZE>::Inverse() const {
+    FaceletPermutation result;
+    for(size_t i=0; i<NUM_FACELETS; ++i)
+        result.source[source[i]] = i;
+    return result;
+}
+
+template<size_t CUBE_SIZE>
+template<typename Value>
+void FaceletPermutation<CUBE_SIZE>::Apply(const Value *input, Value *output) const {
+    for(size_t i=0; i<NUM_FACELETS; ++i)
+        output[i] = input[source[i]];
+}
+
+template<size_t CUBE_SIZE>
+constexpr bool FaceletPermutation<CUBE_SIZE>::IsSolving() const {
+    // Color of a face element of the solved cube is the face of its position
+    const size_t face_size = CUBE_SIZE*CUBE_SIZE;
+    for(size_t face=0; face<6; ++face) {
+        size_t color = source[face*face_size] / face_size;
+        for(size_t i=1; i<face_size; ++i)
+            if(source[face*face_size + i] / face_size != color)
+                return false;
+    }
+    return true;
+}
+
+template<size_t CUBE_SIZE>
+constexpr bool FaceletPermutation<CUBE_SIZE>::operator==(const FaceletPermutation &other) const {
+    for(size_t i=0; i<NUM_FACELETS; ++i)
+        if(source[i] != other.source[i])
+            return false;
+    return true;
+}
+
+template<size_t CUBE_SIZE>
+constexpr MoveTable<CUBE_SIZE>::MoveTable()
+    : moves()
+{
+    for(int face=0; face<INVALID; ++face) {
+        for(size_t depth=0; depth<CUBE_SIZE; ++depth) {
+            for(int clockwise=0; clockwise<2; ++clockwise) {
+                Move move = {(FaceElement)face, (Clockwise)clockwise, depth};
+                moves[GetMoveIndex(move)] = FaceletPermutation<CUBE_SIZE>::FromMove(move);
+            }
+        }
+    }
+}
+
+template<size_t CUBE_SIZE>
+constexpr size_t MoveTable<CUBE_SIZE>::GetMoveIndex(const Move &move) {
+    assert(move.face >= 0 && move.face < INVALID);
+    assert(move.depth < CUBE_SIZE);
+    return ::GetMoveIndex(CUBE_SIZE, move);
+}
+
+template<size_t CUBE_SIZE>
+const MoveTable<CUBE_SIZE>& MoveTable<CUBE_SIZE>::Get() {
+    static constexpr MoveTable table;
+    return table;
+}
+
+template<size_t CUBE_SIZE>
+constexpr const FaceletPermutation<CUBE_SIZE>& MoveTable<CUBE_SIZE>::GetMove(const Move &move) const {
+    return moves[GetMoveIndex(move)];
+}
+
+template<size_t CUBE_SIZE>
+void MoveTable<CUBE_SIZE>::Compile(const std::vector<Move> &moves, FaceletPermutation<CUBE_SIZE> &permutation) const {
+    for(size_t i=0; i<moves.size(); ++i)
+        ApplyMove(moves[i], permutation);
+}
+
+template<size_t CUBE_SIZE>
+void MoveTable<CUBE_SIZE>::ApplyMove(const Move &move, FaceletPermutation<CUBE_SIZE> &permutation) const {
+    const SparseMovePermutation<CUBE_SIZE> &sparse = SparseMoveTable<CUBE_SIZE>::MOVES[GetMoveIndex(move)];
+    permutation.ThenSparse(sparse.positions.data(), sparse.sources.data(), sparse.num_positions);
+}
+
+#endif
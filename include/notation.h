@@ -0,0 +1,59 @@
+#ifndef __RUBIK_NOTATION_H__
+#define __RUBIK_NOTATION_H__
+
+#include <rubik.h>
+#include <string>
+#include <vector>
+
+/**
+  * @brief Parses a sequence of moves written in standard cube notation
+  *
+  * Moves are separated by spaces. Each move is a face letter (F, B, L, R, U, D), optionally preceded
+  * by the layer number (starting from 1, so "2R" is the layer next to R) and followed by "'" for
+  * counterclockwise turns, or "2" for half turns. Half turns produce two quarter turns.
+  * @param text Sequence of moves. For example "R U R' U' 2F2"
+  * @param cube_size Size of the cube the moves apply to
+  * @return Quarter turns, in order
+  * @throw std::invalid_argument if some move is malformed or its layer doesn't exist
+  */
+std::vector<Move> ParseMoves(const std::string &text, size_t cube_size);
+
+/**
+  * @brief Parses a sequence of moves, like ParseMoves(text, cube_size), without allocating intermediate strings
+  * @param begin First character of the text
+  * @param end End of the text
+  * @param cube_size Size of the cube the moves apply to
+  * @param moves Parsed quarter turns are appended to this vector
+  * @throw std::invalid_argument if some move is malformed or its layer doesn't exist. Moves before it are
+  *        already appended
+  */
+void ParseMoves(const char *begin, const char *end, size_t cube_size, std::vector<Move> &moves);
+
+/**
+  * @brief Converts a move to standard cube notation
+  * @param move Move to convert
+  * @return Move in standard notation. For example "R'" or "2U"
+  */
+std::string MoveToString(const Move &move);
+
+/**
+  * @brief Converts a sequence of moves to standard cube notation. Consecutive equal moves are written as half turns
+  * @param moves Moves to convert
+  * @return Moves separated by spaces
+  */
+std::string MovesToString(const std::vector<Move> &moves);
+
+/**
+  * @brief Returns the move which undoes another move
+  * @param move Move to invert
+  * @return Same layer, with reversed clockwise
+  */
+Move InverseMove(const Move &move);
+
+/**
+  * @brief Compares two moves
+  * @return True if both moves rotate the same layer in the same direction
+  */
+bool operator==(const Move &a, const Move &b);
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef __RUBIK_PEEPHOLE_OPTIMIZER_H__
+#define __RUBIK_PEEPHOLE_OPTIMIZER_H__
+
+#include <rubik.h>
+#include <move_generator.h>
+#include <move_table.h>
+#include <thread_pool.h>
+#include <tools.h>
+#include <vector>
+#include <future>
+
+/**
+  * Peephole optimization of move sequences, such as the long solutions of human methods: each window of a
+  * few consecutive moves is replaced by a shortest sequence with the same permutation of face elements, found
+  * by an iterative deepening search over the moves of MoveGenerator. Windows are searched in parallel, then
+  * the improved windows which don't overlap are replaced, from first to last, and the sequence is searched
+  * again until no window improves.
+  *
+  * Replacements have the same permutation, so the optimized sequence leaves any cube (and the objects
+  * associated to its face elements) in the same state as the original one. Turns of the middle layer of odd
+  * cubes are not moves of the searches, so they are only removed when their windows don't need them.
+  */
+
+/*    Statistics of an optimization    */
+struct PeepholeStats {
+    size_t original_length = 0;  // Quarter turns
+    size_t optimized_length = 0; // Quarter turns
+    size_t passes = 0;           // Searches of all the windows
+    size_t windows = 0;          // Searched windows, over all the passes
+    double latency = 0.0;        // Seconds
+};
+
+/**
+  * @brief Shortens a sequence of moves by replacing windows of it with shortest equivalent sequences
+  * @param moves Quarter turns, like the ones of ParseMoves
+  * @param window Quarter turns of each window. Searches go up to window-1 moves, so time grows with the
+  *               number of moves of MoveGenerator<CUBE_SIZE> to the power of window-1
+  * @param pool Threads which search the windows. It shall not be one of its own tasks
+  * @param stats Output statistics. Ignored if null
+  * @return Optimized quarter turns
+  */
+template<size_t CUBE_SIZE>
+std::vector<Move> OptimizeMoves(const std::vector<Move> &moves, size_t window, ThreadPool &pool,
+                                PeepholeStats *stats = nullptr);
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+/**
+  * @brief Depth-limited search of a sequence with a given permutation
+  * @param current Permutation of the path
+  * @param state State of the generator after the path
+  * @return True if a sequence was found. The path leading to it is kept
+  */
+template<size_t CUBE_SIZE>
+bool SearchEquivalentMoves(const FaceletPermutation<CUBE_SIZE> &current, const FaceletPermutation<CUBE_SIZE> &target,
+                           const MoveGenerator<CUBE_SIZE> &generator, size_t state, size_t remaining,
+                           std::vector<Move> &path) {
+    const MoveTable<CUBE_SIZE> &table = MoveTable<CUBE_SIZE>::Get();
+    if(current == target)
+        return true;
+    if(remaining == 0)
+        return false;
+
+    const std::vector<typename MoveGenerator<CUBE_SIZE>::Successor> &successors = generator.GetSuccessors(state);
+    size_t path_size = path.size();
+    for(size_t i=0; i<successors.size(); ++i) {
+        const SearchMove &move = generator.GetMove(successors[i].move);
+        FaceletPermutation<CUBE_SIZE> next = current;
+        for(size_t turn=0; turn<move.num_quarter_turns; ++turn)
+            table.ApplyMove(move.move, next);
+        generator.AppendMove(successors[i].move, path);
+        if(SearchEquivalentMoves(next, target, generator, successors[i].state, remaining-1, path))
+            return true;
+        path.resize(path_size);
+    }
+    return false;
+}
+
+/**
+  * @brief Searches a shortest sequence with the permutation of a window
+  * @return Shortest sequence. The window itself if there is no shorter one
+  */
+template<size_t CUBE_SIZE>
+std::vector<Move> ShortenWindow(const std::vector<Move> &window, const MoveGenerator<CUBE_SIZE> &generator) {
+    FaceletPermutation<CUBE_SIZE> target;
+    std::vector<Move> path;
+    MoveTable<CUBE_SIZE>::Get().Compile(window, target);
+    for(size_t depth=0; depth<window.size(); ++depth) {
+        path.clear();
+        if(SearchEquivalentMoves(FaceletPermutation<CUBE_SIZE>(), target, generator, MoveGenerator<CUBE_SIZE>::START,
+                                 depth, path))
+            return path;
+    }
+    return window;
+}
+
+template<size_t CUBE_SIZE>
+std::vector<Move> OptimizeMoves(const std::vector<Move> &moves, size_t window, ThreadPool &pool,
+                                PeepholeStats *stats) {
+    const MoveGenerator<CUBE_SIZE> generator(QUARTER_TURN_METRIC);
+    std::vector<Move> optimized = moves;
+    PeepholeStats local_stats;
+    double start = get_monotonic_time();
+    bool improved = true;
+
+    if(stats == nullptr)
+        stats = &local_stats;
+    *stats = PeepholeStats();
+    stats->original_length = moves.size();
+    window = std::max<size_t>(window, 2);
+
+    while(improved) {
+        // Windows start at every move, and are shorter only if the whole sequence is
+        size_t length = std::min(window, optimized.size());
+        std::vector<std::future<std::vector<Move>>> results;
+        for(size_t i=0; i+length<=optimized.size() && length>0; ++i) {
+            std::vector<Move> moves_window(optimized.begin() + i, optimized.begin() + i + length);
+            results.push_back(pool.Submit([moves_window, &generator]() {
+                return ShortenWindow<CUBE_SIZE>(moves_window, generator);
+            }));
+        }
+        ++stats->passes;
+        stats->windows += results.size();
+
+        std::vector<Move> next;
+        size_t position = 0;
+        improved = false;
+        for(size_t i=0; i<results.size(); ++i) {
+            std::vector<Move> shortened = results[i].get();
+            if(i < position || shortened.size() >= length)
+                continue;
+            next.insert(next.end(), optimized.begin() + position, optimized.begin() + i);
+            next.insert(next.end(), shortened.begin(), shortened.end());
+            position = i + length;
+            improved = true;
+        }
+        next.insert(next.end(), optimized.begin() + position, optimized.end());
+        optimized.swap(next);
+    }
+
+    stats->optimized_length = optimized.size();
+    stats->latency = get_monotonic_time() - start;
+    return optimized;
+}
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef __RUBIK_PROFILER_H__
+#define __RUBIK_PROFILER_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ctime>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+  * Scoped profiling. PROFILE_SCOPE("name") measures the time until the end of the enclosing scope.
+  * Measures are kept in a buffer per thread and saved in Chrome trace-event format (chrome://tracing,
+  * Perfetto). Scopes are only compiled when RUBIK_PROFILING is defined (make PROFILE=1), so they
+  * cost nothing in normal builds. Enabled scopes take no lock and allocate nothing: two reads of the
+  * time stamp counter, and three stores at the cursor of the thread's buffer.
+  */
+#ifdef RUBIK_PROFILING
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
+
+/*    Measured scope. Name must be a string literal (it is not copied)    */
+struct ProfileEvent {
+    const char *name;
+    uint64_t start;    // Ticks (see GetProfileTicks)
+    uint64_t duration; // Ticks
+};
+
+/*    Measures of a thread. Only its own thread writes on it    */
+struct ProfileBuffer {
+    // Events are kept in chunks of a huge page, so a measure rarely allocates memory or takes a page fault,
+    // and it never moves old events
+    static const size_t CHUNK_BYTES = 2 << 20;
+    static const size_t CHUNK_SIZE = CHUNK_BYTES / sizeof(ProfileEvent);
+
+    uint32_t thread_id;
+    // Next free event of the last chunk, and end of that chunk. Both are null before the first chunk
+    ProfileEvent *cursor = nullptr;
+    ProfileEvent *chunk_end = nullptr;
+    std::vector<ProfileEvent*> chunks; // Never freed, like the buffer
+    // Chunks with events. Chunks after them are kept by Clear, so later measures reuse their memory
+    size_t num_used_chunks = 0;
+
+    /**
+      * @brief Adds a measure to the buffer
+      */
+    void Push(const char *name, uint64_t start, uint64_t duration) {
+        if(cursor == chunk_end)
+            AddChunk();
+        cursor->name = name;
+        cursor->start = start;
+        cursor->duration = duration;
+        ++cursor;
+    }
+
+    /**
+      * @brief Moves to the next chunk, allocating it if there is none. Its pages are touched here, so
+      *        measures don't take page faults
+      */
+    void AddChunk();
+
+    /**
+      * @brief Returns number of saved events
+      */
+    size_t GetNumEvents() const {
+        return num_used_chunks == 0 ? 0 : (num_used_chunks-1) * CHUNK_SIZE +
+                                          (cursor - chunks[num_used_chunks-1]);
+    }
+
+    /**
+      * @brief Returns a saved event
+      * @pre index in range [0, GetNumEvents())
+      */
+    const ProfileEvent& GetEvent(size_t index) const {
+        return chunks[index / CHUNK_SIZE][index % CHUNK_SIZE];
+    }
+
+    /**
+      * @brief Discards all events. Chunks are kept for later measures
+      */
+    void Clear() {
+        num_used_chunks = 0;
+        cursor = chunk_end = nullptr;
+    }
+};
+
+/**
+  * @brief Returns the buffer of a new thread, registered to be saved in the trace
+  * @return Buffer of the thread. It is never freed, so measures are kept after the thread ends
+  */
+ProfileBuffer* RegisterProfileBuffer();
+
+/**
+  * @brief Saves measures of all threads in Chrome trace-event JSON format
+  * @pre No other thread is measuring scopes while the trace is written
+  * @param filename Path of the trace file
+  * @throw std::runtime_error if the file could not be written
+  */
+void WriteProfileTrace(const std::string &filename);
+
+/**
+  * @brief Saves measures to the file given by the RUBIK_TRACE environment variable, if it is set.
+  *        "%p" in the path is replaced by the process id, so forked processes don't overwrite each other.
+  *        It is called at exit in profiling builds, and it does nothing in other builds
+  * @pre No other thread is measuring scopes while the trace is written
+  */
+void SaveProfileTrace();
+
+/**
+  * @brief Discards all measures
+  * @pre No other thread is measuring scopes
+  */
+void ClearProfile();
+
+/**
+  * @brief Returns current time, in ticks of a monotonic counter. Ticks are converted to nanoseconds
+  *        when the trace is written, by comparing the counter with the monotonic clock
+  * @return Time stamp counter on x86 (invariant on any recent CPU), which is several times cheaper than
+  *         clock_gettime. Nanoseconds of the monotonic clock on other architectures
+  */
+inline uint64_t GetProfileTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + t.tv_nsec;
+#endif
+}
+
+/**
+  * @brief Returns buffer of calling thread
+  */
+inline ProfileBuffer& GetProfileBuffer() {
+    // Constant initialized, so it is read without the guard of a dynamic initialization
+    thread_local ProfileBuffer *buffer = nullptr;
+    if(buffer == nullptr)
+        buffer = RegisterProfileBuffer();
+    return *buffer;
+}
+
+/**
+  * @brief Measures time between its construction and its destruction. Use it through PROFILE_SCOPE
+  */
+class ProfileScope {
+private:
+    const char *name;
+    uint64_t start;
+
+public:
+    explicit ProfileScope(const char *name) : name(name), start(GetProfileTicks()) {}
+
+    ~ProfileScope() {
+        uint64_t end = GetProfileTicks();
+        GetProfileBuffer().Push(name, start, end - start);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef __RUBIK_PRUNING_TABLES_H__
+#define __RUBIK_PRUNING_TABLES_H__
+
+#include <coordinate_tables.h>
+#include <thread_pool.h>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+  * Pruning tables of 3x3 coordinates: the distance to the solved state of each pair of values of two
+  * coordinates (see coordinate_tables.h). It is a lower bound of the distance of any state with those values,
+  * so IDA* searches skip the moves after which the largest bound exceeds the remaining moves.
+  *
+  * Distances are in quarter turns, like the solutions of SolveIDDFS, and are found by a breadth first search
+  * over the move tables. Tables take tens of megabytes, so searches spend most of their time waiting for
+  * entries which are not cached. Packed layouts fit more entries in each cache line and page:
+  *   - A byte per entry, with the distance
+  *   - 4 bits per entry, with the distance (at most 11)
+  *   - 2 bits per entry, with the distance modulo 3. Distances of the states before and after a move differ
+  *     by at most one, so the distance of a child follows from the one of its parent and its value modulo 3.
+  *     Searches keep the distances of their nodes, and only the root needs a walk to the solved state
+  *
+  * Entries live in anonymous mappings which are advised to use transparent huge pages, so lookups spread
+  * over the tables need fewer TLB entries.
+  */
+
+/*    Coordinates of a pruning table. Entries are indexed by first*COORDINATE_SIZES[second] + second    */
+struct PruningPair {
+    Coordinate3 first;
+    Coordinate3 second;
+};
+
+const size_t NUM_PRUNING_TABLES = 3;
+
+const PruningPair PRUNING_PAIRS[NUM_PRUNING_TABLES] = {
+    {CORNER_TWIST_COORD, SLICE_PERMUTATION_COORD},  // 26M entries
+    {EDGE_FLIP_COORD, SLICE_PERMUTATION_COORD},     // 24M entries
+    {CORNER_PERMUTATION_COORD, SLICE_COORD}         // 20M entries
+};
+
+/*    Layout of the entries of the tables    */
+typedef enum {
+    BYTE_PRUNING = 0, // 8 bits per entry, with the distance
+    NIBBLE_PRUNING,   // 4 bits per entry, with the distance
+    MOD3_PRUNING,     // 2 bits per entry, with the distance modulo 3
+    NUM_PRUNING_LAYOUTS
+} PruningLayout;
+
+/*    Value of the entries which have not been reached yet by the generation    */
+const uint8_t PRUNING_UNKNOWN = 0xff;
+
+/*    Size of the transparent huge pages the tables are aligned to    */
+const size_t PRUNING_HUGE_PAGE_SIZE = 2 << 20;
+
+/**
+  * @brief Returns the name of a layout, as read and written by rubikctl
+  */
+const char* GetPruningLayoutName(PruningLayout layout);
+
+/**
+  * @brief Returns the quarter turns of the coordinate move tables, in the order of the moves of
+  *        MoveGenerator<3>(QUARTER_TURN_METRIC)
+  * @return Index in range [0, NUM_COORDINATE_MOVES) of each quarter turn
+  */
+std::vector<size_t> GetQuarterTurnCoordinateMoves();
+
+/**
+  * @brief Distances of the pairs of coordinates of PRUNING_PAIRS
+  */
+class PruningTables {
+private:
+    PruningLayout layout;
+    uint8_t *tables[NUM_PRUNING_TABLES];
+    size_t mapping_sizes[NUM_PRUNING_TABLES];
+    unsigned entry_shift;  // Entries of a byte are 1 << entry_shift
+    unsigned bits_shift;   // Bits of an entry are 8 >> entry_shift, so its offset is (index & entry_mask) << bits_shift
+    uint32_t entry_mask;
+    uint8_t value_mask;
+
+    /**
+      * @brief Fills a table by a breadth first search from the solved state, a byte per entry. Layers are
+      *        expanded forwards while few entries are known, and backwards (each unknown entry looks for a
+      *        neighbour in the last layer) once most of them are
+      */
+    static void Generate(size_t table, const CoordinateTables &coordinates, std::vector<uint8_t> &distances);
+
+    /**
+      * @brief Stores the distances of a table in its layout
+      */
+    void Pack(size_t table, const std::vector<uint8_t> &distances);
+
+public:
+    /**
+      * @brief Generates the tables. Each table is searched by a thread of the pool
+      * @param layout Layout of the entries
+      * @param huge_pages If false, transparent huge pages are not requested (they may still be used if the
+      *                   system enables them for every mapping)
+      * @throw std::bad_alloc if the tables could not be mapped
+      */
+    PruningTables(const CoordinateTables &coordinates, ThreadPool &pool, PruningLayout layout = BYTE_PRUNING,
+                  bool huge_pages = true);
+
+    ~PruningTables();
+
+    PruningTables(const PruningTables&) = delete;
+    PruningTables& operator=(const PruningTables&) = delete;
+
+    PruningLayout GetLayout() const;
+
+    /**
+      * @brief Returns the number of entries of a table
+      * @pre table < NUM_PRUNING_TABLES
+      */
+    static size_t GetSize(size_t table);
+
+    /**
+      * @brief Returns the index of the entry of a pair of coordinate values
+      * @pre table < NUM_PRUNING_TABLES, and values are in range of their coordinates
+      */
+    static uint32_t GetIndex(size_t table, uint32_t first, uint32_t second);
+
+    /**
+      * @brief Returns the value of an entry: its distance, or its distance modulo 3 for MOD3_PRUNING
+      * @pre table < NUM_PRUNING_TABLES, index < GetSize(table)
+      */
+    uint8_t GetValue(size_t table, uint32_t index) const;
+
+    /**
+      * @brief Returns the address of the byte of an entry, to prefetch it
+      */
+    const uint8_t* GetAddress(size_t table, uint32_t index) const;
+
+    /**
+      * @brief Returns the distance of an entry from its value and the distance of a neighbour entry (one
+      *        move away). Only MOD3_PRUNING needs the neighbour
+      */
+    uint8_t GetNeighbourDistance(uint8_t value, uint8_t neighbour_distance) const;
+
+    /**
+      * @brief Replaces values of entries with their distances, as GetNeighbourDistance, for entries which
+      *        share the neighbour. The loop has no branches, so the compiler vectorizes it
+      * @param values Array of COUNT values
+      */
+    template<size_t COUNT>
+    void GetNeighbourDistances(uint8_t neighbour_distance, uint8_t *values) const;
+
+    /**
+      * @brief Returns the distance of an entry in any layout. For MOD3_PRUNING, it walks to the solved state
+      *        with the coordinate move tables, so searches use it for the root only
+      */
+    uint8_t GetDistance(size_t table, uint32_t index, const CoordinateTables &coordinates) const;
+
+    /**
+      * @brief Returns bytes of the entries of all the tables
+      */
+    size_t GetMemoryUsage() const;
+};
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+inline PruningLayout PruningTables::GetLayout() const {
+    return layout;
+}
+
+inline size_t PruningTables::GetSize(size_t table) {
+    assert(table < NUM_PRUNING_TABLES);
+    return (size_t)COORDINATE_SIZES[PRUNING_PAIRS[table].first] * COORDINATE_SIZES[PRUNING_PAIRS[table].second];
+}
+
+inline uint32_t PruningTables::GetIndex(size_t table, uint32_t first, uint32_t second) {
+    return first * COORDINATE_SIZES[PRUNING_PAIRS[table].second] + second;
+}
+
+inline uint8_t PruningTables::GetValue(size_t table, uint32_t index) const {
+    assert(index < GetSize(table));
+    return tables[table][index >> entry_shift] >> ((index & entry_mask) << bits_shift) & value_mask;
+}
+
+inline const uint8_t* PruningTables::GetAddress(size_t table, uint32_t index) const {
+    return tables[table] + (index >> entry_shift);
+}
+
+inline uint8_t PruningTables::GetNeighbourDistance(uint8_t value, uint8_t neighbour_distance) const {
+    if(layout != MOD3_PRUNING)
+        return value;
+    // The difference modulo 3 is 0, 1 or 2 for the same distance, one more, or one less
+    return neighbour_distance + (value + 4 - neighbour_distance % 3) % 3 - 1;
+}
+
+template<size_t COUNT>
+void PruningTables::GetNeighbourDistances(uint8_t neighbour_distance, uint8_t *values) const {
+    if(layout != MOD3_PRUNING)
+        return;
+    // Sums are below 9, so two conditional subtractions take them modulo 3 without a division
+    const uint8_t offset = 4 - neighbour_distance % 3;
+    for(size_t i=0; i<COUNT; ++i) {
+        uint8_t sum = values[i] + offset;
+        sum -= sum >= 3 ? 3 : 0;
+        sum -= sum >= 3 ? 3 : 0;
+        values[i] = neighbour_distance + sum - 1;
+    }
+}
+
+#endif
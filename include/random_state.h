@@ -0,0 +1,149 @@
+#ifndef __RUBIK_RANDOM_STATE_H__
+#define __RUBIK_RANDOM_STATE_H__
+
+#include <rubik.h>
+#include <state_encoding.h>
+#include <thread_pool.h>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+/**
+  * Uniform sampling of reachable states. Instead of applying random moves, random coordinates are drawn
+  * (see PackState3): every combination of coordinates is a reachable state, because the edge permutation
+  * parity is fixed up to match the corner one when decoding.
+  */
+
+/*    States generated with each stream by GenerateRandomStates3    */
+const size_t RANDOM_STATES_BLOCK = 65536;
+
+/**
+  * @brief Pseudo random number generator (xoshiro256**). Streams are identified by a seed and a stream number,
+  *        so parallel tasks get independent and reproducible sequences
+  */
+class RandomStream {
+private:
+    uint64_t state[4];
+
+public:
+    /**
+      * @brief Initializes the stream
+      * @param seed Seed shared by all the streams of a run
+      * @param stream Number of the stream
+      */
+    explicit RandomStream(uint64_t seed, uint64_t stream = 0);
+
+    /**
+      * @brief Returns next 64 bit random value
+      */
+    uint64_t Next();
+
+    /**
+      * @brief Returns an unbiased random value in range [0, bound)
+      * @pre bound is not zero
+      */
+    uint64_t NextBelow(uint64_t bound);
+
+    /**
+      * @brief Creates a new stream seeded from this one. Both streams can be used independently
+      */
+    RandomStream Split();
+};
+
+
+/**
+  * @brief Writes a uniformly random coordinate packed 3x3 state, with centers at their solved positions
+  * @param random Random stream
+  * @param data Output buffer of STATE3_SIZE bytes
+  */
+void RandomState3(RandomStream &random, uint8_t *data);
+
+/**
+  * @brief Writes consecutive random coordinate packed 3x3 states
+  * @param random Random stream
+  * @param num_states Number of states
+  * @param data Output buffer of num_states*STATE3_SIZE bytes
+  */
+void RandomStates3(RandomStream &random, size_t num_states, uint8_t *data);
+
+/**
+  * @brief Writes random coordinate packed 3x3 states in parallel. Block i of RANDOM_STATES_BLOCK states uses
+  *        RandomStream(seed, i), so the output only depends on the seed, not on the number of threads
+  * @param seed Seed of the run
+  * @param num_states Number of states
+  * @param data Output buffer of num_states*STATE3_SIZE bytes
+  * @param pool Threads which generate the blocks
+  */
+void GenerateRandomStates3(uint64_t seed, size_t num_states, uint8_t *data, ThreadPool &pool);
+
+/**
+  * @brief Writes face elements of a uniformly random 3x3 state, with centers at their solved positions
+  * @param facelets Output face elements, in the order of FaceletsToString
+  */
+void RandomFacelets3(RandomStream &random, FaceElement *facelets);
+
+/**
+  * @brief Writes face elements of a uniformly random 2x2 state, including whole cube orientations
+  * @param facelets Output face elements (24), in the order of FaceletsToString
+  */
+void RandomFacelets2(RandomStream &random, FaceElement *facelets);
+
+/**
+  * @brief Sets a cube to a uniformly random state
+  * @param random Random stream
+  * @param cube 2x2 or 3x3 cube. Associated objects are kept
+  * @throw std::invalid_argument with other cube sizes
+  */
+template<typename T, size_t CUBE_SIZE>
+void RandomizeCube(RandomStream &random, RubikCube<T, CUBE_SIZE> &cube);
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+inline uint64_t RandomStream::Next() {
+    uint64_t result = state[1] * 5;
+    result = ((result << 7) | (result >> 57)) * 9;
+    uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = (state[3] << 45) | (state[3] >> 19);
+    return result;
+}
+
+inline uint64_t RandomStream::NextBelow(uint64_t bound) {
+    // Multiply and shift, rejecting the low products which would bias the result
+    unsigned __int128 product = (unsigned __int128)Next() * bound;
+    uint64_t low = (uint64_t)product;
+    if(low < bound) {
+        uint64_t threshold = -bound % bound;
+        while(low < threshold) {
+            product = (unsigned __int128)Next() * bound;
+            low = (uint64_t)product;
+        }
+    }
+    return product >> 64;
+}
+
+template<typename T, size_t CUBE_SIZE>
+void RandomizeCube(RandomStream &random, RubikCube<T, CUBE_SIZE> &cube) {
+    FaceElement facelets[NUM_FACELETS3];
+    size_t i = 0;
+    if(CUBE_SIZE == 3)
+        RandomFacelets3(random, facelets);
+    else if(CUBE_SIZE == 2)
+        RandomFacelets2(random, facelets);
+    else
+        throw std::invalid_argument("Random states are only defined for 2x2 and 3x3 cubes");
+    for(int face=0; face<INVALID; ++face)
+        for(size_t row=0; row<CUBE_SIZE; ++row)
+            for(size_t col=0; col<CUBE_SIZE; ++col)
+                cube.SetFaceElement((FaceElement)face, row, col, facelets[i++]);
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef __RUBIK_RELATIVE_STATE_H__
+#define __RUBIK_RELATIVE_STATE_H__
+
+#include <rubik.h>
+#include <vector>
+#include <stdexcept>
+
+/**
+  * Reduction of "turn state A into state B" to "solve a state", so solvers and their tables, which only know
+  * the solved state, are reused for any target. States are seen as the permutation of the face elements of
+  * the solved cube: the relative state is B^-1 * A, where each face element of A is recolored by the face
+  * where the same face element is found in B. A sequence of moves solves the relative state if, and only if,
+  * it turns A into B, maybe in another orientation of the whole cube (like solved means any orientation).
+  *
+  * A face element is identified by its color and the colors of its piece, so the reduction is only defined
+  * when all of them are different: 2x2 and 3x3 cubes.
+  */
+
+/**
+  * @brief Computes the relative state of two states
+  * @param source Face elements of the state to turn, in the order of FaceletsToString
+  * @param target Face elements of the state to reach
+  * @param cube_size Size of the cubes
+  * @param relative Output face elements of the state to solve
+  * @throw std::invalid_argument if face elements of a state can't be told apart, or they are not the same
+  *        face elements in both states
+  */
+void GetRelativeFacelets(const FaceElement *source, const FaceElement *target, size_t cube_size,
+                         FaceElement *relative);
+
+/**
+  * @brief Computes the relative state of two cubes. See GetRelativeFacelets
+  * @param relative Output cube to solve. Associated objects are kept
+  */
+template<typename T, size_t CUBE_SIZE, typename U>
+void GetRelativeState(const RubikCube<T, CUBE_SIZE> &source, const RubikCube<T, CUBE_SIZE> &target,
+                      RubikCube<U, CUBE_SIZE> &relative);
+
+/**
+  * @brief Searches moves which turn a cube into another one, with a solver of the solved state
+  * @param source Cube to turn
+  * @param target Cube to reach, in any orientation of the whole cube
+  * @param solver Callable object as bool(const RubikCube<int, CUBE_SIZE> &cube, std::vector<Move> &solution),
+  *               like SolveIDDFS with a bound of the depth
+  * @param solution Output moves
+  * @return Value returned by the solver
+  * @throw std::invalid_argument as GetRelativeFacelets
+  */
+template<typename T, size_t CUBE_SIZE, typename Solver>
+bool SolveBetween(const RubikCube<T, CUBE_SIZE> &source, const RubikCube<T, CUBE_SIZE> &target, Solver solver,
+                  std::vector<Move> &solution);
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+template<typename T, size_t CUBE_SIZE, typename U>
+void GetRelativeState(const RubikCube<T, CUBE_SIZE> &source, const RubikCube<T, CUBE_SIZE> &target,
+                      RubikCube<U, CUBE_SIZE> &relative) {
+    const size_t num_facelets = 6*CUBE_SIZE*CUBE_SIZE;
+    FaceElement source_facelets[num_facelets];
+    FaceElement target_facelets[num_facelets];
+    FaceElement relative_facelets[num_facelets];
+    size_t i = 0;
+
+    for(int face=0; face<INVALID; ++face) {
+        for(size_t row=0; row<CUBE_SIZE; ++row) {
+            for(size_t col=0; col<CUBE_SIZE; ++col) {
+                source_facelets[i] = source.GetFaceElement((FaceElement)face, row, col);
+                target_facelets[i++] = target.GetFaceElement((FaceElement)face, row, col);
+            }
+        }
+    }
+    GetRelativeFacelets(source_facelets, target_facelets, CUBE_SIZE, relative_facelets);
+    i = 0;
+    for(int face=0; face<INVALID; ++face)
+        for(size_t row=0; row<CUBE_SIZE; ++row)
+            for(size_t col=0; col<CUBE_SIZE; ++col)
+                relative.SetFaceElement((FaceElement)face, row, col, relative_facelets[i++]);
+}
+
+template<typename T, size_t CUBE_SIZE, typename Solver>
+bool SolveBetween(const RubikCube<T, CUBE_SIZE> &source, const RubikCube<T, CUBE_SIZE> &target, Solver solver,
+                  std::vector<Move> &solution) {
+    RubikCube<int, CUBE_SIZE> relative;
+    GetRelativeState(source, target, relative);
+    return solver(relative, solution);
+}
+
+#endif
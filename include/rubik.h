@@ -1,24 +1,16 @@
+#ifndef __RUBIK_RUBIK_H__
+#define __RUBIK_RUBIK_H__
+
 #include <iostream>
 #include <tools.h>
+#include <profiler.h>
+#include <cube_types.h>
+#include <move_permutation.h>
+#include <zobrist.h>
 #include <cassert>
 #include <array>
-
-/*    Clockwise to rotate face    */
-typedef enum { 
-    CLOCKWISE = 0, COUNTERCLOCKWISE 
-} Clockwise;
-
-/*    Face of the cube. Total: 6    */
-typedef enum
-    { 
-     FRONT = 0, // ORDER IS PART OF THE INTERFACE. DON'T CHANGE IT
-     BACK, 
-     LEFT, 
-     RIGHT, 
-     TOP, 
-     BOTTOM,
-     INVALID
-    } FaceElement;
+#include <string>
+#include <vector>
 
 /**
   * @brief Class that represents a rubik cube
@@ -44,6 +36,8 @@ private:
     
     static const int NUM_FACES = 6;
     std::array<Face, NUM_FACES> faces;
+    // Zobrist hash of the colors of the face elements (see zobrist.h). Every change of a color updates it
+    uint64_t hash;
     
 protected:
     typedef enum { AXIS_X=0, AXIS_Y, AXIS_Z } Axis;
@@ -116,23 +110,10 @@ protected:
     void SetLayerObject(Axis axis, int element_pos, size_t depth, const T &value);
     
     /**
-      * @brief Rotates a layer of the cube. 
-      * @param axis Axis of rotation
-      * @param clockwise Clockwise of rotation
-      * @param depth Depth of the layer
-      * 
-      * This method rotates only the layer, ie, it doesn't rotate a face
-      * For example, if axis is AXIS_X, clockwise is CLOCKWISE and depth is 0, 
-      * it rotates the left layer in COUNTERCLOCKWISE. 
-      */
-    void RotateLayer(FaceElement face, Clockwise clockwise, size_t depth);
-    
-    /**
-      * @brief Rotates elements of a face in clockwise order
-      * @param face Face to rotate
-      * @param clockwise Clockwise of the rotation. It follows cube notations
+      * @brief Returns the face element at a position of FaceletsToString order
       */
-    void RotateFaceElements(FaceElement face, Clockwise clockwise);
+    AssocFaceElement& GetAssocFaceElement(size_t position);
+    const AssocFaceElement& GetAssocFaceElement(size_t position) const;
     
 public:
     /**
@@ -148,6 +129,12 @@ public:
       */
     void RotateFace(FaceElement face, Clockwise clockwise, size_t depth = 0);
     
+    /**
+      * @brief Rotates a face as described by a move
+      * @param move Face, clockwise and depth of the rotation
+      */
+    void RotateFace(const Move &move);
+    
     /**
       * @brief Gets the 'color' of the face element selected
       * @param face Specifies the face
@@ -156,6 +143,15 @@ public:
       */
     FaceElement GetFaceElement(FaceElement face, size_t row, size_t col) const;
     
+    /**
+      * @brief Sets the 'color' of a face element. Used to rebuild a cube from a saved state
+      * @param face Specifies the face
+      * @param row Specifies the row of the face
+      * @param col Specifies the column of the face
+      * @param value New color of the face element
+      */
+    void SetFaceElement(FaceElement face, size_t row, size_t col, FaceElement value);
+    
     /**
       * @brief Gets the object associated with a face element
       * @pre There is an object associated with the face element
@@ -199,6 +195,27 @@ public:
       * @return Number of faces
       */
     size_t GetNumFaces() const;
+    
+    /**
+      * @brief Checks if the cube is solved, in any orientation
+      * @return True if all face elements of each face have the same color
+      */
+    bool IsSolved() const;
+    
+    /**
+      * @brief Returns the Zobrist hash of the state (see zobrist.h). It is kept up to date by every move, so
+      *        it costs nothing. Objects associated with face elements are not part of the state
+      */
+    uint64_t Hash() const;
+    
+    /**
+      * @brief Moves face elements, with their objects, as a precomputed sequence of moves would do
+      * @param permutation Object whose method GetSource(position) returns the position of the face element
+      *                    which moves to 'position'. Positions are in the order of FaceletsToString
+      *                    (see FaceletPermutation)
+      */
+    template<typename Permutation>
+    void PermuteFacelets(const Permutation &permutation);
 };
 
 
@@ -214,6 +231,27 @@ std::string FaceElementToString(FaceElement face_element);
   */
 std::string FaceToString(FaceElement face);
 
+/**
+  * @brief Returns the location of a face element in integer coordinates, centered in the cube. Coordinates
+  *        are odd or even like 2*row-(cube_size-1), and the axis of the face is at distance cube_size.
+  *        Axes follow the graphical cube: LEFT is +x, TOP is +y and FRONT is +z
+  * @pre face shall not be INVALID. row and col in range [0, cube_size)
+  * @param face Face of the face element
+  * @param row Row of the face element
+  * @param col Column of the face element
+  * @param cube_size Size of the cube
+  * @return Location, as x, y and z, in 'location'
+  */
+void GetFaceletLocation(FaceElement face, size_t row, size_t col, size_t cube_size, int location[3]);
+
+/**
+  * @brief Converts the colors of a cube to a string, one letter per face element (see FaceElementToString)
+  * @param cube Cube to convert
+  * @return Face elements of each face, by rows. Faces are in FaceElement order
+  */
+template<typename T, size_t CUBE_SIZE>
+std::string FaceletsToString(const RubikCube<T, CUBE_SIZE> &cube);
+
 /**
   * @brief Return the reversed clockwise
   * @param clockwise Clockwise to reverse
@@ -269,57 +307,19 @@ template<typename T, size_t CUBE_SIZE>
 void RubikCube<T, CUBE_SIZE>::GetLayerCoords(Axis axis, int element_pos, size_t depth, 
                                              FaceElement &face, size_t &row, size_t &col) const
 {
-    //int TMP = element_pos;
     assert(depth < CUBE_SIZE);
-    size_t num_layer_elements = 4*CUBE_SIZE;
-    size_t face_element_pos;
-    size_t neg_face_element_pos; // Negated element position
-    size_t neg_depth; // Negated depth
-    element_pos = (int)positive_mod(element_pos, num_layer_elements);
-    face_element_pos = element_pos % CUBE_SIZE;
-    neg_face_element_pos = CUBE_SIZE-1 - face_element_pos;
-    neg_depth = CUBE_SIZE-1 - depth;
-    FaceElement face_selector[3][4] = {
-        { TOP,   BACK,   BOTTOM, FRONT }, // X axis
-        { FRONT, LEFT,   BACK,   RIGHT }, // Y axis
-        { RIGHT, BOTTOM, LEFT,   TOP   }  // Z axis
-    };
-    size_t row_selector[3][4] = {
-        { neg_face_element_pos, face_element_pos, neg_face_element_pos, neg_face_element_pos }, // X axis
-        { depth,                depth,            depth,                depth                }, // Y axis
-        { face_element_pos,     depth,            neg_face_element_pos, neg_depth            }  // Z axis
-    };
-    size_t col_selector[3][4] = {
-        { neg_depth,            depth,                neg_depth,            neg_depth            }, // X axis
-        { neg_face_element_pos, neg_face_element_pos, neg_face_element_pos, neg_face_element_pos }, // Y axis
-        { depth,                neg_face_element_pos, neg_depth,            face_element_pos     }  // Z axis
-    };
-    // Store values
-    face = face_selector[(int)axis][element_pos/CUBE_SIZE];
-    row = row_selector[(int)axis][element_pos/CUBE_SIZE];
-    col = col_selector[(int)axis][element_pos/CUBE_SIZE];
-    //std::cout << TMP << ' ' << num_layer_elements << ' ' << element_pos << std::endl;
+    const FaceElement axis_faces[3] = { LEFT, TOP, FRONT };
+    size_t position = GetLayerFaceletPosition(CUBE_SIZE, axis_faces[(int)axis], element_pos, depth);
+    face = (FaceElement)(position / (CUBE_SIZE*CUBE_SIZE));
+    row = (position / CUBE_SIZE) % CUBE_SIZE;
+    col = position % CUBE_SIZE;
 }
 
 template<typename T, size_t CUBE_SIZE>
 void RubikCube<T, CUBE_SIZE>::GetFaceElementCoords(FaceElement face, int element_pos, size_t padding, size_t &row, size_t &col) const {
-    size_t min = padding;
-    size_t max = CUBE_SIZE-1 - padding;
-    size_t edge_size = max-min;
-    element_pos = positive_mod(element_pos, 4*edge_size);
-    if((size_t)element_pos < edge_size) {
-        row = min;
-        col = min+element_pos;
-    } else if((size_t)element_pos < 2*edge_size) {
-        row = min + (element_pos - edge_size);
-        col = max;
-    } else if((size_t)element_pos < 3*edge_size) {
-        row = max;
-        col = max - (element_pos - 2*edge_size);
-    } else {
-        row = max - (element_pos - 3*edge_size);
-        col = min;
-    }
+    size_t position = GetRingFaceletPosition(CUBE_SIZE, face, element_pos, padding);
+    row = (position / CUBE_SIZE) % CUBE_SIZE;
+    col = position % CUBE_SIZE;
 }
 
 template<typename T, size_t CUBE_SIZE>
@@ -343,6 +343,9 @@ void RubikCube<T, CUBE_SIZE>::SetLayerElement(Axis axis, int element_pos, size_t
     FaceElement face;
     size_t row, col;
     GetLayerCoords(axis, element_pos, depth, face, row, col);
+    size_t position = ((size_t)face*CUBE_SIZE + row)*CUBE_SIZE + col;
+    hash ^= ZobristTable<CUBE_SIZE>::GetKey(position, faces[(int)face][row][col].element) ^
+            ZobristTable<CUBE_SIZE>::GetKey(position, value);
     faces[(int)face][row][col].element = value;
     //std::cout << "Element pos: " << element_pos << ", face: " << FaceToString(face) 
     //          << ", row: " << row << ", col: " << col << std::endl;
@@ -357,79 +360,55 @@ void RubikCube<T, CUBE_SIZE>::SetLayerObject(Axis axis, int element_pos, size_t
 }
 
 template<typename T, size_t CUBE_SIZE>
-void RubikCube<T, CUBE_SIZE>::RotateLayer(FaceElement face, Clockwise clockwise, size_t depth) {
-    assert(depth < CUBE_SIZE);
-    
-    Axis axis = GetAxis(face);
-    int offset;
-    if(face == FRONT || face == RIGHT || face == TOP) {
-        offset = CUBE_SIZE;
-    } else {
-        depth = CUBE_SIZE-1 - depth;
-        offset = -(int)CUBE_SIZE;
-    }
-    if(clockwise == CLOCKWISE)
-        offset *= -1;
-    auto getter = [this, axis, depth](int pos) -> AssocFaceElement {
-                      FaceElement face;
-                      size_t row, col;
-                      this->GetLayerCoords(axis, pos, depth, face, row, col);
-                      return faces[(int)face][row][col];
-                  };
-    auto setter = [this, axis, depth](int pos, AssocFaceElement face_elem) {
-                      FaceElement face;
-                      size_t row, col;
-                      this->GetLayerCoords(axis, pos, depth, face, row, col);
-                      faces[(int)face][row][col] = face_elem;
-                  };
-    RotateElements<AssocFaceElement>(offset, 4*CUBE_SIZE, getter, setter);
+typename RubikCube<T, CUBE_SIZE>::AssocFaceElement& RubikCube<T, CUBE_SIZE>::GetAssocFaceElement(size_t position) {
+    return faces[position / (CUBE_SIZE*CUBE_SIZE)][(position / CUBE_SIZE) % CUBE_SIZE][position % CUBE_SIZE];
 }
 
 template<typename T, size_t CUBE_SIZE>
-void RubikCube<T, CUBE_SIZE>::RotateFaceElements(FaceElement face, Clockwise clockwise) {
-    // template<typename T, typename Getter, typename Setter>
-    // void RotateElements(int offset, size_t container_size, Getter get, Setter set)
-    Face &face_matrix = faces[(int)face];
-    for(size_t i=0; i<CUBE_SIZE/2; ++i) {
-        size_t border_length = CUBE_SIZE-1 - 2*i;
-        size_t perimeter = 4*border_length;
-        int offset = border_length;
-        if(clockwise == CLOCKWISE)
-            offset *= -1;
-        // void RubikCube<T, CUBE_SIZE>::GetFaceElementCoords(FaceElement face, int element_pos, size_t padding, size_t &row, size_t &col)
-        auto getter = [this, face_matrix, face, i](int pos) -> AssocFaceElement {
-                          size_t row, col;
-                          this->GetFaceElementCoords(face, pos, i, row, col);
-                          return face_matrix[row][col];
-                      };
-        auto setter = [this, &face_matrix, face, i](int pos, AssocFaceElement face_elem) {
-                          size_t row, col;
-                          this->GetFaceElementCoords(face, pos, i, row, col);
-                          face_matrix[row][col] = face_elem;
-                          //std::cout << pos << ": " << row << ' ' << col << std::endl;;
-                      };
-        RotateElements<AssocFaceElement>(offset, perimeter, getter, setter);
-    }
+const typename RubikCube<T, CUBE_SIZE>::AssocFaceElement& RubikCube<T, CUBE_SIZE>::GetAssocFaceElement(size_t position) const {
+    return faces[position / (CUBE_SIZE*CUBE_SIZE)][(position / CUBE_SIZE) % CUBE_SIZE][position % CUBE_SIZE];
 }
 
 template<typename T, size_t CUBE_SIZE>
-RubikCube<T, CUBE_SIZE>::RubikCube() {
+RubikCube<T, CUBE_SIZE>::RubikCube()
+    : hash(0)
+{
     size_t face_id;
     size_t i, j;
-    for(face_id=0; face_id<NUM_FACES; ++face_id)
-        for(i=0; i<CUBE_SIZE; ++i)
-            for(j=0; j<CUBE_SIZE; ++j)
+    size_t position = 0;
+    for(face_id=0; face_id<NUM_FACES; ++face_id) {
+        for(i=0; i<CUBE_SIZE; ++i) {
+            for(j=0; j<CUBE_SIZE; ++j) {
                 faces[face_id][i][j].element = (FaceElement)face_id;
+                hash ^= ZobristTable<CUBE_SIZE>::GetKey(position++, (FaceElement)face_id);
+            }
+        }
+    }
 }
 
 template<typename T, size_t CUBE_SIZE>
 void RubikCube<T, CUBE_SIZE>::RotateFace(FaceElement face, Clockwise clockwise, size_t depth) {
-    std::cout << FaceToString(face) << ", " << clockwise << ", " << depth << std::endl;
-    if(depth == 0)
-        RotateFaceElements(face, clockwise);
-    else if(depth+1 == CUBE_SIZE)
-        RotateFaceElements(face, !clockwise);
-    RotateLayer(face, clockwise, depth);
+    PROFILE_SCOPE("RubikCube::RotateFace");
+    assert(face >= 0 && face < NUM_FACES);
+    assert(depth < CUBE_SIZE);
+    // Moved face elements are computed at compile time (see move_permutation.h)
+    const Move move = {face, clockwise, depth};
+    const SparseMovePermutation<CUBE_SIZE> &permutation =
+        SparseMoveTable<CUBE_SIZE>::MOVES[GetMoveIndex(CUBE_SIZE, move)];
+    std::array<AssocFaceElement, SparseMovePermutation<CUBE_SIZE>::MAX_MOVED> moved;
+    for(size_t i=0; i<permutation.num_positions; ++i)
+        moved[i] = GetAssocFaceElement(permutation.sources[i]);
+    for(size_t i=0; i<permutation.num_positions; ++i) {
+        AssocFaceElement &target = GetAssocFaceElement(permutation.positions[i]);
+        hash ^= ZobristTable<CUBE_SIZE>::GetKey(permutation.positions[i], target.element) ^
+                ZobristTable<CUBE_SIZE>::GetKey(permutation.positions[i], moved[i].element);
+        target = moved[i];
+    }
+}
+
+template<typename T, size_t CUBE_SIZE>
+void RubikCube<T, CUBE_SIZE>::RotateFace(const Move &move) {
+    RotateFace(move.face, move.clockwise, move.depth);
 }
 
 template<typename T, size_t CUBE_SIZE>
@@ -440,6 +419,17 @@ FaceElement RubikCube<T, CUBE_SIZE>::GetFaceElement(FaceElement face, size_t row
     return faces[(size_t)face][row][col].element;
 }
 
+template<typename T, size_t CUBE_SIZE>
+void RubikCube<T, CUBE_SIZE>::SetFaceElement(FaceElement face, size_t row, size_t col, FaceElement value) {
+    assert(face >= 0 && face < NUM_FACES);
+    assert(row < CUBE_SIZE);
+    assert(col < CUBE_SIZE);
+    size_t position = ((size_t)face*CUBE_SIZE + row)*CUBE_SIZE + col;
+    hash ^= ZobristTable<CUBE_SIZE>::GetKey(position, faces[(size_t)face][row][col].element) ^
+            ZobristTable<CUBE_SIZE>::GetKey(position, value);
+    faces[(size_t)face][row][col].element = value;
+}
+
 template<typename T, size_t CUBE_SIZE>
 const T& RubikCube<T, CUBE_SIZE>::GetFaceObject(FaceElement face, size_t row, size_t col) const {
     assert(face >= 0 && face < NUM_FACES);
@@ -479,19 +469,21 @@ void RubikCube<T, CUBE_SIZE>::GetObjectCoordinates(const T &object, FaceElement
 
 template<typename T, size_t CUBE_SIZE>
 std::vector<T> RubikCube<T, CUBE_SIZE>::GetFaceObjects(FaceElement face, size_t depth) const {
+    PROFILE_SCOPE("RubikCube::GetFaceObjects");
     assert(face >= 0 && face < INVALID);
     assert(depth >= 0 && depth < CUBE_SIZE);
     std::vector<T> face_objects;
     
-    if(face == LEFT || face == BACK || face == BOTTOM) {
-        depth = CUBE_SIZE-1 - depth;
-    }
-    
-    // Add front face elements
+    // Add face elements of external layers. Deepest layer is the opposite face
     if(depth == 0 || depth+1 == CUBE_SIZE) {
+        FaceElement external_face = (depth == 0 ? face : !face);
         for(size_t i=0; i<CUBE_SIZE; ++i)
             for(size_t j=0; j<CUBE_SIZE; j++)
-                face_objects.push_back(*(faces[face][i][j].object));
+                face_objects.push_back(*(faces[external_face][i][j].object));
+    }
+    
+    if(face == LEFT || face == BACK || face == BOTTOM) {
+        depth = CUBE_SIZE-1 - depth;
     }
     
     // Add lateral face elements
@@ -510,52 +502,49 @@ size_t RubikCube<T, CUBE_SIZE>::GetNumFaces() const {
 
 
 
-std::string FaceToString(FaceElement face) {
-    std::string str;
-    switch(face) {
-    case FRONT:  str = "front";   break;
-    case BACK:   str = "back";    break;
-    case LEFT:   str = "left";    break;
-    case RIGHT:  str = "right";   break;
-    case TOP:    str = "top";     break;
-    case BOTTOM: str = "bottom";  break;
-    default:     str = "invalid"; break;
-    }
-    return str;
+template<typename T, size_t CUBE_SIZE>
+bool RubikCube<T, CUBE_SIZE>::IsSolved() const {
+    for(size_t face=0; face<NUM_FACES; ++face)
+        for(size_t row=0; row<CUBE_SIZE; ++row)
+            for(size_t col=0; col<CUBE_SIZE; ++col)
+                if(faces[face][row][col].element != faces[face][0][0].element)
+                    return false;
+    return true;
 }
 
-std::string FaceElementToString(FaceElement face_element) {
-    std::string str;
-    switch(face_element) {
-    case FRONT:  str = "F";  break;
-    case BACK:   str = "B";  break;
-    case LEFT:   str = "L";  break;
-    case RIGHT:  str = "R";  break;
-    case TOP:    str = "U";  break;
-    case BOTTOM: str = "D";  break;
-    default:     str = "I";  break;
-    }
-    return str;
+template<typename T, size_t CUBE_SIZE>
+uint64_t RubikCube<T, CUBE_SIZE>::Hash() const {
+    return hash;
 }
 
-Clockwise operator!(Clockwise clockwise) {
-    if(clockwise == CLOCKWISE)
-        clockwise = COUNTERCLOCKWISE;
-    else
-        clockwise = CLOCKWISE;
-    return clockwise;
+template<typename T, size_t CUBE_SIZE>
+template<typename Permutation>
+void RubikCube<T, CUBE_SIZE>::PermuteFacelets(const Permutation &permutation) {
+    PROFILE_SCOPE("RubikCube::PermuteFacelets");
+    const size_t face_size = CUBE_SIZE*CUBE_SIZE;
+    std::array<Face, NUM_FACES> source = faces;
+    size_t i = 0;
+    hash = 0;
+    for(size_t face=0; face<NUM_FACES; ++face) {
+        for(size_t row=0; row<CUBE_SIZE; ++row) {
+            for(size_t col=0; col<CUBE_SIZE; ++col) {
+                size_t from = permutation.GetSource(i);
+                faces[face][row][col] = source[from / face_size][(from / CUBE_SIZE) % CUBE_SIZE][from % CUBE_SIZE];
+                hash ^= ZobristTable<CUBE_SIZE>::GetKey(i++, faces[face][row][col].element);
+            }
+        }
+    }
 }
 
-FaceElement operator!(FaceElement face) {
-    switch(face) {
-    case FRONT:  face = BACK;   break;
-    case BACK:   face = FRONT;  break;
-    case LEFT:   face = RIGHT;  break;
-    case RIGHT:  face = LEFT;   break;
-    case TOP:    face = BOTTOM; break;
-    case BOTTOM: face = TOP;    break;
-    }
-    return face;
+template<typename T, size_t CUBE_SIZE>
+std::string FaceletsToString(const RubikCube<T, CUBE_SIZE> &cube) {
+    std::string str;
+    str.reserve(cube.GetNumFaces()*CUBE_SIZE*CUBE_SIZE);
+    for(size_t face_id=0; face_id<cube.GetNumFaces(); ++face_id)
+        for(size_t row=0; row<CUBE_SIZE; ++row)
+            for(size_t col=0; col<CUBE_SIZE; ++col)
+                str += FaceElementToString(cube.GetFaceElement((FaceElement)face_id, row, col));
+    return str;
 }
 
 template<typename T, size_t CUBE_SIZE>
@@ -574,16 +563,4 @@ std::ostream& operator<<(std::ostream &os, const RubikCube<T, CUBE_SIZE> &cube)
     return os;
 }
 
-std::ostream& operator<<(std::ostream &os, Clockwise clockwise) {
-    switch(clockwise) {
-    case CLOCKWISE:
-        os << "CW"; break;
-    case COUNTERCLOCKWISE:
-        os << "CCW"; break;
-    default:
-        os << "INVALID_CW";
-    }
-    return os;
-}
-
-
+#endif
@@ -0,0 +1,103 @@
+#ifndef __RUBIK_SHARD_COORDINATOR_H__
+#define __RUBIK_SHARD_COORDINATOR_H__
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <sys/types.h>
+
+/**
+  * Searches split in shards (for example, the subtrees of the move sequences of a given length), run by
+  * worker processes. The coordinator is the process which creates the workers: each one is connected to it
+  * by a Unix socket pair, and runs one shard at a time. Messages are text lines:
+  *   coordinator -> worker: "shard <index> <task>", "cancel", "quit"
+  *   worker -> coordinator: "result <index> <result>", "cancelled <index>"
+  *
+  * Results of finished shards are appended to a checkpoint file, if any, so a job which is killed skips them
+  * when it is run again. Records of a job are identified by a hash of its description, so several jobs can
+  * share a file.
+  */
+
+/**
+  * @brief Function which runs a shard in a worker process
+  * @param task Description of the shard, without end of line
+  * @param cancelled Returns true once the coordinator cancels the shard. It has a system call per call, so it
+  *                  should be checked every few thousand nodes. The result of a cancelled shard is discarded
+  * @return Result of the shard, without end of line
+  */
+typedef std::function<std::string(const std::string &task, const std::function<bool()> &cancelled)> ShardFunction;
+
+/**
+  * @brief Function which receives the result of a shard in the coordinator
+  * @param index Index of the shard
+  * @param result Result of the shard, as returned by the ShardFunction
+  * @param checkpointed True if the result was read from the checkpoint, instead of run by a worker
+  * @return False to stop the job. Running shards are cancelled, and the pending ones are not run
+  */
+typedef std::function<bool(size_t index, const std::string &result, bool checkpointed)> ShardResultFunction;
+
+class ShardCoordinator {
+private:
+    struct Worker {
+        pid_t pid;
+        int fd;
+        std::string buffer; // Received bytes which are not a whole line yet
+        long shard;         // Index of the running shard, or -1
+    };
+
+    std::vector<Worker> workers;
+
+    /**
+      * @brief Body of worker processes. Runs shards until the coordinator quits
+      */
+    static void WorkerLoop(int fd, const ShardFunction &function);
+
+    /**
+      * @brief Waits for the next line of a worker
+      * @throw std::runtime_error if the worker exited
+      */
+    std::string ReceiveLine(Worker &worker);
+
+    /**
+      * @brief Stops and waits for all the workers
+      */
+    void Shutdown();
+
+public:
+    /**
+      * @brief Starts the worker processes
+      * @pre The process has no other threads than the calling one, since they would not exist in the workers
+      * @param num_workers Number of worker processes
+      * @param function Function which runs the shards. Workers get a copy of the state of the process when
+      *                 they are created, so it can use any data prepared before
+      * @throw std::invalid_argument if num_workers is 0
+      * @throw std::runtime_error if the processes could not be created
+      */
+    ShardCoordinator(size_t num_workers, ShardFunction function);
+
+    /**
+      * @brief Stops and waits for the workers
+      */
+    ~ShardCoordinator();
+
+    ShardCoordinator(const ShardCoordinator&) = delete;
+    ShardCoordinator& operator=(const ShardCoordinator&) = delete;
+
+    size_t GetNumWorkers() const;
+
+    /**
+      * @brief Runs a job: hands out its shards to idle workers, in order, until all of them are done or the
+      *        job is stopped by 'on_result'
+      * @param job Description of the job, which identifies its records in the checkpoint
+      * @param tasks Task of each shard, without end of lines
+      * @param on_result Function which receives the results. Results found in the checkpoint are received first,
+      *                  in order of the file
+      * @param checkpoint Path of the checkpoint file. Empty for no checkpoint
+      * @return False if the job was stopped by on_result
+      * @throw std::runtime_error if a worker exited, or the checkpoint could not be read or written
+      */
+    bool Run(const std::string &job, const std::vector<std::string> &tasks, const ShardResultFunction &on_result,
+             const std::string &checkpoint = "");
+};
+
+#endif
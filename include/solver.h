@@ -0,0 +1,138 @@
+#ifndef __RUBIK_SOLVER_H__
+#define __RUBIK_SOLVER_H__
+
+#include <rubik.h>
+#include <move_generator.h>
+#include <transposition_table.h>
+#include <zobrist.h>
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <stdexcept>
+
+/**
+  * @brief Searches a shortest solution by iterative deepening depth-first search. Solved means each face has
+  *        a single color, in any orientation. Sequences which are trivially redundant are skipped: a layer
+  *        turned several times in a row (except clockwise half turns), and parallel layers turned out of order
+  *        (see MoveGenerator)
+  * @param cube Cube to solve
+  * @param max_depth Maximum length of the solution, in quarter turns
+  * @return True if a solution was found. It is stored in 'solution'
+  */
+template<typename T, size_t CUBE_SIZE>
+bool SolveIDDFS(const RubikCube<T, CUBE_SIZE> &cube, size_t max_depth, std::vector<Move> &solution);
+
+/**
+  * @brief Searches a shortest solution as SolveIDDFS, skipping the states a transposition table holds as already
+  *        searched without a solution, with at least as many remaining moves. Entries only depend on the state
+  *        and the moves the generator allows next, so the table can be shared by several searches and threads,
+  *        and the solution is the one of SolveIDDFS (unless two states have the same 64 bit hash). Sequences of
+  *        the generator reach few states twice on 3x3 cubes, but many on 2x2 cubes, which have few states
+  * @param table Table of the searched states
+  * @param skipped Number of states skipped, which is increased
+  * @throw std::invalid_argument if max_depth is greater than MAX_TRANSPOSITION_DEPTH, the depth entries can hold
+  */
+template<typename T, size_t CUBE_SIZE>
+bool SolveIDDFS(const RubikCube<T, CUBE_SIZE> &cube, size_t max_depth, std::vector<Move> &solution,
+                TranspositionTable &table, uint64_t &skipped);
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+/**
+  * @brief Depth-limited search from the last state of the path
+  * @param state State of the generator after the path
+  * @return True if a solved state is found in 'remaining' moves or less. The path leading to it is kept
+  */
+template<typename T, size_t CUBE_SIZE>
+bool SolveDepthLimited(RubikCube<T, CUBE_SIZE> &cube, const MoveGenerator<CUBE_SIZE> &generator, size_t state,
+                       size_t remaining, std::vector<Move> &path) {
+    if(cube.IsSolved())
+        return true;
+    if(remaining == 0)
+        return false;
+
+    const std::vector<typename MoveGenerator<CUBE_SIZE>::Successor> &successors = generator.GetSuccessors(state);
+    size_t path_size = path.size();
+    for(size_t i=0; i<successors.size(); ++i) {
+        generator.ApplyMove(successors[i].move, cube);
+        generator.AppendMove(successors[i].move, path);
+        if(SolveDepthLimited(cube, generator, successors[i].state, remaining-1, path))
+            return true;
+        path.resize(path_size);
+        generator.UndoMove(successors[i].move, cube);
+    }
+    return false;
+}
+
+/**
+  * @brief Depth-limited search as SolveDepthLimited, which skips the states of a transposition table
+  * @param skipped Number of states skipped, which is increased
+  */
+template<typename T, size_t CUBE_SIZE>
+bool SolveDepthLimited(RubikCube<T, CUBE_SIZE> &cube, const MoveGenerator<CUBE_SIZE> &generator, size_t state,
+                       size_t remaining, std::vector<Move> &path, TranspositionTable &table, uint64_t &skipped) {
+    if(cube.IsSolved())
+        return true;
+    if(remaining == 0)
+        return false;
+
+    // Entries are the remaining moves of searches which failed
+    const uint64_t key = cube.Hash() ^ ZobristMix(state);
+    TranspositionEntry entry;
+    if(table.Probe(key, entry) && entry.depth >= remaining) {
+        ++skipped;
+        return false;
+    }
+
+    const std::vector<typename MoveGenerator<CUBE_SIZE>::Successor> &successors = generator.GetSuccessors(state);
+    size_t path_size = path.size();
+    for(size_t i=0; i<successors.size(); ++i) {
+        generator.ApplyMove(successors[i].move, cube);
+        generator.AppendMove(successors[i].move, path);
+        if(SolveDepthLimited(cube, generator, successors[i].state, remaining-1, path, table, skipped))
+            return true;
+        path.resize(path_size);
+        generator.UndoMove(successors[i].move, cube);
+    }
+    assert(remaining <= MAX_TRANSPOSITION_DEPTH);
+    entry.value = 0;
+    entry.data = 0;
+    entry.depth = remaining;
+    table.Store(key, entry);
+    return false;
+}
+
+template<typename T, size_t CUBE_SIZE>
+bool SolveIDDFS(const RubikCube<T, CUBE_SIZE> &cube, size_t max_depth, std::vector<Move> &solution) {
+    MoveGenerator<CUBE_SIZE> generator(QUARTER_TURN_METRIC);
+    RubikCube<T, CUBE_SIZE> state = cube;
+
+    for(size_t depth=0; depth<=max_depth; ++depth) {
+        solution.clear();
+        if(SolveDepthLimited(state, generator, MoveGenerator<CUBE_SIZE>::START, depth, solution))
+            return true;
+    }
+    return false;
+}
+
+template<typename T, size_t CUBE_SIZE>
+bool SolveIDDFS(const RubikCube<T, CUBE_SIZE> &cube, size_t max_depth, std::vector<Move> &solution,
+                TranspositionTable &table, uint64_t &skipped) {
+    if(max_depth > MAX_TRANSPOSITION_DEPTH)
+        throw std::invalid_argument("Maximum depth of a search with a transposition table is " +
+                                    std::to_string(MAX_TRANSPOSITION_DEPTH));
+    MoveGenerator<CUBE_SIZE> generator(QUARTER_TURN_METRIC);
+    RubikCube<T, CUBE_SIZE> state = cube;
+    for(size_t depth=0; depth<=max_depth; ++depth) {
+        solution.clear();
+        if(SolveDepthLimited(state, generator, MoveGenerator<CUBE_SIZE>::START, depth, solution, table, skipped))
+            return true;
+    }
+    return false;
+}
+
+#endif
@@ -0,0 +1,319 @@
+#ifndef __RUBIK_STATE_ENCODING_H__
+#define __RUBIK_STATE_ENCODING_H__
+
+#include <rubik.h>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+/**
+  * Compact binary encodings of cube states:
+  *  - 3x3 cubes are packed as coordinates: orientation of the whole cube (24), corner permutation (8!) and
+  *    orientation (3^7), edge permutation (12!/2, its parity is the corner one) and orientation (2^11).
+  *    Edge coordinates take the low 39 bits and the other ones the next 32 bits, so decoding only
+  *    needs 64 bit arithmetic. 71 bits, stored in STATE3_SIZE bytes. Only valid (reachable) states can be encoded
+  *  - Any NxN cube is packed as 3 bits per face element, in the order of FaceletsToString
+  * Integers are stored in little endian. Equal states have equal encodings, so they can be compared byte by byte.
+  */
+
+/*    Bytes of a coordinate packed 3x3 state    */
+const size_t STATE3_SIZE = 9;
+
+/*    Number of face elements of a 3x3 cube    */
+const size_t NUM_FACELETS3 = 54;
+
+/*    Values of the fields of a coordinate packed 3x3 state, for a fixed orientation of the whole cube    */
+const uint64_t STATE3_CORNER_VALUES = 88179840;       // 8! * 3^7
+const uint64_t STATE3_EDGE_VALUES = 490497638400ull;  // 12!/2 * 2^11
+const unsigned STATE3_ORIENTATIONS = 24;
+
+/*    Pieces of a 3x3 cube    */
+const size_t NUM_CORNERS3 = 8;
+const size_t NUM_EDGES3 = 12;
+
+/**
+  * @brief Pieces of a 3x3 cube, for a fixed orientation of the whole cube. Slots and pieces are numbered
+  *        alike: piece i is the one at slot i in the solved cube. Twist of a corner (0, 1 or 2) and flip of
+  *        an edge (0 or 1) are the position, among the face elements of its slot, of the reference color of
+  *        the piece: TOP or BOTTOM for corners, TOP or BOTTOM, else FRONT or BACK, for edges
+  */
+struct CubieState3 {
+    std::array<uint8_t, NUM_CORNERS3> corner_permutation; // Piece at each slot
+    std::array<uint8_t, NUM_CORNERS3> corner_twists;
+    std::array<uint8_t, NUM_EDGES3> edge_permutation;
+    std::array<uint8_t, NUM_EDGES3> edge_flips;
+};
+
+/**
+  * @brief Packs the fields of a 3x3 state. Any combination of values in range is a valid state
+  * @param orientation Orientation of the whole cube, in range [0, STATE3_ORIENTATIONS). Zero keeps the centers
+  *                    at their solved positions
+  * @param corners Permutation and orientation of corners, in range [0, STATE3_CORNER_VALUES)
+  * @param edges Permutation and orientation of edges, in range [0, STATE3_EDGE_VALUES)
+  * @param data Output buffer of STATE3_SIZE bytes
+  */
+inline void PackState3(unsigned orientation, uint64_t corners, uint64_t edges, uint8_t *data);
+
+/**
+  * @brief Returns the solved state of the pieces of a 3x3 cube
+  */
+CubieState3 GetSolvedCubies3();
+
+/**
+  * @brief Checks if an edge is one of the slice between TOP and BOTTOM faces, which have no TOP or BOTTOM colors
+  * @param edge Edge piece or slot, in range [0, NUM_EDGES3)
+  */
+bool IsSliceEdge3(size_t edge);
+
+/**
+  * @brief Finds the pieces of a 3x3 cube from its face elements
+  * @param facelets Face elements, in the order of FaceletsToString
+  * @param cubies Output pieces, once the orientation of the whole cube is undone
+  * @param orientation Output orientation of the whole cube, in range [0, STATE3_ORIENTATIONS)
+  * @return False if the face elements don't describe a valid state. Outputs are undefined then
+  */
+bool FaceletsToCubies3(const FaceElement *facelets, CubieState3 &cubies, unsigned &orientation);
+
+/**
+  * @brief Writes the face elements of a 3x3 cube from its pieces
+  * @pre Pieces are a permutation, with twists and flips in range. Other invariants of reachable states
+  *      are not needed
+  * @param cubies Pieces
+  * @param orientation Orientation of the whole cube, in range [0, STATE3_ORIENTATIONS)
+  * @param facelets Output face elements, in the order of FaceletsToString
+  */
+void CubiesToFacelets3(const CubieState3 &cubies, unsigned orientation, FaceElement *facelets);
+
+/**
+  * @brief Returns lexicographic rank of a permutation of [0, SIZE)
+  * @param parity Output parity of the permutation (0 even, 1 odd)
+  */
+template<size_t SIZE>
+uint64_t RankPermutation(const std::array<uint8_t, SIZE> &permutation, int &parity);
+
+/**
+  * @brief Inverse of RankPermutation
+  * @pre rank is less than SIZE!
+  * @param parity Output parity of the permutation
+  */
+template<size_t SIZE>
+std::array<uint8_t, SIZE> UnrankPermutation(uint64_t rank, int &parity);
+
+/**
+  * @brief Encodes face elements of a 3x3 cube as coordinates
+  * @pre Face elements describe a reachable state
+  * @param facelets Face elements, in the order of FaceletsToString
+  * @param data Output buffer of STATE3_SIZE bytes
+  * @return False if the face elements don't describe a valid state. 'data' is undefined then
+  */
+bool EncodeFacelets3(const FaceElement *facelets, uint8_t *data);
+
+/**
+  * @brief Decodes face elements of a 3x3 cube from coordinates
+  * @param data Buffer of STATE3_SIZE bytes
+  * @param facelets Output face elements, in the order of FaceletsToString
+  * @return False if some coordinate is out of range. 'facelets' is undefined then
+  */
+bool DecodeFacelets3(const uint8_t *data, FaceElement *facelets);
+
+/**
+  * @brief Encodes a block of 3x3 states as coordinates
+  * @param facelets Face elements of num_states states, NUM_FACELETS3 each
+  * @param data Output buffer of num_states*STATE3_SIZE bytes
+  * @return Number of states encoded before the first one which is not valid
+  */
+size_t EncodeFaceletBlock3(const FaceElement *facelets, size_t num_states, uint8_t *data);
+
+/**
+  * @brief Decodes a block of 3x3 states from coordinates
+  * @param data Buffer of num_states*STATE3_SIZE bytes
+  * @param facelets Output face elements of num_states states, NUM_FACELETS3 each
+  * @return Number of states decoded before the first one with some coordinate out of range
+  */
+size_t DecodeFaceletBlock3(const uint8_t *data, size_t num_states, FaceElement *facelets);
+
+/**
+  * @brief Encodes a 3x3 cube as coordinates
+  * @param cube Cube to encode. Associated objects are not saved
+  * @param data Output buffer of STATE3_SIZE bytes
+  * @return False if the cube is not in a valid state
+  */
+template<typename T>
+bool EncodeState3(const RubikCube<T, 3> &cube, uint8_t *data);
+
+/**
+  * @brief Decodes a 3x3 cube from coordinates
+  * @param data Buffer of STATE3_SIZE bytes
+  * @param cube Output cube. Associated objects are kept
+  * @return False if the data is not a valid encoded state. 'cube' is not changed then
+  */
+template<typename T>
+bool DecodeState3(const uint8_t *data, RubikCube<T, 3> &cube);
+
+/**
+  * @brief Returns bytes of a NxN state packed as face elements
+  */
+constexpr size_t GetPackedFaceletsSize(size_t cube_size) {
+    return (6*cube_size*cube_size*3 + 7) / 8;
+}
+
+/**
+  * @brief Packs face elements of a cube, 3 bits each
+  * @param cube Cube to pack. Associated objects are not saved
+  * @param data Output buffer of GetPackedFaceletsSize(CUBE_SIZE) bytes
+  */
+template<typename T, size_t CUBE_SIZE>
+void PackFacelets(const RubikCube<T, CUBE_SIZE> &cube, uint8_t *data);
+
+/**
+  * @brief Unpacks face elements of a cube
+  * @param data Buffer of GetPackedFaceletsSize(CUBE_SIZE) bytes
+  * @param cube Output cube. Associated objects are kept
+  * @return False if some face element is not valid. 'cube' is partially changed then
+  */
+template<typename T, size_t CUBE_SIZE>
+bool UnpackFacelets(const uint8_t *data, RubikCube<T, CUBE_SIZE> &cube);
+
+/**
+  * @brief Packs face elements, 3 bits each. Same layout as PackFacelets of a cube
+  * @param facelets Face elements, in the order of FaceletsToString
+  * @param num_facelets Number of face elements
+  * @param data Output buffer of (3*num_facelets + 7) / 8 bytes
+  */
+void PackFacelets(const FaceElement *facelets, size_t num_facelets, uint8_t *data);
+
+/**
+  * @brief Unpacks face elements, 3 bits each
+  * @param data Buffer of (3*num_facelets + 7) / 8 bytes
+  * @param num_facelets Number of face elements
+  * @param facelets Output face elements
+  * @return False if some face element is not valid. 'facelets' is partially changed then
+  */
+bool UnpackFacelets(const uint8_t *data, size_t num_facelets, FaceElement *facelets);
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+template<size_t SIZE>
+uint64_t RankPermutation(const std::array<uint8_t, SIZE> &permutation, int &parity) {
+    static_assert(SIZE <= 16, "Counts of values are packed in 4 bits each");
+    const uint64_t ones = 0x1111111111111111ull;
+    uint64_t rank = 0;
+    uint64_t smaller_seen = 0; // 4 bits per value v: number of values less than v in the previous positions
+    size_t inversions = 0;
+    // Digit i is the number of later values smaller than value i. Parity is the one of their sum, the inversions
+    for(size_t i=0; i<SIZE; ++i) {
+        unsigned value = permutation[i];
+        size_t smaller = value - ((smaller_seen >> (4*value)) & 0xf);
+        smaller_seen += (ones << (4*value)) << 4;
+        rank = rank * (SIZE-i) + smaller;
+        inversions += smaller;
+    }
+    parity = inversions % 2;
+    return rank;
+}
+
+/**
+  * @brief Splits a rank in factorial base, from the last digit (base RADIX) to the first one (base SIZE).
+  *        Digits don't depend on each other, and the divisors are constants, so divisions are multiplications
+  */
+template<size_t SIZE, size_t RADIX = 1, uint64_t FACTORIAL = 1>
+void GetFactorialDigits(uint64_t rank, std::array<uint8_t, SIZE> &digits) {
+    digits[SIZE-RADIX] = rank / FACTORIAL % RADIX;
+    if constexpr(RADIX < SIZE)
+        GetFactorialDigits<SIZE, RADIX+1, FACTORIAL*RADIX>(rank, digits);
+}
+
+template<size_t SIZE>
+std::array<uint8_t, SIZE> UnrankPermutation(uint64_t rank, int &parity) {
+    static_assert(SIZE <= 16, "Unused values are packed in 4 bits each");
+    std::array<uint8_t, SIZE> permutation;
+    std::array<uint8_t, SIZE> digits;
+    uint64_t available = 0;
+    GetFactorialDigits(rank, digits);
+    parity = 0;
+    for(size_t i=0; i<SIZE; ++i) {
+        parity ^= digits[i] & 1;
+        available |= (uint64_t)i << (4*i);
+    }
+    // Each digit selects one of the unused values, in increasing order. Values after it are shifted down
+    for(size_t i=0; i<SIZE; ++i) {
+        unsigned shift = 4*digits[i];
+        uint64_t below = available & ((1ull << shift) - 1);
+        permutation[i] = (available >> shift) & 0xf;
+        available = below | ((available >> shift >> 4) << shift);
+    }
+    return permutation;
+}
+
+inline void PackState3(unsigned orientation, uint64_t corners, uint64_t edges, uint8_t *data) {
+    // Same layout as EncodeFacelets3: edges in the low 39 bits
+    corners += orientation * STATE3_CORNER_VALUES;
+    uint64_t low = edges | (corners << 39);
+    for(size_t i=0; i<8; ++i)
+        data[i] = low >> (8*i);
+    data[8] = corners >> 25;
+}
+
+template<typename T>
+bool EncodeState3(const RubikCube<T, 3> &cube, uint8_t *data) {
+    FaceElement facelets[NUM_FACELETS3];
+    size_t i = 0;
+    for(int face=0; face<INVALID; ++face)
+        for(size_t row=0; row<3; ++row)
+            for(size_t col=0; col<3; ++col)
+                facelets[i++] = cube.GetFaceElement((FaceElement)face, row, col);
+    return EncodeFacelets3(facelets, data);
+}
+
+template<typename T>
+bool DecodeState3(const uint8_t *data, RubikCube<T, 3> &cube) {
+    FaceElement facelets[NUM_FACELETS3];
+    size_t i = 0;
+    if(!DecodeFacelets3(data, facelets))
+        return false;
+    for(int face=0; face<INVALID; ++face)
+        for(size_t row=0; row<3; ++row)
+            for(size_t col=0; col<3; ++col)
+                cube.SetFaceElement((FaceElement)face, row, col, facelets[i++]);
+    return true;
+}
+
+template<typename T, size_t CUBE_SIZE>
+void PackFacelets(const RubikCube<T, CUBE_SIZE> &cube, uint8_t *data) {
+    FaceElement facelets[6*CUBE_SIZE*CUBE_SIZE];
+    size_t i = 0;
+    for(int face=0; face<INVALID; ++face)
+        for(size_t row=0; row<CUBE_SIZE; ++row)
+            for(size_t col=0; col<CUBE_SIZE; ++col)
+                facelets[i++] = cube.GetFaceElement((FaceElement)face, row, col);
+    PackFacelets(facelets, 6*CUBE_SIZE*CUBE_SIZE, data);
+}
+
+template<typename T, size_t CUBE_SIZE>
+bool UnpackFacelets(const uint8_t *data, RubikCube<T, CUBE_SIZE> &cube) {
+    uint32_t buffer = 0;
+    size_t num_bits = 0;
+    for(int face=0; face<INVALID; ++face) {
+        for(size_t row=0; row<CUBE_SIZE; ++row) {
+            for(size_t col=0; col<CUBE_SIZE; ++col) {
+                if(num_bits < 3) {
+                    buffer |= (uint32_t)*data++ << num_bits;
+                    num_bits += 8;
+                }
+                FaceElement value = (FaceElement)(buffer & 0x7);
+                if(value >= INVALID)
+                    return false;
+                cube.SetFaceElement((FaceElement)face, row, col, value);
+                buffer >>= 3;
+                num_bits -= 3;
+            }
+        }
+    }
+    return true;
+}
+
+#endif
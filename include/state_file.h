@@ -0,0 +1,321 @@
+#ifndef __RUBIK_STATE_FILE_H__
+#define __RUBIK_STATE_FILE_H__
+
+#include <rubik.h>
+#include <state_encoding.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <cstring>
+
+/**
+  * Columnar file of cube states and labels. All columns have the same number of records, of fixed size.
+  *
+  * Layout (little endian):
+  *   StateFileHeader, at offset 0
+  *   Column data, each column aligned to STATE_FILE_ALIGNMENT bytes
+  *   StateFileColumn directory, at header.directory_offset, also aligned
+  *
+  * Files are read through a memory mapping, so records are accessed without copies.
+  */
+
+/*    Types of the records of a column    */
+typedef enum {
+    COLUMN_STATE3 = 0, // Coordinate packed 3x3 states (see EncodeState3)
+    COLUMN_FACELETS,   // Packed face elements of any cube size (see PackFacelets)
+    COLUMN_UINT8,
+    COLUMN_UINT16,
+    COLUMN_UINT32,
+    COLUMN_UINT64,
+    COLUMN_FLOAT32,
+    COLUMN_BYTES,      // Opaque records of any size
+    NUM_COLUMN_TYPES
+} ColumnType;
+
+const char STATE_FILE_MAGIC[8] = {'R', 'U', 'B', 'I', 'K', 'S', 'T', 'S'};
+const uint32_t STATE_FILE_VERSION = 1;
+const size_t STATE_FILE_ALIGNMENT = 64;
+const size_t COLUMN_NAME_SIZE = 32;
+
+/*    Bytes buffered by StateFileWriter for each column    */
+const size_t STATE_FILE_BUFFER = 1 << 20;
+
+struct StateFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t cube_size;
+    uint64_t num_records;
+    uint64_t directory_offset;
+    uint32_t num_columns;
+    uint8_t reserved[28];
+};
+
+struct StateFileColumn {
+    char name[COLUMN_NAME_SIZE]; // Zero terminated
+    uint32_t type;
+    uint32_t record_size;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(StateFileHeader) == 64, "Unexpected padding of StateFileHeader");
+static_assert(sizeof(StateFileColumn) == 64, "Unexpected padding of StateFileColumn");
+
+/**
+  * @brief Returns size of records of a column type, or zero if it depends on the column (COLUMN_BYTES)
+  * @param type Type of the column
+  * @param cube_size Size of the cubes of the file
+  */
+size_t GetColumnRecordSize(ColumnType type, size_t cube_size);
+
+
+/**
+  * @brief Writes a state file. The number of records is fixed on creation, so each column has its own region
+  *        of the file, and records are written to it as the buffer of the column fills
+  */
+class StateFileWriter {
+private:
+    std::string filename;
+    size_t cube_size;
+    uint64_t num_records;
+    int fd;
+    std::vector<StateFileColumn> columns; // Size of a column is the bytes appended so far
+    std::vector<std::vector<uint8_t>> buffers;
+    bool closed;
+
+    /**
+      * @brief Writes bytes of a column after the ones written so far
+      * @throw std::runtime_error on write errors
+      */
+    void Write(size_t column, const uint8_t *data, size_t size);
+
+    /**
+      * @brief Writes the buffer of a column
+      */
+    void Flush(size_t column);
+
+    /**
+      * @brief Checks that records fit in the region of a column
+      * @throw std::runtime_error if there are more records than the ones of the file, or the file is closed
+      */
+    void CheckSpace(size_t column, size_t num_records) const;
+
+    /**
+      * @brief Reserves space at the end of the buffer of a column, flushing it if it is full
+      * @return Space for the records, which are counted as appended
+      * @throw std::runtime_error if the records don't fit (see CheckSpace)
+      */
+    uint8_t* Reserve(size_t column, size_t num_records);
+
+public:
+    /**
+      * @brief Creates a state file
+      * @param filename Path of the file. It is created or truncated
+      * @param cube_size Size of the cubes
+      * @param num_records Number of records of each column
+      * @throw std::runtime_error if the file could not be created
+      */
+    StateFileWriter(const std::string &filename, size_t cube_size, uint64_t num_records);
+
+    /**
+      * @brief Closes the file if Close was not called. Errors are ignored
+      */
+    ~StateFileWriter();
+
+    StateFileWriter(const StateFileWriter&) = delete;
+    StateFileWriter& operator=(const StateFileWriter&) = delete;
+
+    /**
+      * @brief Adds a column
+      * @param name Name of the column, shorter than COLUMN_NAME_SIZE
+      * @param type Type of the records
+      * @param record_size Size of each record, in bytes. Only used by COLUMN_BYTES
+      * @return Index of the column
+      * @throw std::invalid_argument if the name or the size is not valid, or COLUMN_STATE3 is used for other cube sizes
+      */
+    size_t AddColumn(const std::string &name, ColumnType type, size_t record_size = 0);
+
+    /**
+      * @brief Appends a record to a column
+      * @param column Index of the column
+      * @param record Record of the size of the column
+      * @throw std::runtime_error if the column is full, or on write errors
+      */
+    void Append(size_t column, const void *record);
+
+    /**
+      * @brief Appends consecutive records to a column. Blocks larger than the buffer are written without copies
+      * @param column Index of the column
+      * @param records Array of num_records records of the size of the column
+      * @param num_records Number of records
+      * @throw std::runtime_error if the column is full, or on write errors
+      */
+    void Append(size_t column, const void *records, size_t num_records);
+
+    /**
+      * @brief Encodes a cube and appends it to a column of type COLUMN_STATE3 or COLUMN_FACELETS
+      * @param column Index of the column
+      * @param cube Cube, of the size of the file
+      * @throw std::invalid_argument if the column type is not valid, or the cube is not in a valid state
+      */
+    template<typename T, size_t CUBE_SIZE>
+    void AppendCube(size_t column, const RubikCube<T, CUBE_SIZE> &cube);
+
+    /**
+      * @brief Encodes a block of states into the buffer of a column of type COLUMN_STATE3 or COLUMN_FACELETS
+      * @param column Index of the column
+      * @param facelets Face elements of num_states cubes of the size of the file, in the order of FaceletsToString
+      * @param num_states Number of states
+      * @throw std::invalid_argument if the column type is not valid, or some state is not valid. Only the states
+      *        before it are appended then
+      */
+    void AppendFacelets(size_t column, const FaceElement *facelets, size_t num_states);
+
+    /**
+      * @brief Writes the buffers and the directory of the columns, and closes the file
+      * @throw std::runtime_error if some column doesn't have all the records, or the file could not be written.
+      *        The file is removed then
+      */
+    void Close();
+};
+
+
+/**
+  * @brief Memory-mapped state file
+  */
+class StateFileReader {
+private:
+    int fd;
+    const uint8_t *mapping;
+    size_t mapping_size;
+    const StateFileHeader *header;
+    const StateFileColumn *columns;
+
+public:
+    /**
+      * @brief Maps a state file and validates its header and columns
+      * @param filename Path of the file
+      * @throw std::runtime_error if the file could not be mapped or it is not a valid state file
+      */
+    explicit StateFileReader(const std::string &filename);
+
+    /**
+      * @brief Unmaps the file
+      */
+    ~StateFileReader();
+
+    StateFileReader(const StateFileReader&) = delete;
+    StateFileReader& operator=(const StateFileReader&) = delete;
+
+    size_t GetCubeSize() const;
+    size_t GetNumRecords() const;
+    size_t GetNumColumns() const;
+
+    /**
+      * @brief Returns index of a column
+      * @throw std::invalid_argument if there is no column with that name
+      */
+    size_t FindColumn(const std::string &name) const;
+
+    std::string GetColumnName(size_t column) const;
+    ColumnType GetColumnType(size_t column) const;
+    size_t GetRecordSize(size_t column) const;
+
+    /**
+      * @brief Returns a record, inside of the mapping
+      * @pre column in range [0, GetNumColumns()), index in range [0, GetNumRecords())
+      */
+    const uint8_t* GetRecord(size_t column, size_t index) const;
+
+    /**
+      * @brief Returns all the records of a column as an array
+      * @throw std::invalid_argument if the size of T is not the record size
+      */
+    template<typename T>
+    const T* GetColumnData(size_t column) const;
+
+    /**
+      * @brief Decodes a cube of a COLUMN_STATE3 or COLUMN_FACELETS column
+      * @return False if the record is not a valid state
+      * @throw std::invalid_argument if the column type or the cube size are not valid
+      */
+    template<typename T, size_t CUBE_SIZE>
+    bool ReadCube(size_t column, size_t index, RubikCube<T, CUBE_SIZE> &cube) const;
+
+    /**
+      * @brief Decodes consecutive records of a COLUMN_STATE3 or COLUMN_FACELETS column
+      * @pre first + num_states <= GetNumRecords()
+      * @param facelets Output face elements of num_states cubes, in the order of FaceletsToString
+      * @return Number of records decoded before the first one which is not a valid state
+      * @throw std::invalid_argument if the column type or the cube size are not valid
+      */
+    size_t ReadFacelets(size_t column, size_t first, size_t num_states, FaceElement *facelets) const;
+};
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+/**
+  * @brief Encodes a 3x3 cube as coordinates. Other sizes don't have this encoding
+  */
+template<typename T>
+bool EncodeStateRecord(const RubikCube<T, 3> &cube, uint8_t *data) {
+    return EncodeState3(cube, data);
+}
+
+template<typename T, size_t CUBE_SIZE>
+bool EncodeStateRecord(const RubikCube<T, CUBE_SIZE> &cube, uint8_t *data) {
+    throw std::invalid_argument("Coordinate encoding is only defined for 3x3 cubes");
+}
+
+template<typename T>
+bool DecodeStateRecord(const uint8_t *data, RubikCube<T, 3> &cube) {
+    return DecodeState3(data, cube);
+}
+
+template<typename T, size_t CUBE_SIZE>
+bool DecodeStateRecord(const uint8_t *data, RubikCube<T, CUBE_SIZE> &cube) {
+    throw std::invalid_argument("Coordinate encoding is only defined for 3x3 cubes");
+}
+
+template<typename T, size_t CUBE_SIZE>
+void StateFileWriter::AppendCube(size_t column, const RubikCube<T, CUBE_SIZE> &cube) {
+    uint8_t record[GetPackedFaceletsSize(CUBE_SIZE) > STATE3_SIZE ? GetPackedFaceletsSize(CUBE_SIZE) : STATE3_SIZE];
+    assert(column < columns.size());
+    if(CUBE_SIZE != cube_size)
+        throw std::invalid_argument("Cube size doesn't match the file");
+    if(columns[column].type == COLUMN_STATE3) {
+        if(!EncodeStateRecord(cube, record))
+            throw std::invalid_argument("Cube is not in a valid state");
+    } else if(columns[column].type == COLUMN_FACELETS) {
+        PackFacelets(cube, record);
+    } else {
+        throw std::invalid_argument("Column doesn't hold cube states");
+    }
+    memcpy(Reserve(column, 1), record, columns[column].record_size);
+}
+
+template<typename T>
+const T* StateFileReader::GetColumnData(size_t column) const {
+    if(sizeof(T) != GetRecordSize(column))
+        throw std::invalid_argument("Record size of column " + GetColumnName(column) + " doesn't match");
+    return reinterpret_cast<const T*>(mapping + columns[column].offset);
+}
+
+template<typename T, size_t CUBE_SIZE>
+bool StateFileReader::ReadCube(size_t column, size_t index, RubikCube<T, CUBE_SIZE> &cube) const {
+    if(CUBE_SIZE != GetCubeSize())
+        throw std::invalid_argument("Cube size doesn't match the file");
+    if(GetColumnType(column) == COLUMN_STATE3)
+        return DecodeStateRecord(GetRecord(column, index), cube);
+    else if(GetColumnType(column) == COLUMN_FACELETS)
+        return UnpackFacelets(GetRecord(column, index), cube);
+    throw std::invalid_argument("Column doesn't hold cube states");
+}
+
+#endif
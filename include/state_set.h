@@ -0,0 +1,76 @@
+#ifndef __RUBIK_STATE_SET_H__
+#define __RUBIK_STATE_SET_H__
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+  * @brief Hash set of encoded states (see EncodeState3 and PackFacelets), with a small value for each one
+  *
+  * Keys of all the states have the same size. Each slot stores the key and its value in a single array,
+  * followed by a byte which is zero for empty slots, so probes read consecutive memory (open addressing with
+  * linear probing). The table doubles when it is 3/4 full. States can't be removed.
+  */
+class StateSet {
+private:
+    size_t key_size;
+    size_t slot_size;
+    size_t mask;
+    size_t num_states;
+    std::vector<uint8_t> slots;
+
+    /**
+      * @brief Returns hash of a key
+      */
+    uint64_t Hash(const uint8_t *key) const;
+
+    /**
+      * @brief Returns the slot of a key, or the empty slot where it would be inserted
+      */
+    uint8_t* FindSlot(const uint8_t *key);
+    const uint8_t* FindSlot(const uint8_t *key) const;
+
+    /**
+      * @brief Doubles the number of slots and inserts the states again
+      */
+    void Grow();
+
+public:
+    /**
+      * @brief Creates an empty set
+      * @param key_size Size of the keys, in bytes
+      * @param capacity Expected number of states. The set grows beyond it as needed
+      * @throw std::invalid_argument if key_size is 0
+      */
+    explicit StateSet(size_t key_size, size_t capacity = 1024);
+
+    /**
+      * @brief Inserts a state, if it is not in the set
+      * @param key Key of key_size bytes
+      * @param value Value of the state
+      * @return True if the state was inserted, false if it was already in the set. Its value is not changed then
+      */
+    bool Insert(const uint8_t *key, uint8_t value);
+
+    /**
+      * @brief Looks for a state
+      * @param value Value of the state. It is valid only if returned value is true
+      * @return True if the state is in the set
+      */
+    bool Find(const uint8_t *key, uint8_t &value) const;
+
+    /**
+      * @brief Returns number of states
+      */
+    size_t GetSize() const;
+
+    /**
+      * @brief Returns bytes used by the slots
+      */
+    size_t GetMemoryUsage() const;
+
+    size_t GetKeySize() const;
+};
+
+#endif
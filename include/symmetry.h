@@ -0,0 +1,286 @@
+#ifndef __RUBIK_SYMMETRY_H__
+#define __RUBIK_SYMMETRY_H__
+
+#include <rubik.h>
+#include <move_permutation.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/*    Number of symmetries of the cube: 24 rotations, and their mirror images    */
+const size_t NUM_SYMMETRIES = 48;
+
+/*    Symmetries [0, NUM_ROTATIONS) are whole cube rotations. The identity is symmetry 0    */
+const size_t NUM_ROTATIONS = 24;
+
+/**
+  * @brief Whole cube rotation or reflection, as a map of face elements
+  *
+  * Applying it to a state moves the face element at position sources[i] to position i, and repaints it with
+  * the color faces[color]: the face where the center of that color is moved. So the solved cube is left
+  * solved, and applying a symmetry, a move, and the inverse symmetry is a move too (see TransformMove).
+  */
+template<size_t CUBE_SIZE>
+struct CubeSymmetry {
+    std::array<uint16_t, 6*CUBE_SIZE*CUBE_SIZE> sources;
+    std::array<FaceElement, 6> faces;
+    // Reflections reverse the direction of the turns
+    bool reflection;
+};
+
+/**
+  * @brief Returns coordinate of a face element along an axis. Layers have odd or even coordinates in
+  *        [-(CUBE_SIZE-1), CUBE_SIZE-1], from LEFT, BOTTOM or BACK faces. Faces of the axis are at +-CUBE_SIZE
+  * @param axis 0, 1 or 2 for X (LEFT to RIGHT), Y (BOTTOM to TOP) or Z (BACK to FRONT)
+  */
+template<size_t CUBE_SIZE>
+constexpr std::array<std::array<int, 3>, 6*CUBE_SIZE*CUBE_SIZE> MakeFaceletCoordinates() {
+    const FaceElement axis_faces[3] = { LEFT, TOP, FRONT };
+    const FaceElement positive_faces[3] = { RIGHT, TOP, FRONT };
+    std::array<std::array<int, 3>, 6*CUBE_SIZE*CUBE_SIZE> coordinates = {};
+    for(size_t axis=0; axis<3; ++axis) {
+        // Face elements of a layer are the lateral ones, so each one is in a layer of the other two axes
+        for(size_t depth=0; depth<CUBE_SIZE; ++depth)
+            for(long pos=0; pos<(long)(4*CUBE_SIZE); ++pos)
+                coordinates[GetLayerFaceletPosition(CUBE_SIZE, axis_faces[axis], pos, depth)][axis] =
+                    (int)CUBE_SIZE-1 - 2*(int)depth;
+        for(size_t i=0; i<CUBE_SIZE*CUBE_SIZE; ++i) {
+            const FaceElement positive = positive_faces[axis];
+            const FaceElement negative = (FaceElement)(positive ^ 1);
+            coordinates[positive*CUBE_SIZE*CUBE_SIZE + i][axis] = CUBE_SIZE;
+            coordinates[negative*CUBE_SIZE*CUBE_SIZE + i][axis] = -(int)CUBE_SIZE;
+        }
+    }
+    return coordinates;
+}
+
+/**
+  * @brief Computes a symmetry from its matrix: coordinate k of a moved point is signs[k]*coordinate axes[k]
+  * @param axes Permutation of the axes
+  * @param signs Sign of each coordinate, 1 or -1
+  */
+template<size_t CUBE_SIZE>
+constexpr CubeSymmetry<CUBE_SIZE> MakeSymmetry(const size_t *axes, const int *signs) {
+    const size_t num_facelets = 6*CUBE_SIZE*CUBE_SIZE;
+    const size_t side = 2*CUBE_SIZE+1;
+    const FaceElement positive_faces[3] = { RIGHT, TOP, FRONT };
+    const std::array<std::array<int, 3>, 6*CUBE_SIZE*CUBE_SIZE> coordinates = MakeFaceletCoordinates<CUBE_SIZE>();
+    std::array<uint16_t, (2*CUBE_SIZE+1)*(2*CUBE_SIZE+1)*(2*CUBE_SIZE+1)> positions = {};
+    CubeSymmetry<CUBE_SIZE> symmetry = {};
+
+    for(size_t i=0; i<num_facelets; ++i)
+        positions[((coordinates[i][0]+CUBE_SIZE)*side + coordinates[i][1]+CUBE_SIZE)*side + coordinates[i][2]+CUBE_SIZE] = i;
+    for(size_t i=0; i<num_facelets; ++i) {
+        int moved[3] = {};
+        for(size_t k=0; k<3; ++k)
+            moved[k] = signs[k] * coordinates[i][axes[k]];
+        symmetry.sources[positions[((moved[0]+CUBE_SIZE)*side + moved[1]+CUBE_SIZE)*side + moved[2]+CUBE_SIZE]] = i;
+    }
+
+    // Face of axis 'axes[k]' is moved to axis k
+    int determinant = signs[0]*signs[1]*signs[2];
+    for(size_t k=0; k<3; ++k) {
+        const FaceElement positive = positive_faces[axes[k]];
+        const FaceElement negative = (FaceElement)(positive ^ 1);
+        symmetry.faces[positive] = signs[k] > 0 ? positive_faces[k] : (FaceElement)(positive_faces[k] ^ 1);
+        symmetry.faces[negative] = (FaceElement)(symmetry.faces[positive] ^ 1);
+        for(size_t j=k+1; j<3; ++j)
+            if(axes[j] < axes[k])
+                determinant = -determinant;
+    }
+    symmetry.reflection = determinant < 0;
+    return symmetry;
+}
+
+/**
+  * @brief Computes the 48 symmetries. Rotations go first, and the identity is the first one
+  */
+template<size_t CUBE_SIZE>
+constexpr std::array<CubeSymmetry<CUBE_SIZE>, NUM_SYMMETRIES> MakeSymmetries() {
+    const size_t axes[6][3] = { {0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0} };
+    std::array<CubeSymmetry<CUBE_SIZE>, NUM_SYMMETRIES> symmetries = {};
+    size_t num_rotations = 0;
+    size_t num_reflections = 0;
+    for(size_t permutation=0; permutation<6; ++permutation) {
+        for(size_t sign_bits=0; sign_bits<8; ++sign_bits) {
+            const int signs[3] = { sign_bits & 1 ? -1 : 1, sign_bits & 2 ? -1 : 1, sign_bits & 4 ? -1 : 1 };
+            CubeSymmetry<CUBE_SIZE> symmetry = MakeSymmetry<CUBE_SIZE>(axes[permutation], signs);
+            if(symmetry.reflection)
+                symmetries[NUM_ROTATIONS + num_reflections++] = symmetry;
+            else
+                symmetries[num_rotations++] = symmetry;
+        }
+    }
+    return symmetries;
+}
+
+/**
+  * @brief Computes the index of the inverse of each symmetry
+  */
+template<size_t CUBE_SIZE>
+constexpr std::array<uint8_t, NUM_SYMMETRIES> MakeInverseSymmetries(
+    const std::array<CubeSymmetry<CUBE_SIZE>, NUM_SYMMETRIES> &symmetries)
+{
+    std::array<uint8_t, NUM_SYMMETRIES> inverses = {};
+    for(size_t s=0; s<NUM_SYMMETRIES; ++s) {
+        // A symmetry is identified by where it moves the faces
+        for(size_t t=0; t<NUM_SYMMETRIES; ++t) {
+            bool inverse = true;
+            for(size_t face=0; face<6; ++face)
+                inverse = inverse && symmetries[t].faces[symmetries[s].faces[face]] == (FaceElement)face;
+            if(inverse)
+                inverses[s] = t;
+        }
+    }
+    return inverses;
+}
+
+/**
+  * @brief Checks that symmetries leave the solved cube solved, and are undone by their inverses
+  */
+template<size_t CUBE_SIZE>
+constexpr bool AreSymmetriesValid(const std::array<CubeSymmetry<CUBE_SIZE>, NUM_SYMMETRIES> &symmetries,
+                                  const std::array<uint8_t, NUM_SYMMETRIES> &inverses) {
+    const size_t face_size = CUBE_SIZE*CUBE_SIZE;
+    for(size_t s=0; s<NUM_SYMMETRIES; ++s) {
+        const CubeSymmetry<CUBE_SIZE> &symmetry = symmetries[s];
+        const CubeSymmetry<CUBE_SIZE> &inverse = symmetries[inverses[s]];
+        if(symmetry.reflection != (s >= NUM_ROTATIONS) || inverse.reflection != symmetry.reflection)
+            return false;
+        for(size_t i=0; i<6*face_size; ++i)
+            if(symmetry.faces[symmetry.sources[i] / face_size] != (FaceElement)(i / face_size) ||
+               symmetry.sources[inverse.sources[i]] != i)
+                return false;
+    }
+    for(size_t i=0; i<6*face_size; ++i)
+        if(symmetries[0].sources[i] != i)
+            return false;
+    return true;
+}
+
+/**
+  * @brief Symmetries of a NxN cube, computed at compile time
+  */
+template<size_t CUBE_SIZE>
+struct SymmetryTable {
+    static constexpr std::array<CubeSymmetry<CUBE_SIZE>, NUM_SYMMETRIES> SYMMETRIES = MakeSymmetries<CUBE_SIZE>();
+    static constexpr std::array<uint8_t, NUM_SYMMETRIES> INVERSES = MakeInverseSymmetries<CUBE_SIZE>(SYMMETRIES);
+
+    static_assert(AreSymmetriesValid<CUBE_SIZE>(SYMMETRIES, INVERSES), "Symmetries shall map faces onto faces");
+};
+
+
+/**
+  * @brief Returns the symmetry which undoes another one
+  * @pre symmetry < NUM_SYMMETRIES
+  */
+template<size_t CUBE_SIZE>
+size_t GetInverseSymmetry(size_t symmetry);
+
+/**
+  * @brief Applies a symmetry to a state
+  * @pre symmetry < NUM_SYMMETRIES
+  * @param facelets Face elements of the state, in the order of FaceletsToString
+  * @param output Face elements of the symmetric state. It shall not overlap 'facelets'
+  */
+template<size_t CUBE_SIZE>
+void ApplySymmetry(size_t symmetry, const FaceElement *facelets, FaceElement *output);
+
+/**
+  * @brief Returns the move which does on a symmetric state what 'move' does on the original one: applying
+  *        'move' and then 'symmetry' is the same as applying 'symmetry' and then the returned move
+  * @pre symmetry < NUM_SYMMETRIES
+  */
+template<size_t CUBE_SIZE>
+Move TransformMove(size_t symmetry, const Move &move);
+
+/**
+  * @brief Computes the canonical form of a state: the least of its symmetric states, comparing face
+  *        elements in order. States have the same canonical form only if they are symmetric
+  *
+  * Symmetric states are compared while they are built, and discarded at their first greater face element,
+  * so most of them cost a few reads.
+  * @param facelets Face elements of the state, in the order of FaceletsToString
+  * @param canonical Face elements of the canonical form. It shall not overlap 'facelets'
+  * @param num_symmetries NUM_SYMMETRIES, or NUM_ROTATIONS to not consider mirror images
+  * @return Symmetry which moves the state to its canonical form. Its inverse (see GetInverseSymmetry) moves
+  *         the canonical form back to the state
+  */
+template<size_t CUBE_SIZE>
+size_t CanonicalizeFacelets(const FaceElement *facelets, FaceElement *canonical, size_t num_symmetries = NUM_SYMMETRIES);
+
+/**
+  * @brief Computes the canonical form of the state of a cube (see CanonicalizeFacelets)
+  */
+template<typename T, size_t CUBE_SIZE>
+size_t CanonicalizeState(const RubikCube<T, CUBE_SIZE> &cube, FaceElement *canonical,
+                         size_t num_symmetries = NUM_SYMMETRIES);
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+template<size_t CUBE_SIZE>
+size_t GetInverseSymmetry(size_t symmetry) {
+    assert(symmetry < NUM_SYMMETRIES);
+    return SymmetryTable<CUBE_SIZE>::INVERSES[symmetry];
+}
+
+template<size_t CUBE_SIZE>
+void ApplySymmetry(size_t symmetry, const FaceElement *facelets, FaceElement *output) {
+    assert(symmetry < NUM_SYMMETRIES);
+    const CubeSymmetry<CUBE_SIZE> &table = SymmetryTable<CUBE_SIZE>::SYMMETRIES[symmetry];
+    for(size_t i=0; i<table.sources.size(); ++i)
+        output[i] = table.faces[facelets[table.sources[i]]];
+}
+
+template<size_t CUBE_SIZE>
+Move TransformMove(size_t symmetry, const Move &move) {
+    assert(symmetry < NUM_SYMMETRIES);
+    const CubeSymmetry<CUBE_SIZE> &table = SymmetryTable<CUBE_SIZE>::SYMMETRIES[symmetry];
+    Move transformed = move;
+    transformed.face = table.faces[move.face];
+    if(table.reflection)
+        transformed.clockwise = move.clockwise == CLOCKWISE ? COUNTERCLOCKWISE : CLOCKWISE;
+    return transformed;
+}
+
+template<size_t CUBE_SIZE>
+size_t CanonicalizeFacelets(const FaceElement *facelets, FaceElement *canonical, size_t num_symmetries) {
+    assert(num_symmetries > 0 && num_symmetries <= NUM_SYMMETRIES);
+    const size_t num_facelets = 6*CUBE_SIZE*CUBE_SIZE;
+    size_t best = 0;
+
+    for(size_t i=0; i<num_facelets; ++i)
+        canonical[i] = facelets[i];
+    for(size_t s=1; s<num_symmetries; ++s) {
+        const CubeSymmetry<CUBE_SIZE> &symmetry = SymmetryTable<CUBE_SIZE>::SYMMETRIES[s];
+        size_t i = 0;
+        FaceElement value = INVALID;
+        while(i < num_facelets && (value = symmetry.faces[facelets[symmetry.sources[i]]]) == canonical[i])
+            ++i;
+        if(i == num_facelets || value > canonical[i])
+            continue;
+        // Lesser: rest of the symmetric state replaces the current canonical form
+        canonical[i] = value;
+        for(++i; i<num_facelets; ++i)
+            canonical[i] = symmetry.faces[facelets[symmetry.sources[i]]];
+        best = s;
+    }
+    return best;
+}
+
+template<typename T, size_t CUBE_SIZE>
+size_t CanonicalizeState(const RubikCube<T, CUBE_SIZE> &cube, FaceElement *canonical, size_t num_symmetries) {
+    std::array<FaceElement, 6*CUBE_SIZE*CUBE_SIZE> facelets;
+    size_t i = 0;
+    for(size_t face=0; face<cube.GetNumFaces(); ++face)
+        for(size_t row=0; row<CUBE_SIZE; ++row)
+            for(size_t col=0; col<CUBE_SIZE; ++col)
+                facelets[i++] = cube.GetFaceElement((FaceElement)face, row, col);
+    return CanonicalizeFacelets<CUBE_SIZE>(facelets.data(), canonical, num_symmetries);
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef __RUBIK_THREAD_POOL_H__
+#define __RUBIK_THREAD_POOL_H__
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+/**
+  * @brief Fixed set of threads which run submitted tasks in submission order
+  */
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping;
+
+    /**
+      * @brief Body of worker threads. Runs tasks until the pool is destroyed
+      */
+    void WorkerLoop();
+
+public:
+    /**
+      * @brief Starts the worker threads
+      * @param num_threads Number of threads. Zero selects the number of hardware threads
+      */
+    explicit ThreadPool(size_t num_threads = 0);
+
+    /**
+      * @brief Runs pending tasks and joins the worker threads
+      */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+      * @brief Returns number of worker threads
+      */
+    size_t GetNumThreads() const;
+
+    /**
+      * @brief Enqueues a task
+      * @param function Callable object without parameters
+      * @return Future of the value returned by the task. Exceptions thrown by the task are rethrown by future::get
+      */
+    template<typename Function>
+    auto Submit(Function function) -> std::future<decltype(function())>;
+};
+
+
+
+
+
+
+/******* IMPLEMENTATION *******/
+template<typename Function>
+auto ThreadPool::Submit(Function function) -> std::future<decltype(function())> {
+    // std::function requires copyable objects, so the task is shared
+    auto task = std::make_shared<std::packaged_task<decltype(function())()>>(std::move(function));
+    std::future<decltype(function())> result = task->get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push([task]() { (*task)(); });
+    }
+    condition.notify_one();
+    return result;
+}
+
+#endif
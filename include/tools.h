@@ -1,3 +1,6 @@
+#ifndef __RUBIK_TOOLS_H__
+#define __RUBIK_TOOLS_H__
+
 #include <cstdlib>
 #include <vector>
 
@@ -38,6 +41,24 @@ double positive_mod(double num, double den);
   */
 double get_current_time();
 
+/**
+  * @brief Get time from a monotonic clock, in seconds. It is not affected by changes of system time
+  * @return Returns current time since an unspecified starting point, in seconds
+  */
+double get_monotonic_time();
+
+/**
+  * @brief Returns resident memory of current process, read from /proc/self/status
+  * @return Resident set size, in bytes. Zero if it could not be read
+  */
+size_t get_resident_memory();
+
+/**
+  * @brief Returns memory of current process backed by transparent huge pages, read from /proc/self/smaps_rollup
+  * @return Bytes of anonymous huge pages. Zero if it could not be read
+  */
+size_t get_huge_page_memory();
+
 /**
   * @brief Converts an angle from degrees to radians
   * @param angle Angle in degrees
@@ -66,3 +87,5 @@ void RotateElements(int offset, size_t container_size, Getter get, Setter set) {
     for(int i=0; i<offset; ++i)
         set(((int)container_size-offset+i+i_offset)*increment, tmp[i]);
 }
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef __RUBIK_TRANSPOSITION_TABLE_H__
+#define __RUBIK_TRANSPOSITION_TABLE_H__
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/*    Maximum depth of an entry, which is stored in a byte    */
+const size_t MAX_TRANSPOSITION_DEPTH = 255;
+
+/*    Policies to choose the entry of a bucket a new state replaces    */
+typedef enum {
+    REPLACE_ALWAYS = 0, // The entry selected by the key, like a direct mapped table
+    REPLACE_SHALLOWER   // The entry with least depth. Entries of older generations go first
+} ReplacementPolicy;
+
+/**
+  * @brief Result of a search from a state. Meaning of the fields is up to the solver: for example, a bound of
+  *        the distance to the solution, the best move found, and the remaining depth of the search
+  */
+struct TranspositionEntry {
+    uint32_t value;
+    uint16_t data;
+    uint8_t depth;  // At most MAX_TRANSPOSITION_DEPTH
+};
+
+/**
+  * @brief Fixed size hash table from state hashes (see RubikCube::Hash) to search results, which can be shared
+  *        by several threads without locks
+  *
+  * Entries are grouped in buckets of a cache line. Each entry stores its data, and its key xor its data, in
+  * two atomic words. Writers don't synchronize, so two concurrent stores may mix their words, but a reader
+  * then finds a key which doesn't match and takes the entry as missing. Stores may be lost, so the table
+  * is a cache: solvers shall be correct without it.
+  */
+class TranspositionTable {
+private:
+    static const size_t BUCKET_SIZE = 4;
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    struct Slot {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Bucket {
+        Slot slots[BUCKET_SIZE];
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucket_mask;
+    ReplacementPolicy policy;
+    std::atomic<uint64_t> generation;
+
+public:
+    /**
+      * @brief Allocates an empty table
+      * @param num_entries Minimum number of entries. It is rounded up to a power of two
+      * @param policy Replacement policy of the stores
+      * @throw std::invalid_argument if num_entries is 0
+      */
+    explicit TranspositionTable(size_t num_entries, ReplacementPolicy policy = REPLACE_SHALLOWER);
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    /**
+      * @brief Looks for the entry of a state. It can be called from any thread
+      * @param key Hash of the state
+      * @param entry Entry of the state. It is valid only if returned value is true
+      * @return True if the state was found
+      */
+    bool Probe(uint64_t key, TranspositionEntry &entry) const;
+
+    /**
+      * @brief Stores the entry of a state, as the replacement policy allows. It can be called from any thread
+      * @param key Hash of the state
+      * @param entry Entry to store. With REPLACE_SHALLOWER, an entry of the same state and generation with
+      *              greater depth is kept instead
+      */
+    void Store(uint64_t key, const TranspositionEntry &entry);
+
+    /**
+      * @brief Starts a new generation, for example a new search. Entries of older generations are kept, but
+      *        REPLACE_SHALLOWER replaces them first
+      */
+    void NewGeneration();
+
+    /**
+      * @brief Removes all the entries
+      * @pre No other thread uses the table
+      */
+    void Clear();
+
+    /**
+      * @brief Returns maximum number of entries
+      */
+    size_t GetNumEntries() const;
+
+    ReplacementPolicy GetPolicy() const;
+};
+
+#endif
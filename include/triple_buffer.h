@@ -0,0 +1,99 @@
+#ifndef __RUBIK_TRIPLE_BUFFER_H__
+#define __RUBIK_TRIPLE_BUFFER_H__
+
+#include <atomic>
+#include <array>
+#include <cstdint>
+
+/**
+  * @brief Shares values between one writer thread and one reader thread without locks
+  *
+  * Writer fills the back buffer and publishes it, which swaps it with the middle buffer. Reader swaps
+  * the middle buffer with the front buffer only if there is a new value. Neither thread waits for the other one.
+  */
+template<typename T>
+class TripleBuffer {
+private:
+    static constexpr uint8_t INDEX_MASK = 0x03;
+    static constexpr uint8_t DIRTY_FLAG = 0x04; // Middle buffer has not been read yet
+
+    std::array<T, 3> buffers;
+    std::atomic<uint8_t> middle;
+    uint8_t back;  // Only used by writer
+    uint8_t front; // Only used by reader
+
+public:
+    /**
+      * @brief Initializes all buffers with the same value
+      * @param initial Initial value of the buffers
+      */
+    TripleBuffer(const T &initial = T());
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    /**
+      * @brief Returns buffer which can be modified by the writer
+      * @pre Called from writer thread
+      */
+    T& GetWriteBuffer();
+
+    /**
+      * @brief Makes the write buffer visible to the reader
+      * @pre Called from writer thread
+      */
+    void Publish();
+
+    /**
+      * @brief Makes the last published value available in the read buffer
+      * @pre Called from reader thread
+      * @return True if there was a new published value. False in other case
+      */
+    bool Update();
+
+    /**
+      * @brief Returns last value obtained by 'Update'
+      * @pre Called from reader thread
+      */
+    const T& GetReadBuffer() const;
+};
+
+
+
+
+
+
+/******* IMPLEMENTATION ********/
+template<typename T>
+TripleBuffer<T>::TripleBuffer(const T &initial)
+    : buffers({initial, initial, initial}), middle(1), back(0), front(2)
+{
+
+}
+
+template<typename T>
+T& TripleBuffer<T>::GetWriteBuffer() {
+    return buffers[back];
+}
+
+template<typename T>
+void TripleBuffer<T>::Publish() {
+    uint8_t previous = middle.exchange(back | DIRTY_FLAG, std::memory_order_acq_rel);
+    back = previous & INDEX_MASK;
+}
+
+template<typename T>
+bool TripleBuffer<T>::Update() {
+    if(!(middle.load(std::memory_order_relaxed) & DIRTY_FLAG))
+        return false;
+    uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+    front = previous & INDEX_MASK;
+    return true;
+}
+
+template<typename T>
+const T& TripleBuffer<T>::GetReadBuffer() const {
+    return buffers[front];
+}
+
+#endif
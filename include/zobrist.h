@@ -0,0 +1,71 @@
+#ifndef __RUBIK_ZOBRIST_H__
+#define __RUBIK_ZOBRIST_H__
+
+#include <cube_types.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+  * Zobrist hashing of cube states: the hash of a state is the xor of a random key for each face element,
+  * selected by its position and its color. A move only changes the terms of the face elements it moves, so
+  * hashes are updated incrementally.
+  */
+
+/*    Colors with a key: the faces, and INVALID    */
+const size_t ZOBRIST_COLORS = INVALID+1;
+
+/*    Seed of the keys. Hashes are stable across runs and builds    */
+const uint64_t ZOBRIST_SEED = 0x525542494b435542ull;
+
+/**
+  * @brief SplitMix64 step, usable at compile time
+  */
+constexpr uint64_t ZobristMix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+/**
+  * @brief Computes the keys of a NxN cube, indexed by position*ZOBRIST_COLORS + color
+  */
+template<size_t CUBE_SIZE>
+constexpr std::array<uint64_t, 6*CUBE_SIZE*CUBE_SIZE*ZOBRIST_COLORS> MakeZobristKeys() {
+    std::array<uint64_t, 6*CUBE_SIZE*CUBE_SIZE*ZOBRIST_COLORS> keys = {};
+    for(size_t i=0; i<keys.size(); ++i)
+        keys[i] = ZobristMix(ZOBRIST_SEED ^ ZobristMix(CUBE_SIZE*keys.size() + i));
+    return keys;
+}
+
+/**
+  * @brief Zobrist keys of a NxN cube, computed at compile time
+  */
+template<size_t CUBE_SIZE>
+struct ZobristTable {
+    static constexpr std::array<uint64_t, 6*CUBE_SIZE*CUBE_SIZE*ZOBRIST_COLORS> KEYS = MakeZobristKeys<CUBE_SIZE>();
+
+    /**
+      * @brief Returns the key of a face element
+      * @param position Position of the face element, in the order of FaceletsToString
+      * @param color Color of the face element
+      */
+    static constexpr uint64_t GetKey(size_t position, FaceElement color) {
+        return KEYS[position*ZOBRIST_COLORS + color];
+    }
+};
+
+/**
+  * @brief Computes the hash of an array of face elements, in the order of FaceletsToString. It is the one
+  *        RubikCube::Hash returns for that state
+  */
+template<size_t CUBE_SIZE>
+constexpr uint64_t HashFacelets(const FaceElement *facelets) {
+    uint64_t hash = 0;
+    for(size_t i=0; i<6*CUBE_SIZE*CUBE_SIZE; ++i)
+        hash ^= ZobristTable<CUBE_SIZE>::GetKey(i, facelets[i]);
+    return hash;
+}
+
+#endif
@@ -0,0 +1,204 @@
+#include <graphical_cube.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cstdio>
+#include <cmath>
+
+/*    Script of each benchmark: layer turns of FRAMES_PER_MOVE frames separated by IDLE_FRAMES still frames    */
+const size_t FRAMES_PER_MOVE = 8;
+const size_t IDLE_FRAMES = 4;
+/*    Picking is measured every PICKING_PERIOD frames, on a grid of PICKING_GRID x PICKING_GRID screen points    */
+const size_t PICKING_PERIOD = 5;
+const size_t PICKING_GRID = 4;
+/*    Moves are generated with a fixed seed, so all runs follow the same script    */
+const unsigned int SCRIPT_SEED = 12345;
+
+struct BenchmarkOptions {
+    size_t width = 512;
+    size_t height = 512;
+    size_t num_frames = 300;
+};
+
+struct BenchmarkResult {
+    size_t cube_size;
+    double build_time;
+    size_t memory_before;
+    size_t memory_after;
+    std::vector<double> frame_times;
+    std::vector<double> picking_times;
+};
+
+
+/**
+  * @brief Prints usage of the program
+  * @param program Name of the executable
+  */
+void PrintUsage(const char *program) {
+    std::cerr << "Usage: " << program << " [options] > results.json\n"
+              << "Renders a scripted sequence of camera moves and layer turns with the software renderer,\n"
+              << "for cube sizes 2, 3, 5, 10 and 20, and prints measures as JSON\n"
+              << "Options:\n"
+              << "    --width W     Frame width, in pixels (default 512)\n"
+              << "    --height H    Frame height, in pixels (default 512)\n"
+              << "    --frames F    Minimum number of frames per cube size (default 300)" << std::endl;
+}
+
+/**
+  * @brief Parses command line options
+  * @return False if options are not valid
+  */
+bool ParseOptions(int argc, char *argv[], BenchmarkOptions &options) {
+    for(int i=1; i<argc; i+=2) {
+        std::string option = argv[i];
+        if(i+1 >= argc)
+            return false;
+        std::string value = argv[i+1];
+        try {
+            if(option == "--width")
+                options.width = std::stoul(value);
+            else if(option == "--height")
+                options.height = std::stoul(value);
+            else if(option == "--frames")
+                options.num_frames = std::stoul(value);
+            else
+                return false;
+        } catch(const std::logic_error &e) {
+            return false;
+        }
+    }
+    return options.width > 0 && options.height > 0 && options.num_frames > 0;
+}
+
+/**
+  * @brief Returns a percentile of some measures
+  * @pre percentile in range [0, 100]
+  * @return Percentile, or zero if there are no measures
+  */
+double Percentile(std::vector<double> values, double percentile) {
+    if(values.empty())
+        return 0.0;
+    size_t pos = (size_t)(percentile / 100.0 * (values.size()-1) + 0.5);
+    std::nth_element(values.begin(), values.begin()+pos, values.end());
+    return values[pos];
+}
+
+/**
+  * @brief Returns the mean of some measures, or zero if there are no measures
+  */
+double Mean(const std::vector<double> &values) {
+    double sum = 0.0;
+    for(size_t i=0; i<values.size(); ++i)
+        sum += values[i];
+    return values.empty() ? 0.0 : sum / values.size();
+}
+
+/**
+  * @brief Writes distribution of some measures as a JSON object, in milliseconds
+  */
+std::string DistributionToJSON(const std::vector<double> &values) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer),
+             "{\"count\": %zu, \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f}",
+             values.size(), Mean(values)*1000.0, Percentile(values, 50)*1000.0, Percentile(values, 90)*1000.0,
+             Percentile(values, 99)*1000.0, Percentile(values, 100)*1000.0);
+    return buffer;
+}
+
+/**
+  * @brief Builds a cube and renders the scripted sequence of frames
+  */
+template<size_t CUBE_SIZE>
+BenchmarkResult RunBenchmark(const BenchmarkOptions &options) {
+    BenchmarkResult result;
+    std::mt19937 generator(SCRIPT_SEED);
+    std::uniform_int_distribution<int> face_distribution(0, 5);
+    std::uniform_int_distribution<int> clockwise_distribution(0, 1);
+    std::uniform_int_distribution<size_t> depth_distribution(0, CUBE_SIZE-1);
+    size_t frame = 0;
+    double build_start;
+
+    result.cube_size = CUBE_SIZE;
+    result.memory_before = get_resident_memory();
+    build_start = get_monotonic_time();
+    GraphicalRubikCube<CUBE_SIZE> cube(L"", options.width, options.height, 1.0, HEADLESS);
+    result.build_time = get_monotonic_time() - build_start;
+    result.memory_after = get_resident_memory();
+
+    auto render_frame = [&](size_t) {
+        // Camera orbits once around the cube, while it goes up and down twice
+        double t = (double)frame / options.num_frames;
+        cube.SetCameraOrientation(2.0*M_PI*t, 0.6*std::sin(4.0*M_PI*t));
+        result.frame_times.push_back(cube.RenderFrame());
+
+        if(frame % PICKING_PERIOD == 0) {
+            for(size_t i=0; i<PICKING_GRID*PICKING_GRID; ++i) {
+                irr::core::position2di pos((i % PICKING_GRID + 0.5) * options.width / PICKING_GRID,
+                                           (i / PICKING_GRID + 0.5) * options.height / PICKING_GRID);
+                size_t row, col;
+                double picking_start = get_monotonic_time();
+                cube.PickFaceElement(pos, row, col);
+                result.picking_times.push_back(get_monotonic_time() - picking_start);
+            }
+        }
+        ++frame;
+    };
+
+    while(frame < options.num_frames) {
+        Move move = {(FaceElement)face_distribution(generator), (Clockwise)clockwise_distribution(generator),
+                     depth_distribution(generator)};
+        cube.AnimateMove(move, FRAMES_PER_MOVE, render_frame);
+        for(size_t i=0; i<IDLE_FRAMES; ++i)
+            render_frame(i);
+    }
+
+    return result;
+}
+
+/**
+  * @brief Writes results of a cube size as a JSON object
+  */
+std::string ResultToJSON(const BenchmarkResult &result) {
+    std::ostringstream json;
+    json << "{\"cube_size\": " << result.cube_size
+         << ", \"face_elements\": " << 6*result.cube_size*result.cube_size
+         << ", \"build_ms\": " << result.build_time*1000.0
+         << ", \"frame_ms\": " << DistributionToJSON(result.frame_times)
+         << ", \"picking_ms\": " << DistributionToJSON(result.picking_times)
+         << ", \"memory_kb\": {\"before\": " << result.memory_before/1024
+         << ", \"after_build\": " << result.memory_after/1024
+         << ", \"build_delta\": " << ((long)result.memory_after - (long)result.memory_before)/1024 << "}}";
+    return json.str();
+}
+
+int main(int argc, char *argv[]) {
+    BenchmarkOptions options;
+    std::vector<BenchmarkResult> results;
+
+    if(!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        results.push_back(RunBenchmark<2>(options));
+        results.push_back(RunBenchmark<3>(options));
+        results.push_back(RunBenchmark<5>(options));
+        results.push_back(RunBenchmark<10>(options));
+        results.push_back(RunBenchmark<20>(options));
+    } catch(const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "{\"renderer\": \"burningsvideo\", \"width\": " << options.width << ", \"height\": " << options.height
+              << ", \"frames\": " << options.num_frames << ",\n \"results\": [\n";
+    for(size_t i=0; i<results.size(); ++i)
+        std::cout << "  " << ResultToJSON(results[i]) << (i+1 < results.size() ? ",\n" : "\n");
+    std::cout << "]}" << std::endl;
+
+    return 0;
+}
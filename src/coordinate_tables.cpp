@@ -0,0 +1,317 @@
+#include <coordinate_tables.h>
+#include <zobrist.h>
+#include <future>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+
+/*    Edges of the slice between TOP and BOTTOM faces    */
+static const size_t NUM_SLICE_EDGES = 4;
+
+/**
+  * @brief Returns the binomial coefficient n choose k, or zero if k > n
+  */
+static uint32_t Choose(size_t n, size_t k) {
+    uint32_t result = 1;
+    if(k > n)
+        return 0;
+    for(size_t i=0; i<k; ++i)
+        result = result * (n-i) / (i+1);
+    return result;
+}
+
+/**
+  * @brief Returns the edge pieces of the slice, in increasing order
+  */
+static std::array<uint8_t, NUM_SLICE_EDGES> GetSliceEdges() {
+    std::array<uint8_t, NUM_SLICE_EDGES> edges;
+    size_t num_edges = 0;
+    for(size_t i=0; i<NUM_EDGES3; ++i)
+        if(IsSliceEdge3(i))
+            edges[num_edges++] = i;
+    assert(num_edges == NUM_SLICE_EDGES);
+    return edges;
+}
+
+/**
+  * @brief Computes the slice coordinates: rank of the combination of slots of the slice edges, and rank of
+  *        the order of the slice edges, as found from the first slot to the last one
+  */
+static void GetSliceRanks(const CubieState3 &cubies, uint32_t &combination, uint32_t &order) {
+    static const std::array<uint8_t, NUM_SLICE_EDGES> slice_edges = GetSliceEdges();
+    std::array<uint8_t, NUM_SLICE_EDGES> permutation;
+    size_t found = 0;
+    int parity;
+
+    combination = 0;
+    for(size_t slot=0; slot<NUM_EDGES3; ++slot) {
+        uint8_t edge = cubies.edge_permutation[slot];
+        if(!IsSliceEdge3(edge))
+            continue;
+        for(size_t i=0; i<NUM_SLICE_EDGES; ++i)
+            if(slice_edges[i] == edge)
+                permutation[found] = i;
+        // Combinatorial number system: the k-th slot s adds s choose k+1
+        combination += Choose(slot, found+1);
+        ++found;
+    }
+    order = RankPermutation(permutation, parity);
+}
+
+/**
+  * @brief Places the edges so the slice coordinates have the given ranks. Other edges are placed in
+  *        increasing order in the remaining slots, and flips are kept
+  */
+static void SetSliceRanks(uint32_t combination, uint32_t order, CubieState3 &cubies) {
+    static const std::array<uint8_t, NUM_SLICE_EDGES> slice_edges = GetSliceEdges();
+    std::array<bool, NUM_EDGES3> is_slice_slot = {};
+    int parity;
+
+    for(size_t k=NUM_SLICE_EDGES; k-- > 0;) {
+        size_t slot = k;
+        while(Choose(slot+1, k+1) <= combination)
+            ++slot;
+        combination -= Choose(slot, k+1);
+        is_slice_slot[slot] = true;
+    }
+
+    std::array<uint8_t, NUM_SLICE_EDGES> permutation = UnrankPermutation<NUM_SLICE_EDGES>(order, parity);
+    size_t next_slice = 0;
+    size_t next_other = 0;
+    for(size_t slot=0; slot<NUM_EDGES3; ++slot) {
+        if(is_slice_slot[slot]) {
+            cubies.edge_permutation[slot] = slice_edges[permutation[next_slice++]];
+        } else {
+            while(IsSliceEdge3(next_other))
+                ++next_other;
+            cubies.edge_permutation[slot] = next_other++;
+        }
+    }
+}
+
+const char* GetCoordinateName(Coordinate3 coordinate) {
+    switch(coordinate) {
+    case CORNER_TWIST_COORD:       return "corner_twist";
+    case EDGE_FLIP_COORD:          return "edge_flip";
+    case CORNER_PERMUTATION_COORD: return "corner_permutation";
+    case SLICE_COORD:              return "slice";
+    case SLICE_PERMUTATION_COORD:  return "slice_permutation";
+    default:                       return "invalid";
+    }
+}
+
+uint32_t GetCoordinate3(const CubieState3 &cubies, Coordinate3 coordinate) {
+    uint32_t value = 0;
+    uint32_t combination;
+    uint32_t order;
+    int parity;
+
+    switch(coordinate) {
+    case CORNER_TWIST_COORD:
+        for(size_t i=0; i+1<NUM_CORNERS3; ++i)
+            value = value*3 + cubies.corner_twists[i];
+        break;
+    case EDGE_FLIP_COORD:
+        for(size_t i=0; i+1<NUM_EDGES3; ++i)
+            value = value*2 + cubies.edge_flips[i];
+        break;
+    case CORNER_PERMUTATION_COORD:
+        value = RankPermutation(cubies.corner_permutation, parity);
+        break;
+    case SLICE_COORD:
+        GetSliceRanks(cubies, value, order);
+        break;
+    case SLICE_PERMUTATION_COORD:
+        GetSliceRanks(cubies, combination, order);
+        value = combination*24 + order;
+        break;
+    default:
+        assert(false);
+    }
+    return value;
+}
+
+void SetCoordinate3(Coordinate3 coordinate, uint32_t value, CubieState3 &cubies) {
+    int sum = 0;
+    int parity;
+
+    assert(value < COORDINATE_SIZES[coordinate]);
+    switch(coordinate) {
+    case CORNER_TWIST_COORD:
+        // Orientation of the last piece is implied by the other ones
+        for(size_t i=NUM_CORNERS3-1; i-- > 0;) {
+            cubies.corner_twists[i] = value % 3;
+            value /= 3;
+            sum += cubies.corner_twists[i];
+        }
+        cubies.corner_twists[NUM_CORNERS3-1] = (3 - sum%3) % 3;
+        break;
+    case EDGE_FLIP_COORD:
+        for(size_t i=NUM_EDGES3-1; i-- > 0;) {
+            cubies.edge_flips[i] = value % 2;
+            value /= 2;
+            sum += cubies.edge_flips[i];
+        }
+        cubies.edge_flips[NUM_EDGES3-1] = sum % 2;
+        break;
+    case CORNER_PERMUTATION_COORD:
+        cubies.corner_permutation = UnrankPermutation<NUM_CORNERS3>(value, parity);
+        break;
+    case SLICE_COORD:
+        SetSliceRanks(value, 0, cubies);
+        break;
+    case SLICE_PERMUTATION_COORD:
+        SetSliceRanks(value / 24, value % 24, cubies);
+        break;
+    default:
+        assert(false);
+    }
+}
+
+void MultiplyCubies3(const CubieState3 &first, const CubieState3 &second, CubieState3 &result) {
+    // Slot i receives the piece of slot 'source' of the first state, turned by the second state
+    for(size_t i=0; i<NUM_CORNERS3; ++i) {
+        uint8_t source = second.corner_permutation[i];
+        result.corner_permutation[i] = first.corner_permutation[source];
+        result.corner_twists[i] = (first.corner_twists[source] + second.corner_twists[i]) % 3;
+    }
+    for(size_t i=0; i<NUM_EDGES3; ++i) {
+        uint8_t source = second.edge_permutation[i];
+        result.edge_permutation[i] = first.edge_permutation[source];
+        result.edge_flips[i] = first.edge_flips[source] ^ second.edge_flips[i];
+    }
+}
+
+
+
+CoordinateTables::CoordinateTables(ThreadPool &pool) {
+    const std::vector<CubieState3> moves = GetMoveCubies();
+    std::vector<std::future<void>> blocks;
+
+    for(int c=0; c<NUM_COORDINATES; ++c)
+        tables[c].resize(COORDINATE_SIZES[c] * NUM_COORDINATE_MOVES);
+    for(int c=0; c<NUM_COORDINATES; ++c) {
+        for(uint32_t start=0; start<COORDINATE_SIZES[c]; start+=COORDINATE_TABLE_BLOCK) {
+            blocks.push_back(pool.Submit([this, &moves, c, start]() {
+                Coordinate3 coordinate = (Coordinate3)c;
+                uint32_t end = std::min<uint32_t>(start + COORDINATE_TABLE_BLOCK, COORDINATE_SIZES[c]);
+                CubieState3 cubies = GetSolvedCubies3();
+                CubieState3 moved;
+                for(uint32_t value=start; value<end; ++value) {
+                    SetCoordinate3(coordinate, value, cubies);
+                    for(size_t move=0; move<NUM_COORDINATE_MOVES; ++move) {
+                        MultiplyCubies3(cubies, moves[move], moved);
+                        tables[c][value*NUM_COORDINATE_MOVES + move] = GetCoordinate3(moved, coordinate);
+                    }
+                }
+            }));
+        }
+    }
+    for(size_t i=0; i<blocks.size(); ++i)
+        blocks[i].get();
+}
+
+CoordinateTables::CoordinateTables(const std::string &filename) {
+    CoordinateFileHeader header;
+    FILE *file = fopen(filename.c_str(), "rb");
+    if(!file)
+        throw std::runtime_error("Error opening " + filename);
+
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                 memcmp(header.magic, COORDINATE_FILE_MAGIC, sizeof(header.magic)) == 0 &&
+                 header.version == COORDINATE_FILE_VERSION && header.num_coordinates == NUM_COORDINATES &&
+                 header.num_moves == NUM_COORDINATE_MOVES &&
+                 memcmp(header.sizes, COORDINATE_SIZES, sizeof(header.sizes)) == 0;
+    // The fingerprint is only read from a complete header, and tables of other moves are not read
+    if(valid && header.fingerprint != GetFingerprint()) {
+        fclose(file);
+        throw std::runtime_error(filename + " was built from other moves");
+    }
+    for(int c=0; c<NUM_COORDINATES && valid; ++c) {
+        tables[c].resize(COORDINATE_SIZES[c] * NUM_COORDINATE_MOVES);
+        valid = fread(tables[c].data(), sizeof(uint16_t), tables[c].size(), file) == tables[c].size();
+        // Values are used as indices of the next lookup, so they are validated once here
+        for(size_t i=0; i<tables[c].size() && valid; ++i)
+            valid = tables[c][i] < COORDINATE_SIZES[c];
+    }
+    valid = valid && fgetc(file) == EOF;
+    fclose(file);
+    if(!valid)
+        throw std::runtime_error(filename + " is not a valid file of coordinate tables");
+}
+
+void CoordinateTables::Save(const std::string &filename) const {
+    CoordinateFileHeader header;
+    // Written to a temporary file first, so readers never see a partial file
+    std::string temporary = filename + ".tmp";
+    bool failed = false;
+    FILE *file = fopen(temporary.c_str(), "wb");
+    if(!file)
+        throw std::runtime_error("Error opening " + temporary);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, COORDINATE_FILE_MAGIC, sizeof(header.magic));
+    header.version = COORDINATE_FILE_VERSION;
+    header.num_coordinates = NUM_COORDINATES;
+    header.num_moves = NUM_COORDINATE_MOVES;
+    memcpy(header.sizes, COORDINATE_SIZES, sizeof(header.sizes));
+    header.fingerprint = GetFingerprint();
+    failed |= fwrite(&header, sizeof(header), 1, file) != 1;
+    for(int c=0; c<NUM_COORDINATES && !failed; ++c)
+        failed |= fwrite(tables[c].data(), sizeof(uint16_t), tables[c].size(), file) != tables[c].size();
+    failed |= fclose(file) != 0;
+    failed = failed || rename(temporary.c_str(), filename.c_str()) != 0;
+    if(failed) {
+        remove(temporary.c_str());
+        throw std::runtime_error("Error writing " + filename);
+    }
+}
+
+std::vector<CubieState3> CoordinateTables::GetMoveCubies() {
+    const MoveGenerator<3> generator(FACE_TURN_METRIC);
+    std::vector<CubieState3> moves(NUM_COORDINATE_MOVES);
+    FaceElement facelets[NUM_FACELETS3];
+
+    assert(generator.GetNumMoves() == NUM_COORDINATE_MOVES);
+    for(size_t move=0; move<NUM_COORDINATE_MOVES; ++move) {
+        RubikCube<int, 3> cube;
+        unsigned orientation;
+        size_t i = 0;
+        generator.ApplyMove(move, cube);
+        for(int face=0; face<INVALID; ++face)
+            for(size_t row=0; row<3; ++row)
+                for(size_t col=0; col<3; ++col)
+                    facelets[i++] = cube.GetFaceElement((FaceElement)face, row, col);
+        // Face turns don't move the centers
+        bool valid = FaceletsToCubies3(facelets, moves[move], orientation);
+        assert(valid && orientation == 0);
+        (void)valid;
+    }
+    return moves;
+}
+
+uint64_t CoordinateTables::GetFingerprint() {
+    std::vector<CubieState3> moves = GetMoveCubies();
+    uint64_t fingerprint = ZOBRIST_SEED;
+    for(size_t move=0; move<moves.size(); ++move) {
+        const CubieState3 &cubies = moves[move];
+        for(size_t i=0; i<NUM_CORNERS3; ++i)
+            fingerprint = ZobristMix(fingerprint ^ (cubies.corner_permutation[i] << 2 | cubies.corner_twists[i]));
+        for(size_t i=0; i<NUM_EDGES3; ++i)
+            fingerprint = ZobristMix(fingerprint ^ (cubies.edge_permutation[i] << 1 | cubies.edge_flips[i]));
+    }
+    return fingerprint;
+}
+
+
+
+CoordinateTables LoadCoordinateTables(const std::string &filename, ThreadPool &pool) {
+    try {
+        return CoordinateTables(filename);
+    } catch(const std::runtime_error &e) {
+    }
+    CoordinateTables tables(pool);
+    tables.Save(filename);
+    return tables;
+}
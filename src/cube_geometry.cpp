@@ -0,0 +1,85 @@
+#include <cube_geometry.h>
+#include <cassert>
+
+irr::core::vector3df GetRotationAxis(FaceElement face) {
+    assert(face >= 0 && face < INVALID);
+    irr::core::vector3df rotation_axis;
+    switch(face) {
+    case FRONT:  rotation_axis = irr::core::vector3df { 0.0f,  0.0f,  1.0f}; break;
+    case BACK:   rotation_axis = irr::core::vector3df { 0.0f,  0.0f, -1.0f}; break;
+    case LEFT:   rotation_axis = irr::core::vector3df {-1.0f,  0.0f,  0.0f}; break;
+    case RIGHT:  rotation_axis = irr::core::vector3df { 1.0f,  0.0f,  0.0f}; break;
+    case TOP:    rotation_axis = irr::core::vector3df { 0.0f,  1.0f,  0.0f}; break;
+    case BOTTOM: rotation_axis = irr::core::vector3df { 0.0f, -1.0f,  0.0f}; break;
+    default:     break;
+    }
+    return rotation_axis;
+}
+
+irr::video::SColor GetFaceColor(FaceElement face) {
+    assert(face >= 0 && face < INVALID);
+    // Colors. Format ARGB. Range [0, 255]
+    static const irr::video::SColor faces_colors[] =
+        {
+         irr::video::SColor {255,   0, 255,   0}, // Front
+         irr::video::SColor {255,   0,   0, 255}, // Back
+         irr::video::SColor {255, 255, 255, 255}, // Left
+         irr::video::SColor {255, 255, 255,   0}, // Right
+         irr::video::SColor {255, 255,   0,   0}, // Top
+         irr::video::SColor {255, 255, 128,   0}  // Bottom
+        };
+    return faces_colors[(int)face];
+}
+
+irr::video::SMaterial CreateFaceMaterial(FaceElement face) {
+    irr::video::SColor color = GetFaceColor(face);
+    irr::video::SMaterial material;
+    
+    // Set material properties
+    //material.setFlag(EMF_GOURAUD_SHADING, false);
+    material.setFlag(irr::video::EMF_LIGHTING, true);
+    material.setFlag(irr::video::EMF_FRONT_FACE_CULLING, false);
+    material.setFlag(irr::video::EMF_BACK_FACE_CULLING, false);
+    material.setFlag(irr::video::EMF_ANISOTROPIC_FILTER, false);
+    material.setFlag(irr::video::EMF_ANTI_ALIASING, false);
+    material.setFlag(irr::video::EMF_COLOR_MATERIAL, true);
+    material.setFlag(irr::video::EMF_USE_MIP_MAPS, false);
+    
+    // Set material colors
+    material.AmbientColor = color;
+    material.DiffuseColor = color;
+    material.SpecularColor = color;
+    material.EmissiveColor = color;
+    material.Shininess = 20.0f;
+    
+    return material;
+}
+
+irr::core::vector3df GetFaceRotation(FaceElement face) {
+    assert(face >= 0 && face < INVALID);
+    // Yaw, pitch, roll
+    static const irr::core::vector3df rotation_table[] =
+        {
+         irr::core::vector3df { 90.0f, 0.0f,   0.0f}, // Front
+         irr::core::vector3df {270.0f, 0.0f,   0.0f}, // Back
+         irr::core::vector3df {  0.0f, 0.0f,  90.0f}, // Left
+         irr::core::vector3df {  0.0f, 0.0f, 270.0f}, // Right
+         irr::core::vector3df {  0.0f, 0.0f,   0.0f}, // Top
+         irr::core::vector3df {  0.0f, 0.0f, 180.0f}  // Bottom
+        };
+    return rotation_table[(int)face];
+}
+
+irr::core::vector3df GetFacePoint(FaceElement face, float row_offset, float col_offset, float half_length) {
+    float x, y, z;
+    switch(face) {
+    case FRONT:  x = -col_offset;   y = -row_offset;   z =  half_length; break;
+    case BACK:   x =  col_offset;   y = -row_offset;   z = -half_length; break;
+    case LEFT:   x =  half_length;  y = -row_offset;   z =  col_offset;  break;
+    case RIGHT:  x = -half_length;  y = -row_offset;   z = -col_offset;  break;
+    case TOP:    x = -col_offset;   y =  half_length;  z =  row_offset;  break;
+    case BOTTOM: x = -col_offset;   y = -half_length;  z = -row_offset;  break;
+    default:     assert(false); x = y = z = 0.0f;
+    }
+    return irr::core::vector3df {x, y, z};
+}
@@ -0,0 +1,34 @@
+#include <cube_scene.h>
+#include <iostream>
+#include <random>
+#include <cstdlib>
+#include <string>
+
+/*    Number of cubes that receive a random move each frame    */
+const size_t MOVES_PER_FRAME = 10;
+
+int main(int argc, char *argv[]) {
+    size_t num_cubes = 100;
+    std::mt19937 generator(std::random_device{}());
+
+    if(argc > 2 || (argc == 2 && (num_cubes = std::strtoul(argv[1], nullptr, 10)) == 0)) {
+        std::cerr << "Usage: " << argv[0] << " [number of cubes]" << std::endl;
+        return 1;
+    }
+
+    RubikCubeScene<3> scene(L"Rubik Cube Dashboard", 1024, 768, num_cubes, 1.0f);
+    std::uniform_int_distribution<size_t> cube_distribution(0, num_cubes-1);
+    std::uniform_int_distribution<int> face_distribution(0, 5);
+    std::uniform_int_distribution<int> clockwise_distribution(0, 1);
+
+    // Cubes are scrambled continuously, as if they were showing solver runs
+    while(scene.ShouldContinue()) {
+        for(size_t i=0; i<MOVES_PER_FRAME; ++i) {
+            Move move = {(FaceElement)face_distribution(generator), (Clockwise)clockwise_distribution(generator), 0};
+            scene.ApplyMove(cube_distribution(generator), move);
+        }
+        scene.UpdateFrame();
+    }
+
+    return 0;
+}
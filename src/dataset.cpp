@@ -0,0 +1,13 @@
+#include <dataset.h>
+#include <cstdio>
+
+size_t GetTensorSize(TensorEncoding encoding, size_t cube_size) {
+    size_t num_facelets = 6*cube_size*cube_size;
+    return encoding == ONE_HOT_TENSOR ? 6*num_facelets : num_facelets;
+}
+
+std::string GetShardFilename(const std::string &prefix, size_t shard) {
+    char index[32];
+    snprintf(index, sizeof(index), "%05zu", shard);
+    return prefix + "-" + index;
+}
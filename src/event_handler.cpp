@@ -1,27 +1,64 @@
 #include <event_handler.h>
+#include <tools.h>
+
+void RubikCubeEventHandler::PushEvent(InputEvent::Type type) {
+    if(_num_events == EVENT_BUFFER_SIZE) {
+        InputEvent &last = _events[(_first_event + _num_events - 1) % EVENT_BUFFER_SIZE];
+        if(type == InputEvent::MOUSE_MOVED && last.type == InputEvent::MOUSE_MOVED) {
+            // Only the final position of a drag is kept
+            last.cursor_position = _cursor_position;
+            last.timestamp = get_monotonic_time();
+            return;
+        }
+        _first_event = (_first_event + 1) % EVENT_BUFFER_SIZE;
+        --_num_events;
+    }
+    
+    InputEvent &event = _events[(_first_event + _num_events) % EVENT_BUFFER_SIZE];
+    event.type = type;
+    event.cursor_position = _cursor_position;
+    event.timestamp = get_monotonic_time();
+    ++_num_events;
+}
+
+bool RubikCubeEventHandler::PopEvent(InputEvent &event) {
+    if(_num_events == 0)
+        return false;
+    event = _events[_first_event];
+    _first_event = (_first_event + 1) % EVENT_BUFFER_SIZE;
+    --_num_events;
+    return true;
+}
 
 bool RubikCubeEventHandler::OnEvent(const irr::SEvent &e) {
     if(e.EventType == irr::EET_MOUSE_INPUT_EVENT) {
+        // Every mouse event carries the cursor position, so clicks are located exactly
+        _cursor_position.X = e.MouseInput.X;
+        _cursor_position.Y = e.MouseInput.Y;
+        
         switch(e.MouseInput.Event) {
         case irr::EMIE_LMOUSE_PRESSED_DOWN:
             _left_mouse_pressed = true;
+            PushEvent(InputEvent::LEFT_PRESSED);
             break;
                 
         case irr::EMIE_LMOUSE_LEFT_UP:
             _left_mouse_pressed = false;
+            PushEvent(InputEvent::LEFT_RELEASED);
             break;
                 
         case irr::EMIE_RMOUSE_PRESSED_DOWN:
             _right_mouse_pressed = true;
+            PushEvent(InputEvent::RIGHT_PRESSED);
             break;
                 
         case irr::EMIE_RMOUSE_LEFT_UP:
             _right_mouse_pressed = false;
+            PushEvent(InputEvent::RIGHT_RELEASED);
             break;
                 
         case irr::EMIE_MOUSE_MOVED:
-            _cursor_position.X = e.MouseInput.X;
-            _cursor_position.Y = e.MouseInput.Y;
+            PushEvent(InputEvent::MOUSE_MOVED);
             break;
                 
         default:
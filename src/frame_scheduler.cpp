@@ -0,0 +1,44 @@
+#include <frame_scheduler.h>
+#include <tools.h>
+#include <cassert>
+
+FrameScheduler::FrameScheduler(double step, double max_frame_duration)
+    : step(step),
+      max_frame_duration(max_frame_duration),
+      accumulator(0.0),
+      last_time(get_monotonic_time()),
+      frame_duration(0.0)
+{
+    assert(step > 0.0);
+    assert(max_frame_duration > 0.0);
+}
+
+void FrameScheduler::BeginFrame() {
+    double current_time = get_monotonic_time();
+    frame_duration = current_time - last_time;
+    last_time = current_time;
+
+    if(frame_duration > max_frame_duration)
+        accumulator += max_frame_duration;
+    else
+        accumulator += frame_duration;
+}
+
+bool FrameScheduler::NextStep() {
+    bool should_step = accumulator >= step;
+    if(should_step)
+        accumulator -= step;
+    return should_step;
+}
+
+double FrameScheduler::GetStep() const {
+    return step;
+}
+
+double FrameScheduler::GetInterpolation() const {
+    return accumulator / step;
+}
+
+double FrameScheduler::GetFrameDuration() const {
+    return frame_duration;
+}
@@ -0,0 +1,91 @@
+#include <frame_stats.h>
+#include <tools.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include <sstream>
+#include <iomanip>
+
+FrameStats::FrameStats()
+    : num_frames(0), next_frame(0), draw_calls(0), primitives(0)
+{
+    frame_times.fill(0.0);
+    for(size_t i=0; i<NUM_SECTIONS; ++i)
+        section_times[i].fill(0.0);
+    current_sections.fill(0.0);
+}
+
+void FrameStats::AddSectionTime(FrameSection section, double duration) {
+    assert(section >= 0 && section < NUM_SECTIONS);
+    current_sections[section] += duration;
+}
+
+double FrameStats::GetSectionTime(FrameSection section) const {
+    assert(section >= 0 && section < NUM_SECTIONS);
+    return current_sections[section];
+}
+
+void FrameStats::EndFrame(double duration, size_t draw_calls, size_t primitives) {
+    frame_times[next_frame] = duration;
+    for(size_t i=0; i<NUM_SECTIONS; ++i) {
+        section_times[i][next_frame] = current_sections[i];
+        current_sections[i] = 0.0;
+    }
+    next_frame = (next_frame+1) % HISTORY_SIZE;
+    num_frames = std::min(num_frames+1, HISTORY_SIZE);
+    this->draw_calls = draw_calls;
+    this->primitives = primitives;
+}
+
+double FrameStats::GetFPS() const {
+    double total = 0.0;
+    for(size_t i=0; i<num_frames; ++i)
+        total += frame_times[i];
+    return total > 0.0 ? num_frames / total : 0.0;
+}
+
+double FrameStats::GetFrameTimePercentile(double percentile) const {
+    assert(percentile >= 0.0 && percentile <= 100.0);
+    if(num_frames == 0)
+        return 0.0;
+    std::vector<double> sorted(frame_times.begin(), frame_times.begin()+num_frames);
+    size_t pos = (size_t)std::ceil(percentile / 100.0 * num_frames);
+    if(pos > 0)
+        --pos;
+    std::nth_element(sorted.begin(), sorted.begin()+pos, sorted.end());
+    return sorted[pos];
+}
+
+double FrameStats::GetAverageSectionTime(FrameSection section) const {
+    assert(section >= 0 && section < NUM_SECTIONS);
+    double total = 0.0;
+    for(size_t i=0; i<num_frames; ++i)
+        total += section_times[section][i];
+    return num_frames > 0 ? total / num_frames : 0.0;
+}
+
+std::wstring FrameStats::ToString() const {
+    std::wostringstream os;
+    os << std::fixed << std::setprecision(2);
+    os << L"FPS: " << GetFPS() << L'\n';
+    os << L"Frame p50: " << GetFrameTimePercentile(50.0)*1000.0 << L" ms, p99: "
+       << GetFrameTimePercentile(99.0)*1000.0 << L" ms\n";
+    os << L"Draw calls: " << draw_calls << L", primitives: " << primitives << L'\n';
+    os << L"Update: " << GetAverageSectionTime(SECTION_UPDATE)*1000.0 << L" ms, "
+       << L"picking: " << GetAverageSectionTime(SECTION_PICKING)*1000.0 << L" ms, "
+       << L"render: " << GetAverageSectionTime(SECTION_RENDER)*1000.0 << L" ms";
+    return os.str();
+}
+
+
+
+SectionTimer::SectionTimer(FrameStats &stats, FrameSection section)
+    : stats(stats), section(section), start(get_monotonic_time())
+{
+
+}
+
+SectionTimer::~SectionTimer() {
+    stats.AddSectionTime(section, get_monotonic_time() - start);
+}
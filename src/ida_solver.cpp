@@ -0,0 +1,139 @@
+#include <ida_solver.h>
+#include <tools.h>
+#include <algorithm>
+
+IDAStarSolver3::IDAStarSolver3(const CoordinateTables &coordinates, const PruningTables &pruning)
+    : coordinates(coordinates), pruning(pruning), generator(QUARTER_TURN_METRIC),
+      coordinate_moves(GetQuarterTurnCoordinateMoves()), move_cubies(CoordinateTables::GetMoveCubies()) {
+    CubieState3 cubies = GetSolvedCubies3();
+    for(int c=0; c<NUM_COORDINATES; ++c)
+        solved.coordinates[c] = GetCoordinate3(cubies, (Coordinate3)c);
+}
+
+uint8_t IDAStarSolver3::GetBound(const Node &node) const {
+    return *std::max_element(node.distances, node.distances + NUM_PRUNING_TABLES);
+}
+
+void IDAStarSolver3::SetDistances(const Node &parent, Node &child) const {
+    for(size_t table=0; table<NUM_PRUNING_TABLES; ++table) {
+        uint32_t index = PruningTables::GetIndex(table, child.coordinates[PRUNING_PAIRS[table].first],
+                                                 child.coordinates[PRUNING_PAIRS[table].second]);
+        child.distances[table] = pruning.GetNeighbourDistance(pruning.GetValue(table, index), parent.distances[table]);
+    }
+}
+
+bool IDAStarSolver3::IsSolving(const CubieState3 &cubies, const std::vector<uint16_t> &path) const {
+    CubieState3 state = cubies;
+    CubieState3 moved;
+    CubieState3 solved_cubies = GetSolvedCubies3();
+    for(size_t i=0; i<path.size(); ++i) {
+        MultiplyCubies3(state, move_cubies[coordinate_moves[path[i]]], moved);
+        state = moved;
+    }
+    return state.corner_permutation == solved_cubies.corner_permutation &&
+           state.corner_twists == solved_cubies.corner_twists &&
+           state.edge_permutation == solved_cubies.edge_permutation &&
+           state.edge_flips == solved_cubies.edge_flips;
+}
+
+bool IDAStarSolver3::Search(const CubieState3 &cubies, const Node &node, size_t state, size_t remaining,
+                            std::vector<uint16_t> &path, HeuristicEvaluation evaluation, uint64_t &nodes) const {
+    if(std::equal(node.coordinates, node.coordinates + NUM_COORDINATES, solved.coordinates) &&
+       IsSolving(cubies, path))
+        return true;
+    if(remaining == 0)
+        return false;
+
+    const std::vector<MoveGenerator<3>::Successor> &successors = generator.GetSuccessors(state);
+    const size_t num_children = successors.size();
+    Node child;
+
+    if(evaluation == SINGLE_EVALUATION) {
+        for(size_t k=0; k<num_children; ++k) {
+            size_t move = coordinate_moves[successors[k].move];
+            for(int c=0; c<NUM_COORDINATES; ++c)
+                child.coordinates[c] = coordinates.Move((Coordinate3)c, node.coordinates[c], move);
+            SetDistances(node, child);
+            ++nodes;
+            if(GetBound(child) >= remaining)
+                continue;
+            path.push_back(successors[k].move);
+            if(Search(cubies, child, successors[k].state, remaining-1, path, evaluation, nodes))
+                return true;
+            path.pop_back();
+        }
+        return false;
+    }
+
+    // Rows of the move tables have the values of every coordinate move, so the values, indices and bounds of
+    // all the moves are computed together, a coordinate or table at a time, in loops over IDA_BATCH moves which
+    // GCC vectorizes. Pruning table entries are only prefetched and read for the moves of the children
+    uint32_t moves[NUM_COORDINATE_MOVES];
+    uint16_t values[NUM_COORDINATES][IDA_BATCH];
+    uint32_t indices[NUM_PRUNING_TABLES][IDA_BATCH];
+    uint8_t distances[NUM_PRUNING_TABLES][IDA_BATCH] = {};
+    uint8_t bounds[IDA_BATCH] = {};
+    for(size_t k=0; k<num_children; ++k)
+        moves[k] = coordinate_moves[successors[k].move];
+    for(int c=0; c<NUM_COORDINATES; ++c) {
+        const uint16_t *row = coordinates.GetTable((Coordinate3)c) + node.coordinates[c] * NUM_COORDINATE_MOVES;
+        std::copy(row, row + NUM_COORDINATE_MOVES, values[c]);
+        std::fill(values[c] + NUM_COORDINATE_MOVES, values[c] + IDA_BATCH, 0);
+    }
+    for(size_t table=0; table<NUM_PRUNING_TABLES; ++table) {
+        const uint16_t *first = values[PRUNING_PAIRS[table].first];
+        const uint16_t *second = values[PRUNING_PAIRS[table].second];
+        const uint16_t second_size = COORDINATE_SIZES[PRUNING_PAIRS[table].second];
+        for(size_t m=0; m<IDA_BATCH; ++m)
+            indices[table][m] = (uint32_t)first[m] * second_size + second[m];
+        for(size_t k=0; k<num_children; ++k)
+            __builtin_prefetch(pruning.GetAddress(table, indices[table][moves[k]]));
+    }
+    for(size_t table=0; table<NUM_PRUNING_TABLES; ++table) {
+        for(size_t k=0; k<num_children; ++k)
+            distances[table][moves[k]] = pruning.GetValue(table, indices[table][moves[k]]);
+        pruning.GetNeighbourDistances<IDA_BATCH>(node.distances[table], distances[table]);
+        for(size_t m=0; m<IDA_BATCH; ++m)
+            bounds[m] = std::max(bounds[m], distances[table][m]);
+    }
+
+    // Children are counted in order until a solution is found, as in single evaluation, so both count the same nodes
+    for(size_t k=0; k<num_children; ++k) {
+        ++nodes;
+        if(bounds[moves[k]] >= remaining)
+            continue;
+        for(int c=0; c<NUM_COORDINATES; ++c)
+            child.coordinates[c] = values[c][moves[k]];
+        for(size_t table=0; table<NUM_PRUNING_TABLES; ++table)
+            child.distances[table] = distances[table][moves[k]];
+        path.push_back(successors[k].move);
+        if(Search(cubies, child, successors[k].state, remaining-1, path, evaluation, nodes))
+            return true;
+        path.pop_back();
+    }
+    return false;
+}
+
+bool IDAStarSolver3::SolveCubies(const CubieState3 &cubies, size_t max_depth, std::vector<uint16_t> &solution,
+                                 HeuristicEvaluation evaluation, IDAStarStats &stats) const {
+    double start = get_monotonic_time();
+    bool found = false;
+    Node root;
+
+    for(int c=0; c<NUM_COORDINATES; ++c)
+        root.coordinates[c] = GetCoordinate3(cubies, (Coordinate3)c);
+    for(size_t table=0; table<NUM_PRUNING_TABLES; ++table) {
+        uint32_t index = PruningTables::GetIndex(table, root.coordinates[PRUNING_PAIRS[table].first],
+                                                 root.coordinates[PRUNING_PAIRS[table].second]);
+        root.distances[table] = pruning.GetDistance(table, index, coordinates);
+    }
+    stats.nodes = 1;
+    // Bounds below the one of the root have no solution
+    for(size_t depth=GetBound(root); depth<=max_depth && !found; ++depth) {
+        solution.clear();
+        found = Search(cubies, root, MoveGenerator<3>::START, depth, solution, evaluation, stats.nodes);
+        ++stats.iterations;
+    }
+    stats.latency = get_monotonic_time() - start;
+    return found;
+}
@@ -52,6 +52,20 @@ void RotateNodes(const std::vector<irr::scene::ISceneNode*> &nodes, const irr::c
         RotateNode(nodes[i], rotation_axis, center, angle);
 }
 
+bool IsBoxInFrustum(const irr::core::aabbox3df &box, const irr::scene::SViewFrustum &frustum) {
+    irr::core::vector3df edges[8];
+    box.getEdges(edges);
+
+    for(int i=0; i<irr::scene::SViewFrustum::VF_PLANE_COUNT; ++i) {
+        bool outside = true;
+        for(int j=0; j<8 && outside; ++j)
+            outside = frustum.planes[i].classifyPointRelation(edges[j]) == irr::core::ISREL3D_FRONT;
+        if(outside)
+            return false;
+    }
+    return true;
+}
+
 std::ostream& operator<<(std::ostream &os, const irr::video::SColor &color) {
     os << '{' << color.getRed() << ", " << color.getGreen() << ", " << color.getBlue() << ", " << color.getAlpha() << '}';
     return os;
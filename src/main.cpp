@@ -1,5 +1,6 @@
 #include <graphical_cube.h>
 #include <iostream>
+#include <cstdlib>
 
 int main() {
     auto cube = GraphicalRubikCube<2>(L"Rubik Cube", 512, 512, 1.0);
@@ -13,5 +14,10 @@ int main() {
         cube.UpdateFrame();
     }
     
+    // Moves of the session can be replayed later with render --session
+    const char *session = std::getenv("RUBIK_SESSION");
+    if(session != nullptr)
+        cube.GetHistory().Save(session);
+    
     return 0;
 }
@@ -0,0 +1,85 @@
+#include <move_history.h>
+#include <cstdio>
+#include <cstring>
+
+/*    Session recording header. Moves and times follow it    */
+struct SessionHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t cube_size;
+    uint64_t num_moves;
+};
+
+static const char SESSION_MAGIC[8] = {'R', 'U', 'B', 'I', 'K', 'S', 'E', 'S'};
+static const uint32_t SESSION_VERSION = 1;
+
+uint8_t PackMove(const Move &move, size_t cube_size) {
+    assert(cube_size <= MAX_PACKED_MOVE_CUBE_SIZE);
+    assert(move.face >= 0 && move.face < INVALID && move.depth < cube_size);
+    return (move.face*cube_size + move.depth)*2 + move.clockwise;
+}
+
+Move UnpackMove(uint8_t packed, size_t cube_size) {
+    Move move;
+    if(packed >= INVALID*cube_size*2)
+        throw std::invalid_argument("Packed move out of range");
+    move.clockwise = (Clockwise)(packed % 2);
+    move.depth = (packed / 2) % cube_size;
+    move.face = (FaceElement)(packed / 2 / cube_size);
+    return move;
+}
+
+void WriteSessionFile(const std::string &filename, size_t cube_size, const std::vector<uint8_t> &moves,
+                      const std::vector<uint32_t> &times) {
+    SessionHeader header;
+    FILE *file;
+    bool failed = false;
+
+    assert(moves.size() == times.size());
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SESSION_MAGIC, sizeof(header.magic));
+    header.version = SESSION_VERSION;
+    header.cube_size = cube_size;
+    header.num_moves = moves.size();
+
+    file = fopen(filename.c_str(), "wb");
+    if(!file)
+        throw std::runtime_error("Error opening " + filename);
+    failed |= fwrite(&header, sizeof(header), 1, file) != 1;
+    failed |= !moves.empty() && fwrite(moves.data(), 1, moves.size(), file) != moves.size();
+    failed |= !times.empty() && fwrite(times.data(), sizeof(uint32_t), times.size(), file) != times.size();
+    failed |= fclose(file) != 0;
+    if(failed)
+        throw std::runtime_error("Error writing " + filename);
+}
+
+void ReadSessionFile(const std::string &filename, size_t &cube_size, std::vector<uint8_t> &moves,
+                     std::vector<uint32_t> &times) {
+    SessionHeader header;
+    FILE *file;
+    bool valid;
+
+    file = fopen(filename.c_str(), "rb");
+    if(!file)
+        throw std::runtime_error("Error opening " + filename);
+    valid = fread(&header, sizeof(header), 1, file) == 1 &&
+            memcmp(header.magic, SESSION_MAGIC, sizeof(header.magic)) == 0 &&
+            header.version == SESSION_VERSION && header.cube_size > 0 &&
+            header.cube_size <= MAX_PACKED_MOVE_CUBE_SIZE;
+    if(valid) {
+        // Sizes are read from the file, so they are checked by the reads and not trusted for allocation
+        moves.clear();
+        times.clear();
+        for(uint64_t i=0; i<header.num_moves && valid; ++i) {
+            int c = fgetc(file);
+            valid = c != EOF;
+            moves.push_back(c);
+        }
+        times.resize(moves.size());
+        valid = valid && (times.empty() || fread(times.data(), sizeof(uint32_t), times.size(), file) == times.size());
+    }
+    fclose(file);
+    if(!valid)
+        throw std::runtime_error(filename + " is not a valid session recording");
+    cube_size = header.cube_size;
+}
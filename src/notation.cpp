@@ -0,0 +1,120 @@
+#include <notation.h>
+#include <stdexcept>
+#include <cctype>
+
+/**
+  * @brief Converts a face letter to its face
+  * @return Face of the letter, or INVALID if it isn't a face letter
+  */
+static FaceElement LetterToFace(char letter) {
+    FaceElement face;
+    switch(letter) {
+    case 'F': face = FRONT;   break;
+    case 'B': face = BACK;    break;
+    case 'L': face = LEFT;    break;
+    case 'R': face = RIGHT;   break;
+    case 'U': face = TOP;     break;
+    case 'D': face = BOTTOM;  break;
+    default:  face = INVALID; break;
+    }
+    return face;
+}
+
+std::vector<Move> ParseMoves(const std::string &text, size_t cube_size) {
+    std::vector<Move> moves;
+    ParseMoves(text.data(), text.data() + text.size(), cube_size, moves);
+    return moves;
+}
+
+void ParseMoves(const char *begin, const char *end, size_t cube_size, std::vector<Move> &moves) {
+    const char *token = begin;
+
+    while(true) {
+        // Tokens are separated by whitespace. They are scanned in place, without copies
+        while(token != end && std::isspace((unsigned char)*token))
+            ++token;
+        if(token == end)
+            break;
+        const char *token_end = token;
+        while(token_end != end && !std::isspace((unsigned char)*token_end))
+            ++token_end;
+
+        Move move;
+        const char *pos = token;
+        size_t layer = 0;
+        size_t num_turns = 1;
+
+        // Layer number
+        while(pos != token_end && std::isdigit((unsigned char)*pos)) {
+            layer = layer*10 + (*pos - '0');
+            ++pos;
+        }
+        if(pos == token)
+            layer = 1;
+        if(layer == 0 || layer > cube_size)
+            throw std::invalid_argument("Invalid layer in move '" + std::string(token, token_end) + "'");
+
+        // Face
+        if(pos == token_end || (move.face = LetterToFace(*pos)) == INVALID)
+            throw std::invalid_argument("Invalid face in move '" + std::string(token, token_end) + "'");
+        ++pos;
+
+        // Suffix
+        move.clockwise = CLOCKWISE;
+        move.depth = layer - 1;
+        if(pos != token_end && *pos == '2') {
+            num_turns = 2;
+            ++pos;
+        }
+        if(pos != token_end && *pos == '\'') {
+            move.clockwise = COUNTERCLOCKWISE;
+            ++pos;
+        }
+        if(pos != token_end)
+            throw std::invalid_argument("Invalid suffix in move '" + std::string(token, token_end) + "'");
+
+        for(size_t i=0; i<num_turns; ++i)
+            moves.push_back(move);
+        token = token_end;
+    }
+}
+
+std::string MoveToString(const Move &move) {
+    std::string str;
+    if(move.depth > 0)
+        str += std::to_string(move.depth + 1);
+    str += FaceElementToString(move.face);
+    if(move.clockwise == COUNTERCLOCKWISE)
+        str += '\'';
+    return str;
+}
+
+std::string MovesToString(const std::vector<Move> &moves) {
+    std::string str;
+    size_t i = 0;
+    while(i < moves.size()) {
+        if(!str.empty())
+            str += ' ';
+        if(i+1 < moves.size() && moves[i] == moves[i+1]) {
+            // Half turns are written clockwise
+            Move half = moves[i];
+            half.clockwise = CLOCKWISE;
+            str += MoveToString(half) + '2';
+            i += 2;
+        } else {
+            str += MoveToString(moves[i]);
+            ++i;
+        }
+    }
+    return str;
+}
+
+Move InverseMove(const Move &move) {
+    Move inverse = move;
+    inverse.clockwise = !move.clockwise;
+    return inverse;
+}
+
+bool operator==(const Move &a, const Move &b) {
+    return a.face == b.face && a.clockwise == b.clockwise && a.depth == b.depth;
+}
@@ -0,0 +1,116 @@
+#include <profiler.h>
+#include <vector>
+#include <mutex>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <new>
+#include <tools.h>
+
+/*    Buffers of all threads which have measured some scope    */
+struct ProfileRegistry {
+    std::mutex mutex;
+    std::vector<ProfileBuffer*> buffers;
+    // Reference point to convert ticks to time
+    uint64_t start_ticks = GetProfileTicks();
+    double start_time = get_monotonic_time();
+
+#ifdef RUBIK_PROFILING
+    ~ProfileRegistry() {
+        SaveProfileTrace();
+    }
+#endif
+};
+
+/**
+  * @brief Returns the registry. Built on first use, so it exists before any static object measures a scope
+  */
+static ProfileRegistry& GetRegistry() {
+    static ProfileRegistry registry;
+    return registry;
+}
+
+void ProfileBuffer::AddChunk() {
+    if(num_used_chunks == chunks.size()) {
+        void *chunk = aligned_alloc(CHUNK_BYTES, CHUNK_BYTES);
+        if(!chunk)
+            throw std::bad_alloc();
+        madvise(chunk, CHUNK_BYTES, MADV_HUGEPAGE);
+        memset(chunk, 0, CHUNK_BYTES);
+        chunks.push_back((ProfileEvent*)chunk);
+    }
+    cursor = chunks[num_used_chunks++];
+    chunk_end = cursor + CHUNK_SIZE;
+}
+
+ProfileBuffer* RegisterProfileBuffer() {
+    ProfileRegistry &registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    ProfileBuffer *buffer = new ProfileBuffer();
+    buffer->thread_id = registry.buffers.size();
+    registry.buffers.push_back(buffer);
+    return buffer;
+}
+
+void WriteProfileTrace(const std::string &filename) {
+    ProfileRegistry &registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    FILE *file = fopen(filename.c_str(), "w");
+    bool first = true;
+    int pid = getpid();
+    uint64_t ticks = GetProfileTicks();
+    double elapsed = get_monotonic_time() - registry.start_time;
+    // Microseconds per tick
+    double tick_duration = ticks > registry.start_ticks ? elapsed * 1e6 / (ticks - registry.start_ticks) : 0.0;
+
+    if(!file)
+        throw std::runtime_error("Error opening trace file " + filename);
+
+    // Complete events ("X"), with timestamps in microseconds
+    fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    for(size_t i=0; i<registry.buffers.size(); ++i) {
+        const ProfileBuffer *buffer = registry.buffers[i];
+        for(size_t j=0; j<buffer->GetNumEvents(); ++j) {
+            const ProfileEvent &event = buffer->GetEvent(j);
+            fprintf(file, "%s{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %d, \"tid\": %u}",
+                    first ? "" : ",\n", event.name,
+                    (registry.start_time * 1e6) + ((double)event.start - registry.start_ticks) * tick_duration,
+                    event.duration * tick_duration, pid, buffer->thread_id);
+            first = false;
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    if(fclose(file) != 0)
+        throw std::runtime_error("Error writing trace file " + filename);
+}
+
+void SaveProfileTrace() {
+#ifdef RUBIK_PROFILING
+    const char *path = getenv("RUBIK_TRACE");
+    std::string filename;
+    size_t pos;
+
+    if(!path)
+        return;
+    filename = path;
+    if((pos = filename.find("%p")) != std::string::npos)
+        filename.replace(pos, 2, std::to_string(getpid()));
+
+    try {
+        WriteProfileTrace(filename);
+    } catch(const std::runtime_error &e) {
+        fprintf(stderr, "%s\n", e.what());
+    }
+#endif
+}
+
+void ClearProfile() {
+    ProfileRegistry &registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for(size_t i=0; i<registry.buffers.size(); ++i)
+        registry.buffers[i]->Clear();
+}
@@ -0,0 +1,164 @@
+#include <pruning_tables.h>
+#include <move_generator.h>
+#include <future>
+#include <new>
+#include <cstring>
+#include <sys/mman.h>
+
+/*    Bits per entry of each layout, as log2 of the entries of a byte    */
+static const unsigned LAYOUT_ENTRY_SHIFTS[NUM_PRUNING_LAYOUTS] = {0, 1, 2};
+
+const char* GetPruningLayoutName(PruningLayout layout) {
+    switch(layout) {
+    case BYTE_PRUNING: return "byte";
+    case NIBBLE_PRUNING: return "nibble";
+    case MOD3_PRUNING: return "mod3";
+    default: return "invalid";
+    }
+}
+
+std::vector<size_t> GetQuarterTurnCoordinateMoves() {
+    const MoveGenerator<3> quarter_turns(QUARTER_TURN_METRIC);
+    const MoveGenerator<3> face_turns(FACE_TURN_METRIC);
+    std::vector<size_t> moves;
+
+    for(size_t i=0; i<quarter_turns.GetNumMoves(); ++i) {
+        const Move &move = quarter_turns.GetMove(i).move;
+        for(size_t j=0; j<face_turns.GetNumMoves(); ++j) {
+            const SearchMove &candidate = face_turns.GetMove(j);
+            if(candidate.num_quarter_turns == 1 && candidate.move.face == move.face &&
+               candidate.move.clockwise == move.clockwise && candidate.move.depth == move.depth)
+                moves.push_back(j);
+        }
+    }
+    assert(moves.size() == quarter_turns.GetNumMoves());
+    return moves;
+}
+
+
+
+PruningTables::PruningTables(const CoordinateTables &coordinates, ThreadPool &pool, PruningLayout layout,
+                             bool huge_pages)
+    : layout(layout), entry_shift(LAYOUT_ENTRY_SHIFTS[layout]), bits_shift(3 - entry_shift),
+      entry_mask((1 << entry_shift) - 1), value_mask((1 << (8 >> entry_shift)) - 1) {
+    std::vector<std::future<void>> results;
+
+    for(size_t table=0; table<NUM_PRUNING_TABLES; ++table) {
+        size_t bytes = (GetSize(table) + entry_mask) >> entry_shift;
+        // Whole huge pages, so the end of a table doesn't share one with other data
+        mapping_sizes[table] = (bytes + PRUNING_HUGE_PAGE_SIZE - 1) / PRUNING_HUGE_PAGE_SIZE * PRUNING_HUGE_PAGE_SIZE;
+        void *address = mmap(nullptr, mapping_sizes[table], PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(address == MAP_FAILED) {
+            for(size_t i=0; i<table; ++i)
+                munmap(tables[i], mapping_sizes[i]);
+            throw std::bad_alloc();
+        }
+        tables[table] = (uint8_t*)address;
+        // Advice only: tables work the same if the system has no transparent huge pages
+        madvise(address, mapping_sizes[table], huge_pages ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+    }
+
+    for(size_t table=0; table<NUM_PRUNING_TABLES; ++table) {
+        results.push_back(pool.Submit([this, &coordinates, table]() {
+            std::vector<uint8_t> distances;
+            Generate(table, coordinates, distances);
+            Pack(table, distances);
+        }));
+    }
+    for(size_t i=0; i<results.size(); ++i)
+        results[i].get();
+}
+
+PruningTables::~PruningTables() {
+    for(size_t table=0; table<NUM_PRUNING_TABLES; ++table)
+        munmap(tables[table], mapping_sizes[table]);
+}
+
+void PruningTables::Generate(size_t table, const CoordinateTables &coordinates, std::vector<uint8_t> &distances) {
+    const std::vector<size_t> moves = GetQuarterTurnCoordinateMoves();
+    const Coordinate3 first = PRUNING_PAIRS[table].first;
+    const Coordinate3 second = PRUNING_PAIRS[table].second;
+    const uint16_t *first_moves = coordinates.GetTable(first);
+    const uint16_t *second_moves = coordinates.GetTable(second);
+    const uint32_t second_size = COORDINATE_SIZES[second];
+    const size_t size = GetSize(table);
+    CubieState3 solved = GetSolvedCubies3();
+    size_t known = 1;
+    size_t layer_size = 1;
+
+    distances.assign(size, PRUNING_UNKNOWN);
+    distances[GetIndex(table, GetCoordinate3(solved, first), GetCoordinate3(solved, second))] = 0;
+    for(uint8_t depth=0; layer_size > 0; ++depth) {
+        // Moves are closed under inversion, so an entry is in the next layer if a move takes it to this one
+        bool backwards = known > size / 2;
+        layer_size = 0;
+        for(uint32_t index=0; index<size; ++index) {
+            if(distances[index] != (backwards ? PRUNING_UNKNOWN : depth))
+                continue;
+            const uint16_t *first_row = first_moves + index / second_size * NUM_COORDINATE_MOVES;
+            const uint16_t *second_row = second_moves + index % second_size * NUM_COORDINATE_MOVES;
+            for(size_t i=0; i<moves.size(); ++i) {
+                uint32_t neighbour = first_row[moves[i]] * second_size + second_row[moves[i]];
+                if(backwards && distances[neighbour] == depth) {
+                    distances[index] = depth + 1;
+                    ++layer_size;
+                    break;
+                }
+                if(!backwards && distances[neighbour] == PRUNING_UNKNOWN) {
+                    distances[neighbour] = depth + 1;
+                    ++layer_size;
+                }
+            }
+        }
+        known += layer_size;
+    }
+}
+
+void PruningTables::Pack(size_t table, const std::vector<uint8_t> &distances) {
+    if(layout == BYTE_PRUNING) {
+        memcpy(tables[table], distances.data(), distances.size());
+        return;
+    }
+    // Mappings start zeroed, so entries are or'ed into their bytes
+    for(size_t index=0; index<distances.size(); ++index) {
+        uint8_t value = layout == MOD3_PRUNING ? distances[index] % 3 : distances[index];
+        tables[table][index >> entry_shift] |= value << ((index & entry_mask) << bits_shift);
+    }
+}
+
+uint8_t PruningTables::GetDistance(size_t table, uint32_t index, const CoordinateTables &coordinates) const {
+    if(layout != MOD3_PRUNING)
+        return GetValue(table, index);
+
+    const std::vector<size_t> moves = GetQuarterTurnCoordinateMoves();
+    const uint16_t *first_moves = coordinates.GetTable(PRUNING_PAIRS[table].first);
+    const uint16_t *second_moves = coordinates.GetTable(PRUNING_PAIRS[table].second);
+    const uint32_t second_size = COORDINATE_SIZES[PRUNING_PAIRS[table].second];
+    uint8_t distance = 0;
+    bool closer = true;
+
+    // Neighbours of a state at distance d > 0 include one at d-1, whose value is the only one equal to
+    // d-1 modulo 3. Solved states have no such neighbour
+    while(closer) {
+        uint8_t value = GetValue(table, index);
+        const uint16_t *first_row = first_moves + index / second_size * NUM_COORDINATE_MOVES;
+        const uint16_t *second_row = second_moves + index % second_size * NUM_COORDINATE_MOVES;
+        closer = false;
+        for(size_t i=0; i<moves.size() && !closer; ++i) {
+            uint32_t neighbour = first_row[moves[i]] * second_size + second_row[moves[i]];
+            if(GetValue(table, neighbour) == (value + 2) % 3) {
+                index = neighbour;
+                ++distance;
+                closer = true;
+            }
+        }
+    }
+    return distance;
+}
+
+size_t PruningTables::GetMemoryUsage() const {
+    size_t memory = 0;
+    for(size_t table=0; table<NUM_PRUNING_TABLES; ++table)
+        memory += (GetSize(table) + entry_mask) >> entry_shift;
+    return memory;
+}
@@ -0,0 +1,75 @@
+#include <random_state.h>
+#include <profiler.h>
+#include <vector>
+#include <future>
+
+/**
+  * @brief SplitMix64 generator, used to fill the state of streams from a seed
+  */
+static uint64_t SplitMix64(uint64_t &x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+RandomStream::RandomStream(uint64_t seed, uint64_t stream) {
+    // The stream number is mixed into the seed, so close seeds and streams give unrelated states
+    uint64_t x = seed;
+    uint64_t mixed = SplitMix64(x);
+    x = stream;
+    x = mixed ^ SplitMix64(x);
+    for(size_t i=0; i<4; ++i)
+        state[i] = SplitMix64(x);
+}
+
+RandomStream RandomStream::Split() {
+    uint64_t seed = Next();
+    return RandomStream(seed, Next());
+}
+
+void RandomState3(RandomStream &random, uint8_t *data) {
+    uint64_t corners = random.NextBelow(STATE3_CORNER_VALUES);
+    uint64_t edges = random.NextBelow(STATE3_EDGE_VALUES);
+    PackState3(0, corners, edges, data);
+}
+
+void RandomStates3(RandomStream &random, size_t num_states, uint8_t *data) {
+    for(size_t i=0; i<num_states; ++i)
+        RandomState3(random, data + i*STATE3_SIZE);
+}
+
+void GenerateRandomStates3(uint64_t seed, size_t num_states, uint8_t *data, ThreadPool &pool) {
+    PROFILE_SCOPE("GenerateRandomStates3");
+    std::vector<std::future<void>> blocks;
+    for(size_t first=0; first<num_states; first+=RANDOM_STATES_BLOCK) {
+        size_t block_size = std::min(RANDOM_STATES_BLOCK, num_states-first);
+        uint64_t stream = first / RANDOM_STATES_BLOCK;
+        blocks.push_back(pool.Submit([=]() {
+            RandomStream random(seed, stream);
+            RandomStates3(random, block_size, data + first*STATE3_SIZE);
+        }));
+    }
+    for(size_t i=0; i<blocks.size(); ++i)
+        blocks[i].get();
+}
+
+void RandomFacelets3(RandomStream &random, FaceElement *facelets) {
+    uint8_t data[STATE3_SIZE];
+    RandomState3(random, data);
+    DecodeFacelets3(data, facelets);
+}
+
+void RandomFacelets2(RandomStream &random, FaceElement *facelets) {
+    // Corners of a 2x2 cube are the corners of a 3x3 one. Edges are left solved: their parity is fixed up
+    // by the decoder, and all the 8! corner permutations are reachable on a 2x2 cube. Without centers,
+    // corner states already include all the whole cube orientations
+    uint8_t data[STATE3_SIZE];
+    FaceElement facelets3[NUM_FACELETS3];
+    PackState3(0, random.NextBelow(STATE3_CORNER_VALUES), 0, data);
+    DecodeFacelets3(data, facelets3);
+    for(size_t face=0; face<6; ++face)
+        for(size_t row=0; row<2; ++row)
+            for(size_t col=0; col<2; ++col)
+                facelets[(face*2+row)*2+col] = facelets3[(face*3+row*2)*3+col*2];
+}
@@ -0,0 +1,59 @@
+#include <relative_state.h>
+#include <unordered_map>
+#include <algorithm>
+
+/**
+  * @brief Computes the piece of each face element: its location, with coordinates of the face axis moved
+  *        inside the cube, so all the face elements of a piece have the same one
+  * @return Index of the piece of each face element, in the order of FaceletsToString
+  */
+static std::vector<size_t> GetFaceletPieces(size_t cube_size) {
+    std::vector<size_t> pieces(6*cube_size*cube_size);
+    int limit = cube_size - 1;
+    for(size_t i=0; i<pieces.size(); ++i) {
+        int location[3];
+        size_t piece = 0;
+        GetFaceletLocation((FaceElement)(i/(cube_size*cube_size)), i/cube_size%cube_size, i%cube_size, cube_size, location);
+        for(int j=0; j<3; ++j)
+            piece = piece*(2*cube_size+1) + std::max(-limit, std::min(limit, location[j])) + cube_size;
+        pieces[i] = piece;
+    }
+    return pieces;
+}
+
+/**
+  * @brief Computes the identity of each face element of a state: its color, and the colors of its piece
+  */
+static std::vector<int> GetFaceletIdentities(const FaceElement *facelets, const std::vector<size_t> &pieces) {
+    std::unordered_map<size_t, int> piece_colors;
+    std::vector<int> identities(pieces.size());
+    for(size_t i=0; i<pieces.size(); ++i) {
+        if(facelets[i] < 0 || facelets[i] >= INVALID)
+            throw std::invalid_argument("Invalid face element");
+        piece_colors[pieces[i]] |= 1 << facelets[i];
+    }
+    for(size_t i=0; i<pieces.size(); ++i)
+        identities[i] = piece_colors[pieces[i]] * INVALID + facelets[i];
+    return identities;
+}
+
+void GetRelativeFacelets(const FaceElement *source, const FaceElement *target, size_t cube_size,
+                         FaceElement *relative) {
+    const size_t face_size = cube_size*cube_size;
+    std::vector<size_t> pieces = GetFaceletPieces(cube_size);
+    std::vector<int> source_identities = GetFaceletIdentities(source, pieces);
+    std::vector<int> target_identities = GetFaceletIdentities(target, pieces);
+    std::unordered_map<int, size_t> target_positions;
+
+    for(size_t i=0; i<pieces.size(); ++i)
+        if(!target_positions.emplace(target_identities[i], i).second)
+            throw std::invalid_argument("Face elements of the state can't be told apart");
+    // Source identities are a permutation of the target ones if all of them are found, being as many
+    for(size_t i=0; i<pieces.size(); ++i) {
+        std::unordered_map<int, size_t>::const_iterator position = target_positions.find(source_identities[i]);
+        if(position == target_positions.end())
+            throw std::invalid_argument("States don't have the same face elements");
+        relative[i] = (FaceElement)(position->second / face_size);
+        target_positions.erase(position);
+    }
+}
@@ -0,0 +1,234 @@
+#include <graphical_cube.h>
+#include <notation.h>
+#include <profiler.h>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/*    Cube to render. Read from input lines: "<name> <setup moves> [| <animated moves>]"    */
+struct RenderJob {
+    std::string name;
+    std::string setup;
+    std::string moves;
+};
+
+struct RenderOptions {
+    size_t cube_size = 3;
+    size_t width = 512;
+    size_t height = 512;
+    size_t frames_per_move = 10;
+    size_t num_workers = 1;
+    float camera_pitch = deg_to_radians(-30.0);
+    float camera_yaw = deg_to_radians(25.0);
+    std::string format = "png";
+    std::string output_dir = ".";
+    std::string session;
+};
+
+
+/**
+  * @brief Prints usage of the program
+  * @param program Name of the executable
+  */
+void PrintUsage(const char *program) {
+    std::cerr << "Usage: " << program << " [options] < jobs\n"
+              << "Renders cubes without display. Each input line is a job:\n"
+              << "    <name> <setup moves> [| <animated moves>]\n"
+              << "Setup moves are applied instantly. Frame 0 shows the cube after setup, and each animated move adds\n"
+              << "'frames per move' frames. Frames are saved as <output>/<name>_<frame>.<format>\n"
+              << "Options:\n"
+              << "    --size N              Cube size, in range [2, 7] (default 3)\n"
+              << "    --width W             Frame width, in pixels (default 512)\n"
+              << "    --height H            Frame height, in pixels (default 512)\n"
+              << "    --frames-per-move F   Frames rendered per animated move (default 10)\n"
+              << "    --workers P           Number of worker processes (default 1)\n"
+              << "    --format EXT          Image format: png, ppm, bmp... (default png)\n"
+              << "    --output DIR          Output directory (default .)\n"
+              << "    --session FILE        Session recording to scrub. Setup of each job is then a time of the\n"
+              << "                          session, in milliseconds, and frame 0 shows the cube at that time\n"
+              << "Output: one line per frame: <name> <frame> <render time in ms>" << std::endl;
+}
+
+/**
+  * @brief Parses command line options
+  * @return False if options are not valid
+  */
+bool ParseOptions(int argc, char *argv[], RenderOptions &options) {
+    for(int i=1; i<argc; i+=2) {
+        std::string option = argv[i];
+        if(i+1 >= argc)
+            return false;
+        std::string value = argv[i+1];
+        try {
+            if(option == "--size")
+                options.cube_size = std::stoul(value);
+            else if(option == "--width")
+                options.width = std::stoul(value);
+            else if(option == "--height")
+                options.height = std::stoul(value);
+            else if(option == "--frames-per-move")
+                options.frames_per_move = std::stoul(value);
+            else if(option == "--workers")
+                options.num_workers = std::stoul(value);
+            else if(option == "--format")
+                options.format = value;
+            else if(option == "--output")
+                options.output_dir = value;
+            else if(option == "--session")
+                options.session = value;
+            else
+                return false;
+        } catch(const std::logic_error &e) {
+            return false;
+        }
+    }
+    return options.cube_size >= 2 && options.cube_size <= 7 && options.num_workers > 0 &&
+           options.width > 0 && options.height > 0;
+}
+
+/**
+  * @brief Reads jobs from a stream, one per line. Empty lines are skipped
+  */
+std::vector<RenderJob> ReadJobs(std::istream &is) {
+    std::vector<RenderJob> jobs;
+    std::string line;
+    while(std::getline(is, line)) {
+        std::istringstream fields(line);
+        RenderJob job;
+        if(!(fields >> job.name))
+            continue;
+        std::getline(fields, line);
+        size_t separator = line.find('|');
+        job.setup = line.substr(0, separator);
+        if(separator != std::string::npos)
+            job.moves = line.substr(separator+1);
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+/**
+  * @brief Parses the setup of a job as a time of the session
+  * @return Time, in milliseconds
+  * @throw std::invalid_argument if it is not a number of milliseconds of 32 bits
+  */
+uint32_t ParseSessionTime(const std::string &setup) {
+    std::istringstream fields(setup);
+    std::string time;
+    std::string extra;
+    if(!(fields >> time) || fields >> extra || time.size() > 10 ||
+       time.find_first_not_of("0123456789") != std::string::npos || std::stoull(time) > UINT32_MAX)
+        throw std::invalid_argument("Invalid session time '" + setup + "'");
+    return std::stoull(time);
+}
+
+/**
+  * @brief Renders all frames of a job and reports render time of each one to stdout
+  */
+template<size_t CUBE_SIZE>
+void RunJob(const RenderJob &job, const RenderOptions &options) {
+    std::vector<Move> setup;
+    std::vector<Move> moves = ParseMoves(job.moves, CUBE_SIZE);
+    GraphicalRubikCube<CUBE_SIZE> cube(L"", options.width, options.height, 1.0, HEADLESS);
+    size_t frame = 0;
+
+    auto render_frame = [&](size_t) {
+        std::ostringstream filename;
+        filename << options.output_dir << '/' << job.name << '_' << std::setw(5) << std::setfill('0') << frame
+                 << '.' << options.format;
+        double render_time = cube.RenderToFile(filename.str());
+        // A single write per line, so lines of different workers don't get mixed
+        printf("%s %zu %.3f\n", job.name.c_str(), frame, render_time*1000.0);
+        fflush(stdout);
+        ++frame;
+    };
+
+    cube.SetCameraOrientation(options.camera_pitch, options.camera_yaw);
+    if(options.session.empty()) {
+        setup = ParseMoves(job.setup, CUBE_SIZE);
+        for(size_t i=0; i<setup.size(); ++i)
+            cube.ApplyMove(setup[i]);
+    } else {
+        // Seeking rebuilds the state from the closest snapshot, so any time costs about the same
+        uint32_t time = ParseSessionTime(job.setup);
+        cube.LoadSession(options.session);
+        cube.SeekHistory(cube.GetHistory().FindPosition(time));
+    }
+    render_frame(0);
+    for(size_t i=0; i<moves.size(); ++i)
+        cube.AnimateMove(moves[i], options.frames_per_move, render_frame);
+}
+
+/**
+  * @brief Renders a job with the cube size selected in options
+  */
+void RunJob(const RenderJob &job, const RenderOptions &options) {
+    switch(options.cube_size) {
+    case 2: RunJob<2>(job, options); break;
+    case 3: RunJob<3>(job, options); break;
+    case 4: RunJob<4>(job, options); break;
+    case 5: RunJob<5>(job, options); break;
+    case 6: RunJob<6>(job, options); break;
+    case 7: RunJob<7>(job, options); break;
+    default: throw std::invalid_argument("Unsupported cube size");
+    }
+}
+
+/**
+  * @brief Renders jobs assigned to a worker: worker_id, worker_id + num_workers...
+  * @return Number of failed jobs
+  */
+size_t RunWorker(const std::vector<RenderJob> &jobs, const RenderOptions &options, size_t worker_id) {
+    size_t num_failed = 0;
+    for(size_t i=worker_id; i<jobs.size(); i+=options.num_workers) {
+        try {
+            RunJob(jobs[i], options);
+        } catch(const std::exception &e) {
+            std::cerr << jobs[i].name << ": error: " << e.what() << std::endl;
+            ++num_failed;
+        }
+    }
+    return num_failed;
+}
+
+int main(int argc, char *argv[]) {
+    RenderOptions options;
+    std::vector<RenderJob> jobs;
+    std::vector<pid_t> workers;
+    bool failed = false;
+
+    if(!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    jobs = ReadJobs(std::cin);
+
+    // Each worker owns its own device, so they don't share any state
+    for(size_t i=0; i<options.num_workers; ++i) {
+        pid_t pid = fork();
+        if(pid < 0) {
+            perror("fork");
+            failed = true;
+            break;
+        } else if(pid == 0) {
+            int status = RunWorker(jobs, options, i) == 0 ? 0 : 1;
+            // Static objects are not destroyed by _exit, so the trace of the worker is saved here
+            SaveProfileTrace();
+            _exit(status);
+        }
+        workers.push_back(pid);
+    }
+
+    for(size_t i=0; i<workers.size(); ++i) {
+        int status;
+        if(waitpid(workers[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            failed = true;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,76 @@
+#include <rubik.h>
+
+std::string FaceToString(FaceElement face) {
+    std::string str;
+    switch(face) {
+    case FRONT:  str = "front";   break;
+    case BACK:   str = "back";    break;
+    case LEFT:   str = "left";    break;
+    case RIGHT:  str = "right";   break;
+    case TOP:    str = "top";     break;
+    case BOTTOM: str = "bottom";  break;
+    default:     str = "invalid"; break;
+    }
+    return str;
+}
+
+std::string FaceElementToString(FaceElement face_element) {
+    std::string str;
+    switch(face_element) {
+    case FRONT:  str = "F";  break;
+    case BACK:   str = "B";  break;
+    case LEFT:   str = "L";  break;
+    case RIGHT:  str = "R";  break;
+    case TOP:    str = "U";  break;
+    case BOTTOM: str = "D";  break;
+    default:     str = "I";  break;
+    }
+    return str;
+}
+
+Clockwise operator!(Clockwise clockwise) {
+    if(clockwise == CLOCKWISE)
+        clockwise = COUNTERCLOCKWISE;
+    else
+        clockwise = CLOCKWISE;
+    return clockwise;
+}
+
+FaceElement operator!(FaceElement face) {
+    switch(face) {
+    case FRONT:  face = BACK;   break;
+    case BACK:   face = FRONT;  break;
+    case LEFT:   face = RIGHT;  break;
+    case RIGHT:  face = LEFT;   break;
+    case TOP:    face = BOTTOM; break;
+    case BOTTOM: face = TOP;    break;
+    }
+    return face;
+}
+
+void GetFaceletLocation(FaceElement face, size_t row, size_t col, size_t cube_size, int location[3]) {
+    int pos_row = 2*(int)row - ((int)cube_size-1);
+    int pos_col = 2*(int)col - ((int)cube_size-1);
+    int depth = cube_size;
+    switch(face) {
+    case FRONT:  location[0] = -pos_col; location[1] = -pos_row; location[2] = depth;    break;
+    case BACK:   location[0] = pos_col;  location[1] = -pos_row; location[2] = -depth;   break;
+    case LEFT:   location[0] = depth;    location[1] = -pos_row; location[2] = pos_col;  break;
+    case RIGHT:  location[0] = -depth;   location[1] = -pos_row; location[2] = -pos_col; break;
+    case TOP:    location[0] = -pos_col; location[1] = depth;    location[2] = pos_row;  break;
+    case BOTTOM: location[0] = -pos_col; location[1] = -depth;   location[2] = -pos_row; break;
+    default:     assert(false);
+    }
+}
+
+std::ostream& operator<<(std::ostream &os, Clockwise clockwise) {
+    switch(clockwise) {
+    case CLOCKWISE:
+        os << "CW"; break;
+    case COUNTERCLOCKWISE:
+        os << "CCW"; break;
+    default:
+        os << "INVALID_CW";
+    }
+    return os;
+}
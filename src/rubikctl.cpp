@@ -0,0 +1,1346 @@
+#include <rubik.h>
+#include <notation.h>
+#include <solver.h>
+#include <bidirectional_solver.h>
+#include <ida_solver.h>
+#include <relative_state.h>
+#include <symmetry.h>
+#include <peephole_optimizer.h>
+#include <dataset.h>
+#include <shard_coordinator.h>
+#include <move_generator.h>
+#include <coordinate_tables.h>
+#include <thread_pool.h>
+#include <move_table.h>
+#include <algorithm_cache.h>
+#include <random_state.h>
+#include <state_file.h>
+#include <zobrist.h>
+#include <transposition_table.h>
+#include <tools.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <numeric>
+#include <future>
+#include <memory>
+#include <stdexcept>
+
+/*    Tasks in flight per worker thread. Results are written in input order, so this bounds buffered results    */
+const size_t TASKS_PER_THREAD = 4;
+
+/*    Lines checked by each task of verify    */
+const size_t VERIFY_BATCH_SIZE = 4096;
+
+/*    Lookups of the cache of a verify thread before it is skipped, if less than VERIFY_CACHE_MIN_HITS of them hit.
+      Misses cost more than compiling the sequence, so inputs which don't repeat are compiled directly    */
+const size_t VERIFY_CACHE_PROBE = 8192;
+const double VERIFY_CACHE_MIN_HITS = 0.25;
+
+/*    Nodes searched by a shard between checks of cancellation    */
+const uint64_t SHARD_POLL_NODES = 65536;
+
+/*    Random states checked by each task of coordinates    */
+const size_t COORDINATES_BATCH_SIZE = 1024;
+
+/*    Dependent lookups timed by pruning, on each layout    */
+const size_t PRUNING_REPORT_LOOKUPS = 1 << 24;
+
+/*    Result of a line of apply or solve    */
+struct LineResult {
+    std::string output;
+    std::string log; // Written to stderr, if not empty
+};
+
+struct CtlOptions {
+    std::string command;
+    size_t cube_size = 3;
+    size_t num_threads = 0;
+    size_t max_depth = 6;
+    size_t count = 1000;
+    uint64_t seed = 0;
+    std::string output;
+    TurnMetric metric = FACE_TURN_METRIC;
+    bool naive = false;
+    std::string tables;
+    std::string solver = "iddfs";
+    HeuristicEvaluation evaluation = BATCHED_EVALUATION;
+    PruningLayout layout = BYTE_PRUNING;
+    size_t num_workers = 0;
+    size_t shard_depth = 2;
+    size_t window = 6;
+    std::string checkpoint;
+    TensorEncoding encoding = COMPACT_TENSOR;
+    std::vector<double> depth_weights;
+    size_t shard_size = 1 << 20;
+    size_t transpositions = 0;
+    size_t cache_capacity = DEFAULT_ALGORITHM_CACHE_CAPACITY;
+    std::vector<std::string> files;
+};
+
+
+/**
+  * @brief Prints usage of the program
+  * @param program Name of the executable
+  */
+void PrintUsage(const char *program) {
+    std::cerr << "Usage: " << program << " <command> [options] [files...]\n"
+              << "Reads one move sequence per line from files (or stdin), processes lines in parallel and\n"
+              << "writes one result line per input line, in input order. Empty lines are skipped\n"
+              << "Commands:\n"
+              << "    apply    Applies the moves to a solved cube and writes its face elements\n"
+              << "             (see FaceletsToString)\n"
+              << "    canonical  Applies the moves to a solved cube and writes \"<face elements> <symmetry>\": the\n"
+              << "             least of its 48 symmetric states (rotations and mirror images), and the symmetry\n"
+              << "             which gives it. States have the same face elements only if they are symmetric\n"
+              << "    solve    Applies the moves to a solved cube and writes a shortest solution, or\n"
+              << "             \"unsolved\" if there is no solution of at most --max-depth quarter turns\n"
+              << "    between  Reads \"<source> | <target>\" lines of moves, applied to solved cubes, and writes a\n"
+              << "             shortest sequence which turns the source cube into the target one, in any\n"
+              << "             orientation, or \"unsolved\". Only 2x2 and 3x3 cubes\n"
+              << "    verify   Reads \"<scramble> | <solution>\" lines and writes \"ok\" if the solution solves the\n"
+              << "             scrambled cube, in any orientation, or \"fail\". Totals and throughput go to stderr\n"
+              << "    random   Doesn't read input. Writes --count uniformly random 2x2 or 3x3 states as face\n"
+              << "             elements, or a state file with a \"state\" column if --output is given\n"
+              << "    enumerate  Doesn't read input. Applies every move sequence of up to --max-depth moves to a\n"
+              << "             cube, skipping trivially redundant ones, and writes \"<depth> <nodes> <branching>\"\n"
+              << "             lines. Throughput goes to stderr\n"
+              << "    optimize Shortens each move sequence by replacing windows of --window moves with shortest\n"
+              << "             sequences which have the same effect on the cube, until no window improves.\n"
+              << "             Windows are searched in parallel, and lines one after the other. Lengths and\n"
+              << "             time go to stderr\n"
+              << "    dataset  Doesn't read input. Writes --count states reached by random scrambles of quarter\n"
+              << "             turns, labeled with their length (an upper bound of the distance), to shards\n"
+              << "             \"<--output>-00000\", \"<--output>-00001\"... of --shard-size samples. Shards are\n"
+              << "             state files with a \"state\" column of --encoding tensors and a \"scramble_length\"\n"
+              << "             column of bytes. Throughput goes to stderr\n"
+              << "    coordinates  Doesn't read input. Builds the 3x3 coordinate move tables, or reads them from\n"
+              << "             --tables, and checks them against face elements on --count random states, each one\n"
+              << "             followed by --max-depth random moves. Writes \"<coordinate> <values> <mismatches>\"\n"
+              << "             lines\n"
+              << "    pruning  Doesn't read input. Builds the 3x3 pruning tables in each layout, with and without\n"
+              << "             transparent huge pages, and writes \"<layout> <huge pages> <bytes> <huge page bytes>\n"
+              << "             <ns per lookup>\" lines, timing dependent lookups at random entries\n"
+              << "Options:\n"
+              << "    --size N         Cube size, in range [2, 7] (default 3)\n"
+              << "    --threads P      Number of worker threads (default: hardware threads)\n"
+              << "    --max-depth D    Maximum solution length of solve, in quarter turns (default 6)\n"
+              << "    --count C        Number of random states (default 1000)\n"
+              << "    --seed S         Seed of random states. Output only depends on the seed (default 0)\n"
+              << "    --output FILE    State file written by random, or prefix of the shards of dataset\n"
+              << "    --metric M       Moves of enumerate: \"face\" for quarter and half turns, \"quarter\" for\n"
+              << "                     quarter turns (default face)\n"
+              << "    --generator G    \"canonical\" skips redundant sequences, \"naive\" enumerates all of them\n"
+              << "                     (default canonical)\n"
+              << "    --tables FILE    File of coordinate tables. It is written if it is missing or not valid\n"
+              << "    --solver S       Search of solve and between: \"iddfs\", \"bidirectional\", which uses\n"
+              << "                     more memory to meet the solved states halfway, or \"ida\", which skips\n"
+              << "                     moves with 3x3 pruning tables built at startup (from the coordinate\n"
+              << "                     tables of --tables, if given). Nodes, memory and latency of the last two\n"
+              << "                     go to stderr, a line per solve (default iddfs)\n"
+              << "    --evaluation E   Bounds of the children of an ida node: \"batched\" evaluates all of them\n"
+              << "                     together, prefetching their pruning table entries, \"single\" one at a\n"
+              << "                     time (default batched)\n"
+              << "    --layout L       Entries of the ida pruning tables: \"byte\", \"nibble\" (4 bits) or \"mod3\"\n"
+              << "                     (2 bits, the distance modulo 3) (default byte)\n"
+              << "    --workers W      Runs solve or enumerate in W worker processes, each one taking the subtrees\n"
+              << "                     of the move sequences of --shard-depth moves, one at a time. Lines are\n"
+              << "                     solved one after the other (default 0: threads of a single process)\n"
+              << "    --shard-depth K  Length of the move sequences of each shard (default 2)\n"
+              << "    --window W       Quarter turns of the windows of optimize (default 6)\n"
+              << "    --checkpoint F   Results of the shards done by the workers are appended to file F, and\n"
+              << "                     the ones already in it are not run again, so a killed job resumes\n"
+              << "    --encoding E     Tensors of dataset: \"compact\", the color of each face element in a byte,\n"
+              << "                     or \"onehot\", 6 bytes per face element (default compact)\n"
+              << "    --depth-weights W  Comma separated relative frequencies of the scramble lengths of dataset,\n"
+              << "                     from 0 quarter turns (default: the same for 0 to --max-depth)\n"
+              << "    --shard-size S   Samples of each shard of dataset (default 1048576)\n"
+              << "    --cache C        Compiled scrambles and solutions kept by each thread of verify, so the\n"
+              << "                     ones which repeat are compiled once. Threads whose first lookups mostly\n"
+              << "                     miss stop using it. Hit rate goes to stderr. 0 compiles every line\n"
+              << "                     (default 1024)\n"
+              << "    --transpositions T  Entries of a transposition table shared by the iddfs searches of solve\n"
+              << "                     and between, which skips the states already searched. It pays off on\n"
+              << "                     2x2 cubes. Skipped states go to stderr, a line per solve. --max-depth\n"
+              << "                     shall be 255 at most (default 0: none)\n"
+              << "Invalid lines produce \"error: <message>\"" << std::endl;
+}
+
+/**
+  * @brief Parses command line options
+  * @return False if options are not valid
+  */
+bool ParseOptions(int argc, char *argv[], CtlOptions &options) {
+    if(argc < 2)
+        return false;
+    options.command = argv[1];
+    for(int i=2; i<argc; ++i) {
+        std::string option = argv[i];
+        if(option.compare(0, 2, "--") != 0) {
+            options.files.push_back(option);
+            continue;
+        }
+        if(i+1 >= argc)
+            return false;
+        std::string value = argv[++i];
+        try {
+            if(option == "--size")
+                options.cube_size = std::stoul(value);
+            else if(option == "--threads")
+                options.num_threads = std::stoul(value);
+            else if(option == "--max-depth")
+                options.max_depth = std::stoul(value);
+            else if(option == "--count")
+                options.count = std::stoull(value);
+            else if(option == "--seed")
+                options.seed = std::stoull(value);
+            else if(option == "--output")
+                options.output = value;
+            else if(option == "--metric" && (value == "face" || value == "quarter"))
+                options.metric = value == "face" ? FACE_TURN_METRIC : QUARTER_TURN_METRIC;
+            else if(option == "--generator" && (value == "canonical" || value == "naive"))
+                options.naive = value == "naive";
+            else if(option == "--tables")
+                options.tables = value;
+            else if(option == "--solver" && (value == "iddfs" || value == "bidirectional" || value == "ida"))
+                options.solver = value;
+            else if(option == "--evaluation" && (value == "batched" || value == "single"))
+                options.evaluation = value == "batched" ? BATCHED_EVALUATION : SINGLE_EVALUATION;
+            else if(option == "--layout" && (value == "byte" || value == "nibble" || value == "mod3"))
+                options.layout = value == "byte" ? BYTE_PRUNING : value == "nibble" ? NIBBLE_PRUNING : MOD3_PRUNING;
+            else if(option == "--workers")
+                options.num_workers = std::stoul(value);
+            else if(option == "--shard-depth")
+                options.shard_depth = std::stoul(value);
+            else if(option == "--checkpoint")
+                options.checkpoint = value;
+            else if(option == "--window")
+                options.window = std::stoul(value);
+            else if(option == "--encoding" && (value == "compact" || value == "onehot"))
+                options.encoding = value == "compact" ? COMPACT_TENSOR : ONE_HOT_TENSOR;
+            else if(option == "--depth-weights") {
+                std::istringstream weights(value);
+                std::string weight;
+                options.depth_weights.clear();
+                while(std::getline(weights, weight, ','))
+                    options.depth_weights.push_back(std::stod(weight));
+            } else if(option == "--shard-size")
+                options.shard_size = std::stoull(value);
+            else if(option == "--cache")
+                options.cache_capacity = std::stoul(value);
+            else if(option == "--transpositions")
+                options.transpositions = std::stoull(value);
+            else
+                return false;
+        } catch(const std::logic_error &e) {
+            return false;
+        }
+    }
+    if(options.num_workers > 0 && ((options.command != "solve" && options.command != "enumerate") ||
+                                   options.solver != "iddfs"))
+        return false;
+    if(options.solver == "ida" && options.cube_size != 3)
+        return false;
+    if(options.transpositions > 0 && (options.solver != "iddfs" || options.num_workers > 0 ||
+                                      options.max_depth > MAX_TRANSPOSITION_DEPTH))
+        return false;
+    if(options.command == "random")
+        return options.cube_size == 2 || options.cube_size == 3;
+    if(options.command == "coordinates" || options.command == "pruning")
+        return options.cube_size == 3;
+    if(options.command == "between")
+        return options.cube_size == 2 || options.cube_size == 3;
+    if(options.command == "dataset")
+        return !options.output.empty() && options.shard_size > 0 && options.cube_size >= 2 && options.cube_size <= 7;
+    return (options.command == "apply" || options.command == "canonical" || options.command == "solve" ||
+            options.command == "verify" ||
+            options.command == "enumerate" || options.command == "optimize") &&
+           options.cube_size >= 2 && options.cube_size <= 7;
+}
+
+/**
+  * @brief Solves a cube with an IDA* solver, which only exists for 3x3 cubes
+  * @return Log line of the search
+  */
+std::string SolveIDAStar(const RubikCube<int, 3> &cube, const IDAStarSolver3 &solver, const CtlOptions &options,
+                         std::vector<Move> &solution, bool &solved) {
+    IDAStarStats stats;
+    solved = solver.Solve(cube, options.max_depth, solution, options.evaluation, &stats);
+    return "nodes " + std::to_string(stats.nodes) + " latency " + std::to_string(stats.latency) +
+           " iterations " + std::to_string(stats.iterations);
+}
+
+template<size_t CUBE_SIZE>
+std::string SolveIDAStar(const RubikCube<int, CUBE_SIZE>&, const IDAStarSolver3&, const CtlOptions&,
+                         std::vector<Move>&, bool&) {
+    throw std::invalid_argument("Unsupported cube size");
+}
+
+/**
+  * @brief Processes a line of input
+  * @param ida Solver of --solver ida. Null for other solvers
+  * @param transpositions Table of --transpositions. Null if there is none
+  * @return Result line, without end of line
+  */
+template<size_t CUBE_SIZE>
+LineResult ProcessLine(const std::string &line, const CtlOptions &options, const IDAStarSolver3 *ida,
+                       TranspositionTable *transpositions) {
+    RubikCube<int, CUBE_SIZE> cube;
+    std::vector<Move> solution;
+    BidirectionalStats stats;
+    bool solved;
+
+    try {
+        size_t separator = line.find('|');
+        std::vector<Move> moves = ParseMoves(line.substr(0, separator), CUBE_SIZE);
+        for(size_t i=0; i<moves.size(); ++i)
+            cube.RotateFace(moves[i]);
+        if(options.command == "between") {
+            // The cube to solve is the source relative to the target
+            RubikCube<int, CUBE_SIZE> target;
+            if(separator == std::string::npos)
+                throw std::invalid_argument("Missing '|' between source and target");
+            moves = ParseMoves(line.substr(separator+1), CUBE_SIZE);
+            for(size_t i=0; i<moves.size(); ++i)
+                target.RotateFace(moves[i]);
+            RubikCube<int, CUBE_SIZE> source = cube;
+            GetRelativeState(source, target, cube);
+        } else if(separator != std::string::npos) {
+            throw std::invalid_argument("Unexpected '|'");
+        }
+    } catch(const std::invalid_argument &e) {
+        return {std::string("error: ") + e.what(), ""};
+    }
+
+    if(options.command == "apply")
+        return {FaceletsToString(cube), ""};
+    if(options.command == "canonical") {
+        std::array<FaceElement, 6*CUBE_SIZE*CUBE_SIZE> canonical;
+        size_t symmetry = CanonicalizeState(cube, canonical.data());
+        std::string output;
+        for(size_t i=0; i<canonical.size(); ++i)
+            output += FaceElementToString(canonical[i]);
+        return {output + " " + std::to_string(symmetry), ""};
+    }
+    if(options.solver == "iddfs" && transpositions) {
+        uint64_t skipped = 0;
+        solved = SolveIDDFS(cube, options.max_depth, solution, *transpositions, skipped);
+        return {solved ? MovesToString(solution) : "unsolved", "skipped " + std::to_string(skipped)};
+    }
+    if(options.solver == "iddfs") {
+        if(!SolveIDDFS(cube, options.max_depth, solution))
+            return {"unsolved", ""};
+        return {MovesToString(solution), ""};
+    }
+    if(options.solver == "ida") {
+        std::string log = SolveIDAStar(cube, *ida, options, solution, solved);
+        return {solved ? MovesToString(solution) : "unsolved", log};
+    }
+
+    solved = SolveBidirectional(cube, options.max_depth, solution, &stats);
+    std::string log = "nodes " + std::to_string(stats.nodes) + " memory " + std::to_string(stats.memory) +
+                      " latency " + std::to_string(stats.latency) + " depth " +
+                      std::to_string(stats.forward_depth) + "+" + std::to_string(stats.backward_depth);
+    return {solved ? MovesToString(solution) : "unsolved", log};
+}
+
+/**
+  * @brief Processes a line with the cube size selected in options
+  */
+LineResult ProcessLine(const std::string &line, const CtlOptions &options, const IDAStarSolver3 *ida,
+                       TranspositionTable *transpositions) {
+    LineResult result;
+    switch(options.cube_size) {
+    case 2: result = ProcessLine<2>(line, options, ida, transpositions); break;
+    case 3: result = ProcessLine<3>(line, options, ida, transpositions); break;
+    case 4: result = ProcessLine<4>(line, options, ida, transpositions); break;
+    case 5: result = ProcessLine<5>(line, options, ida, transpositions); break;
+    case 6: result = ProcessLine<6>(line, options, ida, transpositions); break;
+    case 7: result = ProcessLine<7>(line, options, ida, transpositions); break;
+    default: throw std::invalid_argument("Unsupported cube size");
+    }
+    return result;
+}
+
+/**
+  * @brief Waits for the oldest pending line and writes its result
+  */
+void WriteLineResult(std::deque<std::future<LineResult>> &pending) {
+    LineResult result = pending.front().get();
+    pending.pop_front();
+    std::cout << result.output << '\n';
+    if(!result.log.empty())
+        std::cerr << result.log << '\n';
+}
+
+/**
+  * @brief Processes all lines of a stream. Results are written as soon as all previous ones are ready
+  */
+void ProcessStream(std::istream &is, const CtlOptions &options, const IDAStarSolver3 *ida,
+                   TranspositionTable *transpositions, ThreadPool &pool, std::deque<std::future<LineResult>> &pending) {
+    std::string line;
+    while(std::getline(is, line)) {
+        if(line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+        if(pending.size() >= TASKS_PER_THREAD * pool.GetNumThreads())
+            WriteLineResult(pending);
+        pending.push_back(pool.Submit([line, &options, ida, transpositions]() {
+            return ProcessLine(line, options, ida, transpositions);
+        }));
+    }
+}
+
+/*    Results of a batch of verify lines    */
+struct VerifyBatch {
+    std::string output;
+    size_t num_lines = 0;
+    size_t num_ok = 0;
+    size_t num_errors = 0;
+    size_t num_moves = 0;
+    size_t num_hits = 0;   // Scrambles and solutions found in the cache
+    size_t num_misses = 0;
+};
+
+/**
+  * @brief Checks a batch of "<scramble> | <solution>" lines, composing the precomputed permutations of the moves.
+  *        Permutations of scrambles and solutions are kept by a cache of each thread, unless its capacity is 0 or
+  *        it misses too often (see VERIFY_CACHE_PROBE)
+  */
+template<size_t CUBE_SIZE>
+VerifyBatch VerifyLines(const std::vector<std::string> &lines, size_t cache_capacity) {
+    const MoveTable<CUBE_SIZE> &table = MoveTable<CUBE_SIZE>::Get();
+    // Caches outlive the batches, so sequences which repeat anywhere in the input are compiled once per thread
+    static thread_local AlgorithmCache<CUBE_SIZE> cache(std::max<size_t>(cache_capacity, 1));
+    size_t num_hits = cache.GetNumHits();
+    size_t num_misses = cache.GetNumMisses();
+    bool cached = cache_capacity > 0 && (num_hits + num_misses < VERIFY_CACHE_PROBE ||
+                                         num_hits >= VERIFY_CACHE_MIN_HITS * (num_hits + num_misses));
+    VerifyBatch batch;
+    std::vector<Move> moves;
+
+    batch.num_lines = lines.size();
+    for(size_t i=0; i<lines.size(); ++i) {
+        const std::string &line = lines[i];
+        size_t separator = line.find('|');
+        FaceletPermutation<CUBE_SIZE> permutation;
+        moves.clear();
+        try {
+            if(separator == std::string::npos)
+                throw std::invalid_argument("Missing '|' between scramble and solution");
+            const char *middle = line.data() + separator;
+            if(!cached) {
+                ParseMoves(line.data(), middle, CUBE_SIZE, moves);
+                ParseMoves(middle + 1, line.data() + line.size(), CUBE_SIZE, moves);
+                table.Compile(moves, permutation);
+                batch.num_moves += moves.size();
+            } else {
+                // The permutation of the scramble is copied, since the next lookup may discard it
+                permutation = cache.Get(line.data(), middle);
+                size_t num_moves = cache.GetLastLength();
+                permutation = permutation.Then(cache.Get(middle + 1, line.data() + line.size()));
+                batch.num_moves += num_moves + cache.GetLastLength();
+            }
+        } catch(const std::invalid_argument &e) {
+            batch.output += std::string("error: ") + e.what() + '\n';
+            ++batch.num_errors;
+            continue;
+        }
+
+        if(permutation.IsSolving()) {
+            batch.output += "ok\n";
+            ++batch.num_ok;
+        } else {
+            batch.output += "fail\n";
+        }
+    }
+    batch.num_hits = cache.GetNumHits() - num_hits;
+    batch.num_misses = cache.GetNumMisses() - num_misses;
+    return batch;
+}
+
+/**
+  * @brief Checks a batch of lines with the cube size selected in options
+  */
+VerifyBatch VerifyLines(const std::vector<std::string> &lines, const CtlOptions &options) {
+    switch(options.cube_size) {
+    case 2: return VerifyLines<2>(lines, options.cache_capacity);
+    case 3: return VerifyLines<3>(lines, options.cache_capacity);
+    case 4: return VerifyLines<4>(lines, options.cache_capacity);
+    case 5: return VerifyLines<5>(lines, options.cache_capacity);
+    case 6: return VerifyLines<6>(lines, options.cache_capacity);
+    case 7: return VerifyLines<7>(lines, options.cache_capacity);
+    default: throw std::invalid_argument("Unsupported cube size");
+    }
+}
+
+/**
+  * @brief Waits for the oldest pending batch, writes its results and adds its counters to 'totals'
+  */
+void WriteVerifyBatch(std::deque<std::future<VerifyBatch>> &pending, VerifyBatch &totals) {
+    VerifyBatch batch = pending.front().get();
+    pending.pop_front();
+    std::cout << batch.output;
+    totals.num_lines += batch.num_lines;
+    totals.num_ok += batch.num_ok;
+    totals.num_errors += batch.num_errors;
+    totals.num_moves += batch.num_moves;
+    totals.num_hits += batch.num_hits;
+    totals.num_misses += batch.num_misses;
+}
+
+/**
+  * @brief Verifies all lines of a stream, in batches. Results are written in input order
+  * @param totals Counters of all the lines, including the ones of 'pending' batches once they are written
+  */
+void VerifyStream(std::istream &is, const CtlOptions &options, ThreadPool &pool,
+                  std::deque<std::future<VerifyBatch>> &pending, VerifyBatch &totals) {
+    std::vector<std::string> lines;
+    std::string line;
+
+    auto submit = [&]() {
+        if(pending.size() >= TASKS_PER_THREAD * pool.GetNumThreads())
+            WriteVerifyBatch(pending, totals);
+        pending.push_back(pool.Submit([batch = std::move(lines), &options]() { return VerifyLines(batch, options); }));
+        lines.clear();
+    };
+
+    while(std::getline(is, line)) {
+        if(line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+        lines.push_back(line);
+        if(lines.size() == VERIFY_BATCH_SIZE)
+            submit();
+    }
+    if(!lines.empty())
+        submit();
+}
+
+/**
+  * @brief Generates a block of random states. Block i uses RandomStream(seed, i), like GenerateRandomStates3
+  * @param record Callable object which receives each random cube
+  */
+template<size_t CUBE_SIZE, typename Function>
+void RandomBlock(uint64_t seed, size_t block, size_t num_states, Function record) {
+    RandomStream random(seed, block);
+    RubikCube<int, CUBE_SIZE> cube;
+    for(size_t i=0; i<num_states; ++i) {
+        RandomizeCube(random, cube);
+        record(cube);
+    }
+}
+
+/**
+  * @brief Runs the random command
+  * @return Exit status
+  */
+template<size_t CUBE_SIZE>
+int RunRandom(const CtlOptions &options, ThreadPool &pool) {
+    double start = get_monotonic_time();
+    size_t num_blocks = (options.count + RANDOM_STATES_BLOCK - 1) / RANDOM_STATES_BLOCK;
+
+    if(options.output.empty()) {
+        std::deque<std::future<std::string>> pending;
+        for(size_t block=0; block<num_blocks; ++block) {
+            size_t num_states = std::min(RANDOM_STATES_BLOCK, options.count - block*RANDOM_STATES_BLOCK);
+            if(pending.size() >= TASKS_PER_THREAD * pool.GetNumThreads()) {
+                std::cout << pending.front().get();
+                pending.pop_front();
+            }
+            pending.push_back(pool.Submit([&options, block, num_states]() {
+                std::string lines;
+                RandomBlock<CUBE_SIZE>(options.seed, block, num_states, [&lines](const RubikCube<int, CUBE_SIZE> &cube) {
+                    lines += FaceletsToString(cube);
+                    lines += '\n';
+                });
+                return lines;
+            }));
+        }
+        while(!pending.empty()) {
+            std::cout << pending.front().get();
+            pending.pop_front();
+        }
+        std::cout.flush();
+        return 0;
+    }
+
+    try {
+        StateFileWriter writer(options.output, CUBE_SIZE, options.count);
+        if(CUBE_SIZE == 3) {
+            size_t column = writer.AddColumn("state", COLUMN_STATE3);
+            std::vector<uint8_t> states(options.count * STATE3_SIZE);
+            GenerateRandomStates3(options.seed, options.count, states.data(), pool);
+            writer.Append(column, states.data(), options.count);
+        } else {
+            size_t column = writer.AddColumn("state", COLUMN_FACELETS);
+            std::vector<std::future<std::vector<uint8_t>>> blocks;
+            for(size_t block=0; block<num_blocks; ++block) {
+                size_t num_states = std::min(RANDOM_STATES_BLOCK, options.count - block*RANDOM_STATES_BLOCK);
+                blocks.push_back(pool.Submit([&options, block, num_states]() {
+                    std::vector<uint8_t> records(num_states * GetPackedFaceletsSize(CUBE_SIZE));
+                    uint8_t *record = records.data();
+                    RandomBlock<CUBE_SIZE>(options.seed, block, num_states, [&record](const RubikCube<int, CUBE_SIZE> &cube) {
+                        PackFacelets(cube, record);
+                        record += GetPackedFaceletsSize(CUBE_SIZE);
+                    });
+                    return records;
+                }));
+            }
+            for(size_t block=0; block<num_blocks; ++block) {
+                std::vector<uint8_t> records = blocks[block].get();
+                writer.Append(column, records.data(), records.size() / GetPackedFaceletsSize(CUBE_SIZE));
+            }
+        }
+        writer.Close();
+    } catch(const std::exception &e) {
+        std::cerr << "Error writing " << options.output << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    double elapsed = get_monotonic_time() - start;
+    std::cerr << options.count << " states in " << elapsed << " s (" << options.count / elapsed / 1e6
+              << " M states/s)" << std::endl;
+    return 0;
+}
+
+/**
+  * @brief Applies all the sequences allowed by a generator from a state, depth first
+  * @param state State of the generator
+  * @param naive If true, every move is allowed after any other one (as in START state)
+  * @param nodes Number of nodes visited at each depth
+  */
+template<size_t CUBE_SIZE>
+void EnumerateDepthFirst(RubikCube<int, CUBE_SIZE> &cube, const MoveGenerator<CUBE_SIZE> &generator, size_t state,
+                         size_t depth, size_t max_depth, bool naive, std::vector<uint64_t> &nodes) {
+    ++nodes[depth];
+    if(depth == max_depth)
+        return;
+    const std::vector<typename MoveGenerator<CUBE_SIZE>::Successor> &successors = generator.GetSuccessors(state);
+    for(size_t i=0; i<successors.size(); ++i) {
+        generator.ApplyMove(successors[i].move, cube);
+        EnumerateDepthFirst(cube, generator, naive ? state : successors[i].state, depth+1, max_depth, naive, nodes);
+        generator.UndoMove(successors[i].move, cube);
+    }
+}
+
+/**
+  * @brief Writes the results of enumerate
+  * @param nodes Number of nodes at each depth
+  * @param searched Number of nodes visited by this run. The others were read from a checkpoint
+  * @param elapsed Seconds of the enumeration
+  */
+void WriteEnumerateNodes(const std::vector<uint64_t> &nodes, uint64_t searched, double elapsed) {
+    uint64_t total = 0;
+    for(size_t depth=0; depth<nodes.size(); ++depth) {
+        std::cout << depth << ' ' << nodes[depth] << ' ';
+        if(depth == 0)
+            std::cout << "-\n";
+        else
+            std::cout << (double)nodes[depth] / nodes[depth-1] << '\n';
+        total += nodes[depth];
+    }
+    std::cout.flush();
+    std::cerr << searched << " nodes in " << elapsed << " s (" << searched / elapsed / 1e6 << " M nodes/s)";
+    if(searched != total)
+        std::cerr << ", " << total - searched << " from the checkpoint";
+    std::cerr << std::endl;
+}
+
+/**
+  * @brief Runs the enumerate command. Subtrees of each first move are enumerated in parallel
+  * @return Exit status
+  */
+template<size_t CUBE_SIZE>
+int RunEnumerate(const CtlOptions &options, ThreadPool &pool) {
+    const MoveGenerator<CUBE_SIZE> generator(options.metric);
+    const std::vector<typename MoveGenerator<CUBE_SIZE>::Successor> &first = generator.GetSuccessors(MoveGenerator<CUBE_SIZE>::START);
+    std::vector<std::future<std::vector<uint64_t>>> subtrees;
+    std::vector<uint64_t> nodes(options.max_depth+1, 0);
+    double start = get_monotonic_time();
+
+    nodes[0] = 1;
+    for(size_t i=0; i<first.size() && options.max_depth > 0; ++i) {
+        subtrees.push_back(pool.Submit([&generator, &options, i]() {
+            const typename MoveGenerator<CUBE_SIZE>::Successor &successor =
+                generator.GetSuccessors(MoveGenerator<CUBE_SIZE>::START)[i];
+            RubikCube<int, CUBE_SIZE> cube;
+            std::vector<uint64_t> subtree_nodes(options.max_depth+1, 0);
+            generator.ApplyMove(successor.move, cube);
+            EnumerateDepthFirst(cube, generator, options.naive ? MoveGenerator<CUBE_SIZE>::START : successor.state,
+                                1, options.max_depth, options.naive, subtree_nodes);
+            return subtree_nodes;
+        }));
+    }
+    for(size_t i=0; i<subtrees.size(); ++i) {
+        std::vector<uint64_t> subtree_nodes = subtrees[i].get();
+        for(size_t depth=1; depth<=options.max_depth; ++depth)
+            nodes[depth] += subtree_nodes[depth];
+    }
+
+    WriteEnumerateNodes(nodes, std::accumulate(nodes.begin(), nodes.end(), (uint64_t)0), get_monotonic_time() - start);
+    return 0;
+}
+
+/**
+  * @brief Runs the enumerate command with the cube size selected in options
+  * @return Exit status
+  */
+int RunEnumerate(const CtlOptions &options, ThreadPool &pool) {
+    switch(options.cube_size) {
+    case 2: return RunEnumerate<2>(options, pool);
+    case 3: return RunEnumerate<3>(options, pool);
+    case 4: return RunEnumerate<4>(options, pool);
+    case 5: return RunEnumerate<5>(options, pool);
+    case 6: return RunEnumerate<6>(options, pool);
+    case 7: return RunEnumerate<7>(options, pool);
+    }
+    return 1;
+}
+
+/**
+  * @brief Checks coordinate tables on random states followed by random moves
+  * @param block Number of the random stream
+  * @return Number of mismatches of each coordinate
+  */
+std::vector<uint64_t> CheckCoordinates(const CoordinateTables &tables, const MoveGenerator<3> &generator,
+                                       uint64_t seed, size_t block, size_t num_states, size_t num_moves) {
+    RandomStream random(seed, block);
+    RubikCube<int, 3> cube;
+    FaceElement facelets[NUM_FACELETS3];
+    CubieState3 cubies;
+    unsigned orientation;
+    uint32_t values[NUM_COORDINATES];
+    std::vector<uint64_t> mismatches(NUM_COORDINATES, 0);
+
+    for(size_t i=0; i<num_states; ++i) {
+        RandomizeCube(random, cube);
+        for(size_t move=0; move<=num_moves; ++move) {
+            size_t index = 0;
+            for(int face=0; face<INVALID; ++face)
+                for(size_t row=0; row<3; ++row)
+                    for(size_t col=0; col<3; ++col)
+                        facelets[index++] = cube.GetFaceElement((FaceElement)face, row, col);
+            FaceletsToCubies3(facelets, cubies, orientation);
+            for(int c=0; c<NUM_COORDINATES; ++c) {
+                uint32_t expected = GetCoordinate3(cubies, (Coordinate3)c);
+                if(move > 0)
+                    mismatches[c] += values[c] != expected;
+                // Next lookup starts from the face elements, so each wrong entry is counted once
+                values[c] = expected;
+            }
+            if(move < num_moves) {
+                size_t next = random.NextBelow(NUM_COORDINATE_MOVES);
+                generator.ApplyMove(next, cube);
+                for(int c=0; c<NUM_COORDINATES; ++c)
+                    values[c] = tables.Move((Coordinate3)c, values[c], next);
+            }
+        }
+    }
+    return mismatches;
+}
+
+/**
+  * @brief Reads the coordinate tables of --tables, or generates them if it is not given
+  * @throw std::runtime_error as LoadCoordinateTables
+  */
+std::unique_ptr<CoordinateTables> GetCoordinateTables(const CtlOptions &options, ThreadPool &pool) {
+    if(options.tables.empty())
+        return std::unique_ptr<CoordinateTables>(new CoordinateTables(pool));
+    return std::unique_ptr<CoordinateTables>(new CoordinateTables(LoadCoordinateTables(options.tables, pool)));
+}
+
+/**
+  * @brief Runs the coordinates command
+  * @return Exit status
+  */
+int RunCoordinates(const CtlOptions &options, ThreadPool &pool) {
+    const MoveGenerator<3> generator(FACE_TURN_METRIC);
+    std::vector<std::future<std::vector<uint64_t>>> batches;
+    std::vector<uint64_t> mismatches(NUM_COORDINATES, 0);
+    uint64_t total = 0;
+    double start = get_monotonic_time();
+
+    std::unique_ptr<CoordinateTables> tables;
+    try {
+        tables = GetCoordinateTables(options, pool);
+    } catch(const std::exception &e) {
+        std::cerr << "Error building coordinate tables: " << e.what() << std::endl;
+        return 1;
+    }
+    double elapsed = get_monotonic_time() - start;
+    std::cerr << "Coordinate tables ready in " << elapsed << " s" << std::endl;
+
+    for(size_t block=0; block*COORDINATES_BATCH_SIZE < options.count; ++block) {
+        size_t num_states = std::min(COORDINATES_BATCH_SIZE, options.count - block*COORDINATES_BATCH_SIZE);
+        batches.push_back(pool.Submit([&tables, &generator, &options, block, num_states]() {
+            return CheckCoordinates(*tables, generator, options.seed, block, num_states, options.max_depth);
+        }));
+    }
+    for(size_t i=0; i<batches.size(); ++i) {
+        std::vector<uint64_t> batch = batches[i].get();
+        for(int c=0; c<NUM_COORDINATES; ++c)
+            mismatches[c] += batch[c];
+    }
+
+    for(int c=0; c<NUM_COORDINATES; ++c) {
+        std::cout << GetCoordinateName((Coordinate3)c) << ' ' << COORDINATE_SIZES[c] << ' ' << mismatches[c] << '\n';
+        total += mismatches[c];
+    }
+    std::cout.flush();
+    return total == 0 ? 0 : 1;
+}
+
+/**
+  * @brief Optimizes all lines of a stream, one after the other
+  * @param totals Statistics of all the lines, which are increased
+  */
+template<size_t CUBE_SIZE>
+void OptimizeStream(std::istream &is, const CtlOptions &options, ThreadPool &pool, PeepholeStats &totals) {
+    std::string line;
+    while(std::getline(is, line)) {
+        if(line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+        std::vector<Move> moves;
+        PeepholeStats stats;
+        try {
+            moves = ParseMoves(line, CUBE_SIZE);
+        } catch(const std::invalid_argument &e) {
+            std::cout << "error: " << e.what() << std::endl;
+            continue;
+        }
+        std::cout << MovesToString(OptimizeMoves<CUBE_SIZE>(moves, options.window, pool, &stats)) << std::endl;
+        std::cerr << "length " << stats.original_length << " -> " << stats.optimized_length << " passes "
+                  << stats.passes << " windows " << stats.windows << " latency " << stats.latency << std::endl;
+        totals.original_length += stats.original_length;
+        totals.optimized_length += stats.optimized_length;
+        totals.windows += stats.windows;
+        totals.latency += stats.latency;
+    }
+}
+
+/**
+  * @brief Runs the optimize command
+  * @return Exit status
+  */
+template<size_t CUBE_SIZE>
+int RunOptimize(const CtlOptions &options, ThreadPool &pool) {
+    PeepholeStats totals;
+    if(options.files.empty()) {
+        OptimizeStream<CUBE_SIZE>(std::cin, options, pool, totals);
+    } else {
+        for(size_t i=0; i<options.files.size(); ++i) {
+            std::ifstream file(options.files[i]);
+            if(!file) {
+                std::cerr << "Error opening " << options.files[i] << std::endl;
+                return 1;
+            }
+            OptimizeStream<CUBE_SIZE>(file, options, pool, totals);
+        }
+    }
+    std::cerr << "Total length " << totals.original_length << " -> " << totals.optimized_length << " ("
+              << (totals.original_length - totals.optimized_length) * 100.0 / std::max<size_t>(totals.original_length, 1)
+              << "% shorter), " << totals.windows << " windows in " << totals.latency << " s" << std::endl;
+    return 0;
+}
+
+/**
+  * @brief Runs the optimize command with the cube size selected in options
+  */
+int RunOptimize(const CtlOptions &options, ThreadPool &pool) {
+    switch(options.cube_size) {
+    case 2: return RunOptimize<2>(options, pool);
+    case 3: return RunOptimize<3>(options, pool);
+    case 4: return RunOptimize<4>(options, pool);
+    case 5: return RunOptimize<5>(options, pool);
+    case 6: return RunOptimize<6>(options, pool);
+    case 7: return RunOptimize<7>(options, pool);
+    }
+    return 1;
+}
+
+/**
+  * @brief Runs the dataset command
+  * @return Exit status
+  */
+template<size_t CUBE_SIZE>
+int RunDataset(const CtlOptions &options, ThreadPool &pool) {
+    DatasetOptions dataset;
+    DatasetStats stats;
+    dataset.prefix = options.output;
+    dataset.seed = options.seed;
+    dataset.num_samples = options.count;
+    dataset.shard_size = options.shard_size;
+    dataset.encoding = options.encoding;
+    dataset.depth_weights = options.depth_weights;
+    if(dataset.depth_weights.empty())
+        dataset.depth_weights.assign(options.max_depth + 1, 1.0);
+
+    try {
+        stats = WriteDataset<CUBE_SIZE>(dataset, pool);
+    } catch(const std::exception &e) {
+        std::cerr << "Error writing dataset " << options.output << ": " << e.what() << std::endl;
+        return 1;
+    }
+    std::cerr << stats.num_samples << " samples of " << stats.tensor_size << " bytes in " << stats.num_shards
+              << " shards, " << stats.latency << " s (" << stats.num_samples / stats.latency / 1e6
+              << " M samples/s)" << std::endl;
+    return 0;
+}
+
+/**
+  * @brief Runs the dataset command with the cube size selected in options
+  */
+int RunDataset(const CtlOptions &options, ThreadPool &pool) {
+    switch(options.cube_size) {
+    case 2: return RunDataset<2>(options, pool);
+    case 3: return RunDataset<3>(options, pool);
+    case 4: return RunDataset<4>(options, pool);
+    case 5: return RunDataset<5>(options, pool);
+    case 6: return RunDataset<6>(options, pool);
+    case 7: return RunDataset<7>(options, pool);
+    }
+    return 1;
+}
+
+/**
+  * @brief Runs the pruning command
+  * @return Exit status
+  */
+int RunPruning(const CtlOptions &options, ThreadPool &pool) {
+    std::unique_ptr<CoordinateTables> coordinates;
+    std::vector<uint64_t> checksums;
+    try {
+        coordinates = GetCoordinateTables(options, pool);
+    } catch(const std::exception &e) {
+        std::cerr << "Error building coordinate tables: " << e.what() << std::endl;
+        return 1;
+    }
+
+    for(int layout=0; layout<NUM_PRUNING_LAYOUTS; ++layout) {
+        for(int huge_pages=1; huge_pages>=0; --huge_pages) {
+            size_t huge_page_memory = get_huge_page_memory();
+            double start = get_monotonic_time();
+            PruningTables tables(*coordinates, pool, (PruningLayout)layout, huge_pages);
+            double elapsed = get_monotonic_time() - start;
+            huge_page_memory = std::max(get_huge_page_memory(), huge_page_memory) - huge_page_memory;
+
+            // Each entry depends on the last one, so lookups wait for memory instead of overlapping. Distances
+            // modulo 3 are the same in every layout, so all of them look up the same entries
+            uint64_t hash = options.seed;
+            uint64_t checksum = 0;
+            uint8_t residue = 0;
+            start = get_monotonic_time();
+            for(size_t i=0; i<PRUNING_REPORT_LOOKUPS; ++i) {
+                size_t table = i % NUM_PRUNING_TABLES;
+                hash = ZobristMix(hash + residue);
+                residue = tables.GetValue(table, hash % PruningTables::GetSize(table));
+                if(layout != MOD3_PRUNING)
+                    residue %= 3;
+                checksum += residue;
+            }
+            double lookup = (get_monotonic_time() - start) / PRUNING_REPORT_LOOKUPS;
+            checksums.push_back(checksum);
+
+            std::cout << GetPruningLayoutName((PruningLayout)layout) << ' ' << (huge_pages ? "on" : "off") << ' '
+                      << tables.GetMemoryUsage() << ' ' << huge_page_memory << ' ' << lookup * 1e9 << std::endl;
+            std::cerr << GetPruningLayoutName((PruningLayout)layout) << " tables built in " << elapsed << " s"
+                      << std::endl;
+        }
+    }
+    if(std::count(checksums.begin(), checksums.end(), checksums[0]) != (long)checksums.size()) {
+        std::cerr << "Layouts have different distances" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/*    Sequence of moves of a generator which leads to a shard    */
+struct ShardPrefix {
+    std::vector<size_t> moves;
+    size_t state;
+};
+
+/**
+  * @brief Finds the sequences of a given length a generator allows, in the order they are enumerated
+  * @param naive If true, every move is allowed after any other one
+  * @param nodes Number of sequences shorter than the prefixes, by length, which is increased
+  */
+template<size_t CUBE_SIZE>
+void GetShardPrefixes(const MoveGenerator<CUBE_SIZE> &generator, size_t state, bool naive, size_t length,
+                      ShardPrefix &prefix, std::vector<ShardPrefix> &prefixes, std::vector<uint64_t> &nodes) {
+    if(prefix.moves.size() == length) {
+        prefix.state = state;
+        prefixes.push_back(prefix);
+        return;
+    }
+    ++nodes[prefix.moves.size()];
+    const std::vector<typename MoveGenerator<CUBE_SIZE>::Successor> &successors = generator.GetSuccessors(state);
+    for(size_t i=0; i<successors.size(); ++i) {
+        prefix.moves.push_back(successors[i].move);
+        GetShardPrefixes(generator, naive ? state : successors[i].state, naive, length, prefix, prefixes, nodes);
+        prefix.moves.pop_back();
+    }
+}
+
+/**
+  * @brief Enumeration of a shard, as EnumerateDepthFirst, which stops if the shard is cancelled
+  * @param visited Number of visited nodes, which is increased
+  * @param stop Set once the shard is cancelled
+  */
+template<size_t CUBE_SIZE>
+void EnumerateShard(RubikCube<int, CUBE_SIZE> &cube, const MoveGenerator<CUBE_SIZE> &generator, size_t state,
+                    size_t depth, size_t max_depth, bool naive, const std::function<bool()> &cancelled,
+                    std::vector<uint64_t> &nodes, uint64_t &visited, bool &stop) {
+    if(++visited % SHARD_POLL_NODES == 0)
+        stop = cancelled();
+    if(stop)
+        return;
+    ++nodes[depth];
+    if(depth == max_depth)
+        return;
+    const std::vector<typename MoveGenerator<CUBE_SIZE>::Successor> &successors = generator.GetSuccessors(state);
+    for(size_t i=0; i<successors.size() && !stop; ++i) {
+        generator.ApplyMove(successors[i].move, cube);
+        EnumerateShard(cube, generator, naive ? state : successors[i].state, depth+1, max_depth, naive, cancelled,
+                       nodes, visited, stop);
+        generator.UndoMove(successors[i].move, cube);
+    }
+}
+
+/**
+  * @brief Runs the enumerate command in worker processes. Each shard enumerates the subtree of a prefix
+  * @return Exit status
+  */
+template<size_t CUBE_SIZE>
+int RunShardedEnumerate(const CtlOptions &options) {
+    const MoveGenerator<CUBE_SIZE> generator(options.metric);
+    const size_t prefix_length = std::min(options.shard_depth, options.max_depth);
+    std::vector<ShardPrefix> prefixes;
+    std::vector<uint64_t> nodes(options.max_depth+1, 0);
+    std::vector<std::string> tasks;
+    ShardPrefix prefix;
+    double start = get_monotonic_time();
+
+    GetShardPrefixes(generator, MoveGenerator<CUBE_SIZE>::START, options.naive, prefix_length, prefix, prefixes, nodes);
+    uint64_t searched = std::accumulate(nodes.begin(), nodes.end(), (uint64_t)0);
+    for(size_t i=0; i<prefixes.size(); ++i)
+        tasks.push_back(std::to_string(i));
+
+    // Results are the nodes of the subtree at each depth, from the prefix length
+    ShardFunction function = [&generator, &prefixes, &options](const std::string &task, const std::function<bool()> &cancelled) {
+        const ShardPrefix &prefix = prefixes.at(std::stoul(task));
+        RubikCube<int, CUBE_SIZE> cube;
+        std::vector<uint64_t> subtree_nodes(options.max_depth+1, 0);
+        std::string result;
+        uint64_t visited = 0;
+        bool stop = false;
+        for(size_t i=0; i<prefix.moves.size(); ++i)
+            generator.ApplyMove(prefix.moves[i], cube);
+        // The result of a cancelled shard is discarded, so it doesn't matter that its counts are partial
+        EnumerateShard(cube, generator, prefix.state, prefix.moves.size(), options.max_depth, options.naive, cancelled,
+                       subtree_nodes, visited, stop);
+        for(size_t depth=prefix.moves.size(); depth<=options.max_depth; ++depth)
+            result += std::to_string(subtree_nodes[depth]) + (depth < options.max_depth ? " " : "");
+        return result;
+    };
+
+    try {
+        ShardCoordinator coordinator(options.num_workers, function);
+        std::string job = "enumerate size " + std::to_string(CUBE_SIZE) + " metric " + std::to_string(options.metric) +
+                          " naive " + std::to_string(options.naive) + " max-depth " + std::to_string(options.max_depth) +
+                          " shard-depth " + std::to_string(prefix_length);
+        coordinator.Run(job, tasks, [&nodes, &searched, prefix_length](size_t, const std::string &result, bool checkpointed) {
+            std::istringstream stream(result);
+            for(size_t depth=prefix_length; depth<nodes.size(); ++depth) {
+                uint64_t count = 0;
+                stream >> count;
+                nodes[depth] += count;
+                if(!checkpointed)
+                    searched += count;
+            }
+            return true;
+        }, options.checkpoint);
+    } catch(const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    WriteEnumerateNodes(nodes, searched, get_monotonic_time() - start);
+    return 0;
+}
+
+/**
+  * @brief Depth-limited search of a shard, as SolveDepthLimited, which stops if the shard is cancelled
+  * @param nodes Number of searched nodes, which is increased
+  * @param stop Set once the shard is cancelled
+  */
+template<size_t CUBE_SIZE>
+bool SolveShard(RubikCube<int, CUBE_SIZE> &cube, const MoveGenerator<CUBE_SIZE> &generator, size_t state,
+                size_t remaining, std::vector<Move> &path, const std::function<bool()> &cancelled,
+                uint64_t &nodes, bool &stop) {
+    if(++nodes % SHARD_POLL_NODES == 0)
+        stop = cancelled();
+    if(stop)
+        return false;
+    if(cube.IsSolved())
+        return true;
+    if(remaining == 0)
+        return false;
+
+    const std::vector<typename MoveGenerator<CUBE_SIZE>::Successor> &successors = generator.GetSuccessors(state);
+    size_t path_size = path.size();
+    for(size_t i=0; i<successors.size(); ++i) {
+        generator.ApplyMove(successors[i].move, cube);
+        generator.AppendMove(successors[i].move, path);
+        if(SolveShard(cube, generator, successors[i].state, remaining-1, path, cancelled, nodes, stop))
+            return true;
+        path.resize(path_size);
+        generator.UndoMove(successors[i].move, cube);
+    }
+    return false;
+}
+
+/**
+  * @brief Solves all lines of a stream with the shards of the workers, one line after the other
+  * @param num_prefixes Number of prefixes of the workers
+  */
+template<size_t CUBE_SIZE>
+void SolveShardedStream(std::istream &is, const CtlOptions &options, ShardCoordinator &coordinator,
+                        size_t num_prefixes) {
+    const MoveGenerator<CUBE_SIZE> generator(QUARTER_TURN_METRIC);
+    std::string line;
+
+    while(std::getline(is, line)) {
+        if(line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+        RubikCube<int, CUBE_SIZE> cube;
+        std::vector<Move> solution;
+        std::string result = "unsolved";
+        try {
+            if(line.find('|') != std::string::npos)
+                throw std::invalid_argument("Unexpected '|'");
+            std::vector<Move> moves = ParseMoves(line, CUBE_SIZE);
+            for(size_t i=0; i<moves.size(); ++i)
+                cube.RotateFace(moves[i]);
+        } catch(const std::invalid_argument &e) {
+            std::cout << "error: " << e.what() << std::endl;
+            continue;
+        }
+
+        for(size_t depth=0; depth<=options.max_depth && result == "unsolved"; ++depth) {
+            if(depth < options.shard_depth) {
+                RubikCube<int, CUBE_SIZE> state = cube;
+                if(SolveDepthLimited(state, generator, MoveGenerator<CUBE_SIZE>::START, depth, solution))
+                    result = MovesToString(solution);
+                solution.clear();
+                continue;
+            }
+            std::vector<std::string> tasks;
+            for(size_t i=0; i<num_prefixes; ++i)
+                tasks.push_back(std::to_string(i) + " " + std::to_string(depth) + " " + line);
+            std::string job = "solve size " + std::to_string(CUBE_SIZE) + " depth " + std::to_string(depth) +
+                              " shard-depth " + std::to_string(options.shard_depth) + " " + line;
+            // Shards may finish in any order, so the job only stops once the ones before the first shard with a
+            // solution are done. The solution is then the one a search in a single process finds
+            std::vector<bool> done(num_prefixes, false);
+            size_t first = num_prefixes;
+            size_t num_done = 0;
+            coordinator.Run(job, tasks, [&](size_t index, const std::string &shard_result, bool) {
+                done[index] = true;
+                if(shard_result != "none" && index < first) {
+                    first = index;
+                    result = shard_result;
+                }
+                while(num_done < first && done[num_done])
+                    ++num_done;
+                return num_done < first;
+            }, options.checkpoint);
+        }
+        std::cout << result << std::endl;
+    }
+}
+
+/**
+  * @brief Runs the solve command in worker processes. Lines are solved one after the other, by iterative
+  *        deepening: for each depth, each shard searches the solutions which start with a prefix, and the
+  *        solution of the first shard in order cancels the others. Shorter depths than the prefixes are searched here
+  * @return Exit status
+  */
+template<size_t CUBE_SIZE>
+int RunShardedSolve(const CtlOptions &options) {
+    const MoveGenerator<CUBE_SIZE> generator(QUARTER_TURN_METRIC);
+    std::vector<ShardPrefix> prefixes;
+    std::vector<uint64_t> nodes(options.shard_depth, 0);
+    ShardPrefix prefix;
+
+    GetShardPrefixes(generator, MoveGenerator<CUBE_SIZE>::START, false, options.shard_depth, prefix, prefixes, nodes);
+
+    // Tasks are "<prefix> <depth> <scramble>". Results are the solution, or "none"
+    ShardFunction function = [&generator, &prefixes](const std::string &task, const std::function<bool()> &cancelled) {
+        std::istringstream stream(task);
+        size_t index;
+        size_t depth;
+        std::string scramble;
+        RubikCube<int, CUBE_SIZE> cube;
+        std::vector<Move> path;
+        uint64_t nodes = 0;
+        bool stop = false;
+        stream >> index >> depth;
+        std::getline(stream, scramble);
+        std::vector<Move> moves = ParseMoves(scramble, CUBE_SIZE);
+        for(size_t i=0; i<moves.size(); ++i)
+            cube.RotateFace(moves[i]);
+        const ShardPrefix &prefix = prefixes.at(index);
+        for(size_t i=0; i<prefix.moves.size(); ++i) {
+            generator.ApplyMove(prefix.moves[i], cube);
+            generator.AppendMove(prefix.moves[i], path);
+        }
+        if(!SolveShard(cube, generator, prefix.state, depth - prefix.moves.size(), path, cancelled, nodes, stop))
+            return std::string("none");
+        return MovesToString(path);
+    };
+
+    try {
+        ShardCoordinator coordinator(options.num_workers, function);
+        if(options.files.empty()) {
+            SolveShardedStream<CUBE_SIZE>(std::cin, options, coordinator, prefixes.size());
+        } else {
+            for(size_t i=0; i<options.files.size(); ++i) {
+                std::ifstream file(options.files[i]);
+                if(!file) {
+                    std::cerr << "Error opening " << options.files[i] << std::endl;
+                    return 1;
+                }
+                SolveShardedStream<CUBE_SIZE>(file, options, coordinator, prefixes.size());
+            }
+        }
+    } catch(const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+  * @brief Runs solve or enumerate in worker processes, with the cube size selected in options
+  * @pre No threads have been created
+  * @return Exit status
+  */
+int RunSharded(const CtlOptions &options) {
+    bool solve = options.command == "solve";
+    switch(options.cube_size) {
+    case 2: return solve ? RunShardedSolve<2>(options) : RunShardedEnumerate<2>(options);
+    case 3: return solve ? RunShardedSolve<3>(options) : RunShardedEnumerate<3>(options);
+    case 4: return solve ? RunShardedSolve<4>(options) : RunShardedEnumerate<4>(options);
+    case 5: return solve ? RunShardedSolve<5>(options) : RunShardedEnumerate<5>(options);
+    case 6: return solve ? RunShardedSolve<6>(options) : RunShardedEnumerate<6>(options);
+    case 7: return solve ? RunShardedSolve<7>(options) : RunShardedEnumerate<7>(options);
+    }
+    return 1;
+}
+
+/**
+  * @brief Runs the verify command
+  * @return Exit status
+  */
+int RunVerify(const CtlOptions &options, ThreadPool &pool) {
+    std::deque<std::future<VerifyBatch>> pending;
+    VerifyBatch totals;
+    double start = get_monotonic_time();
+
+    if(options.files.empty()) {
+        VerifyStream(std::cin, options, pool, pending, totals);
+    } else {
+        for(size_t i=0; i<options.files.size(); ++i) {
+            std::ifstream file(options.files[i]);
+            if(!file) {
+                std::cerr << "Error opening " << options.files[i] << std::endl;
+                return 1;
+            }
+            VerifyStream(file, options, pool, pending, totals);
+        }
+    }
+    while(!pending.empty())
+        WriteVerifyBatch(pending, totals);
+    std::cout.flush();
+
+    double elapsed = get_monotonic_time() - start;
+    std::cerr << totals.num_lines << " solutions: " << totals.num_ok << " ok, "
+              << totals.num_lines - totals.num_ok - totals.num_errors << " failed, " << totals.num_errors
+              << " errors. " << totals.num_moves << " moves in " << elapsed << " s ("
+              << totals.num_moves / elapsed / 1e6 << " M moves/s)" << std::endl;
+    if(totals.num_hits + totals.num_misses > 0)
+        std::cerr << "Cache: " << totals.num_hits << " hits, " << totals.num_misses << " misses ("
+                  << 100.0 * totals.num_hits / (totals.num_hits + totals.num_misses) << "% hits)" << std::endl;
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    CtlOptions options;
+    std::deque<std::future<LineResult>> pending;
+    std::unique_ptr<CoordinateTables> coordinate_tables;
+    std::unique_ptr<PruningTables> pruning_tables;
+    std::unique_ptr<IDAStarSolver3> ida;
+    std::unique_ptr<TranspositionTable> transpositions;
+
+    if(!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::ios::sync_with_stdio(false);
+    // Worker processes are created before any thread
+    if(options.num_workers > 0)
+        return RunSharded(options);
+    ThreadPool pool(options.num_threads);
+    if(options.command == "random")
+        return options.cube_size == 2 ? RunRandom<2>(options, pool) : RunRandom<3>(options, pool);
+    if(options.command == "verify")
+        return RunVerify(options, pool);
+    if(options.command == "enumerate")
+        return RunEnumerate(options, pool);
+    if(options.command == "coordinates")
+        return RunCoordinates(options, pool);
+    if(options.command == "pruning")
+        return RunPruning(options, pool);
+    if(options.command == "optimize")
+        return RunOptimize(options, pool);
+    if(options.command == "dataset")
+        return RunDataset(options, pool);
+    if(options.solver == "ida" && options.command != "apply" && options.command != "canonical") {
+        double start = get_monotonic_time();
+        try {
+            coordinate_tables = GetCoordinateTables(options, pool);
+            pruning_tables.reset(new PruningTables(*coordinate_tables, pool, options.layout));
+        } catch(const std::exception &e) {
+            std::cerr << "Error building pruning tables: " << e.what() << std::endl;
+            return 1;
+        }
+        ida.reset(new IDAStarSolver3(*coordinate_tables, *pruning_tables));
+        std::cerr << "Pruning tables ready in " << get_monotonic_time() - start << " s ("
+                  << pruning_tables->GetMemoryUsage() << " bytes)" << std::endl;
+    }
+    if(options.transpositions > 0 && options.command != "apply" && options.command != "canonical")
+        transpositions.reset(new TranspositionTable(options.transpositions));
+    if(options.files.empty()) {
+        ProcessStream(std::cin, options, ida.get(), transpositions.get(), pool, pending);
+    } else {
+        for(size_t i=0; i<options.files.size(); ++i) {
+            std::ifstream file(options.files[i]);
+            if(!file) {
+                std::cerr << "Error opening " << options.files[i] << std::endl;
+                return 1;
+            }
+            ProcessStream(file, options, ida.get(), transpositions.get(), pool, pending);
+        }
+    }
+
+    while(!pending.empty())
+        WriteLineResult(pending);
+    std::cout.flush();
+
+    return 0;
+}
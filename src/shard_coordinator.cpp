@@ -0,0 +1,278 @@
+#include <shard_coordinator.h>
+#include <zobrist.h>
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cerrno>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+/**
+  * @brief Writes a line to a socket
+  * @return False if the peer closed the socket
+  */
+static bool SendLine(int fd, const std::string &line) {
+    std::string message = line + '\n';
+    size_t sent = 0;
+    while(sent < message.size()) {
+        // The peer may have exited: errors are returned instead of raising SIGPIPE
+        ssize_t result = send(fd, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+        if(result < 0 && errno == EINTR)
+            continue;
+        if(result <= 0)
+            return false;
+        sent += result;
+    }
+    return true;
+}
+
+/**
+  * @brief Reads from a socket until there is a whole line in 'buffer'
+  * @param line Output line, without end of line. It is removed from 'buffer'
+  * @return False if the peer closed the socket
+  */
+static bool ReadLine(int fd, std::string &buffer, std::string &line) {
+    char data[4096];
+    size_t end;
+    while((end = buffer.find('\n')) == std::string::npos) {
+        ssize_t result = read(fd, data, sizeof(data));
+        if(result < 0 && errno == EINTR)
+            continue;
+        if(result <= 0)
+            return false;
+        buffer.append(data, result);
+    }
+    line = buffer.substr(0, end);
+    buffer.erase(0, end+1);
+    return true;
+}
+
+/**
+  * @brief Returns the identifier of the records of a job in checkpoints
+  */
+static std::string GetJobHash(const std::string &job) {
+    uint64_t hash = ZOBRIST_SEED;
+    char text[17];
+    for(size_t i=0; i<job.size(); ++i)
+        hash = ZobristMix(hash ^ (unsigned char)job[i]);
+    snprintf(text, sizeof(text), "%016llx", (unsigned long long)hash);
+    return text;
+}
+
+/**
+  * @brief Splits a message as "<word> <index> <rest>"
+  * @return False if the message doesn't have that form
+  */
+static bool ParseMessage(const std::string &message, std::string &word, size_t &index, std::string &rest) {
+    std::istringstream stream(message);
+    if(!(stream >> word >> index))
+        return false;
+    if(stream.peek() == ' ')
+        stream.get();
+    std::getline(stream, rest);
+    return true;
+}
+
+ShardCoordinator::ShardCoordinator(size_t num_workers, ShardFunction function) {
+    if(num_workers == 0)
+        throw std::invalid_argument("Sharded searches need worker processes");
+    for(size_t i=0; i<num_workers; ++i) {
+        int fds[2];
+        if(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+            Shutdown();
+            throw std::runtime_error("Error creating the socket of a worker");
+        }
+        pid_t pid = fork();
+        if(pid < 0) {
+            close(fds[0]);
+            close(fds[1]);
+            Shutdown();
+            throw std::runtime_error("Error creating a worker process");
+        }
+        if(pid == 0) {
+            // Sockets of the other workers are closed, so they see the coordinator exit
+            close(fds[0]);
+            for(size_t j=0; j<workers.size(); ++j)
+                close(workers[j].fd);
+            WorkerLoop(fds[1], function);
+            _exit(0);
+        }
+        close(fds[1]);
+        workers.push_back({pid, fds[0], "", -1});
+    }
+}
+
+ShardCoordinator::~ShardCoordinator() {
+    Shutdown();
+}
+
+void ShardCoordinator::WorkerLoop(int fd, const ShardFunction &function) {
+    std::string buffer;
+    std::string line;
+
+    while(ReadLine(fd, buffer, line)) {
+        std::string word;
+        std::string task;
+        size_t index;
+        bool cancelled = false;
+        if(line == "quit")
+            break;
+        // Cancellations of shards which were already done are ignored
+        if(!ParseMessage(line, word, index, task) || word != "shard")
+            continue;
+
+        std::function<bool()> check = [fd, &buffer, &cancelled]() {
+            struct pollfd request = {fd, POLLIN, 0};
+            char data[4096];
+            while(!cancelled && poll(&request, 1, 0) > 0) {
+                ssize_t result = read(fd, data, sizeof(data));
+                // A closed coordinator cancels the shard too
+                if(result <= 0) {
+                    cancelled = result == 0 || errno != EINTR;
+                    break;
+                }
+                buffer.append(data, result);
+                cancelled = buffer.find("cancel\n") != std::string::npos;
+            }
+            return cancelled;
+        };
+        std::string reply;
+        try {
+            reply = "result " + std::to_string(index) + " " + function(task, check);
+        } catch(const std::exception &e) {
+            reply = "error " + std::to_string(index) + " " + e.what();
+        }
+        if(cancelled) {
+            size_t position = buffer.find("cancel\n");
+            if(position != std::string::npos)
+                buffer.erase(0, position + 7);
+            reply = "cancelled " + std::to_string(index);
+        }
+        if(!SendLine(fd, reply))
+            break;
+    }
+    close(fd);
+}
+
+std::string ShardCoordinator::ReceiveLine(Worker &worker) {
+    std::string line;
+    if(!ReadLine(worker.fd, worker.buffer, line))
+        throw std::runtime_error("Worker process " + std::to_string(worker.pid) + " exited");
+    return line;
+}
+
+void ShardCoordinator::Shutdown() {
+    for(size_t i=0; i<workers.size(); ++i) {
+        SendLine(workers[i].fd, "quit");
+        close(workers[i].fd);
+    }
+    for(size_t i=0; i<workers.size(); ++i)
+        waitpid(workers[i].pid, nullptr, 0);
+    workers.clear();
+}
+
+size_t ShardCoordinator::GetNumWorkers() const {
+    return workers.size();
+}
+
+bool ShardCoordinator::Run(const std::string &job, const std::vector<std::string> &tasks,
+                           const ShardResultFunction &on_result, const std::string &checkpoint) {
+    std::string job_hash = GetJobHash(job);
+    std::vector<bool> done(tasks.size(), false);
+    FILE *file = nullptr;
+    size_t next = 0;
+    size_t running = 0;
+    bool stopped = false;
+
+    if(!checkpoint.empty()) {
+        std::ifstream input(checkpoint);
+        std::string contents((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        std::istringstream lines(contents.substr(0, contents.rfind('\n') + 1));
+        std::string line;
+        // A job killed while writing may leave a partial last line, which is skipped
+        while(std::getline(lines, line) && !stopped) {
+            std::string hash;
+            std::string result;
+            size_t index;
+            if(ParseMessage(line, hash, index, result) && hash == job_hash && index < tasks.size() && !done[index]) {
+                done[index] = true;
+                stopped = !on_result(index, result, true);
+            }
+        }
+        if(stopped)
+            return false;
+        file = fopen(checkpoint.c_str(), "a");
+        if(!file)
+            throw std::runtime_error("Error opening " + checkpoint);
+        if(!contents.empty() && contents.back() != '\n')
+            fputc('\n', file);
+    }
+
+    try {
+        while(true) {
+            for(size_t i=0; i<workers.size() && !stopped; ++i) {
+                while(next < tasks.size() && done[next])
+                    ++next;
+                if(workers[i].shard >= 0 || next >= tasks.size())
+                    continue;
+                if(!SendLine(workers[i].fd, "shard " + std::to_string(next) + " " + tasks[next]))
+                    throw std::runtime_error("Worker process " + std::to_string(workers[i].pid) + " exited");
+                workers[i].shard = next++;
+                ++running;
+            }
+            if(running == 0)
+                break;
+
+            // Only busy workers are waited for: an idle one which exits is found when it gets a shard
+            std::vector<struct pollfd> requests;
+            std::vector<size_t> busy;
+            for(size_t i=0; i<workers.size(); ++i) {
+                if(workers[i].shard >= 0) {
+                    requests.push_back({workers[i].fd, POLLIN, 0});
+                    busy.push_back(i);
+                }
+            }
+            if(poll(requests.data(), requests.size(), -1) < 0 && errno != EINTR)
+                throw std::runtime_error("Error waiting for the workers");
+
+            for(size_t k=0; k<busy.size(); ++k) {
+                Worker &worker = workers[busy[k]];
+                if(!(requests[k].revents & (POLLIN | POLLHUP | POLLERR)))
+                    continue;
+                std::string word;
+                std::string result;
+                size_t index;
+                if(!ParseMessage(ReceiveLine(worker), word, index, result) || index != (size_t)worker.shard)
+                    throw std::runtime_error("Unexpected message of worker process " + std::to_string(worker.pid));
+                worker.shard = -1;
+                --running;
+                if(word == "error")
+                    throw std::runtime_error("Shard " + std::to_string(index) + " failed: " + result);
+                if(word != "result")
+                    continue;
+
+                // Results which arrive after a stop are still recorded, but not received
+                done[index] = true;
+                if(file && (fprintf(file, "%s %zu %s\n", job_hash.c_str(), index, result.c_str()) < 0 || fflush(file) != 0))
+                    throw std::runtime_error("Error writing " + checkpoint);
+                if(!stopped && !on_result(index, result, false)) {
+                    stopped = true;
+                    for(size_t j=0; j<workers.size(); ++j)
+                        if(workers[j].shard >= 0)
+                            SendLine(workers[j].fd, "cancel");
+                }
+            }
+        }
+    } catch(...) {
+        if(file)
+            fclose(file);
+        throw;
+    }
+
+    if(file && fclose(file) != 0)
+        throw std::runtime_error("Error writing " + checkpoint);
+    return !stopped;
+}
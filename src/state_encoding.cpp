@@ -0,0 +1,399 @@
+#include <state_encoding.h>
+#include <array>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+/*    Whole cube orientations    */
+static const size_t NUM_ORIENTATIONS = 24;
+
+/*    Sizes of coordinates    */
+static const uint64_t CORNER_PERMUTATIONS = 40320;        // 8!
+static const uint64_t CORNER_ORIENTATIONS = 2187;         // 3^7
+static const uint64_t EDGE_PERMUTATIONS = 239500800;      // 12!/2
+static const uint64_t EDGE_ORIENTATIONS = 2048;           // 2^11
+// Edge coordinates are packed in the low bits, and the other ones above them. 32 + 39 bits
+static const int EDGE_BITS = 39;
+
+/**
+  * Positions of the pieces of a 3x3 cube, as indices of face elements (see FaceletsToString).
+  * The first face element of each piece is its orientation reference: TOP or BOTTOM for corners,
+  * TOP or BOTTOM, else FRONT or BACK for edges. The other face elements of corners follow the same
+  * rotation sense in all the corners, so twists of a valid state add up to a multiple of 3.
+  * A piece is identified by the colors of its position in the solved cube.
+  */
+struct CubieLayout {
+    std::array<std::array<uint8_t, 3>, NUM_CORNERS3> corners;
+    std::array<std::array<uint8_t, 2>, NUM_EDGES3> edges;
+    // Face of each face element, which is its color in the solved cube
+    std::array<uint8_t, NUM_FACELETS3> faces;
+    // Piece whose colors are a set of faces (bit mask of FaceElement). -1 if there is no such piece
+    std::array<int8_t, 64> corner_by_colors;
+    std::array<int8_t, 64> edge_by_colors;
+    // Face elements moved by each whole cube orientation: oriented[i] = solved[permutations[o][i]]
+    std::array<std::array<uint8_t, NUM_FACELETS3>, NUM_ORIENTATIONS> permutations;
+    // Orientation from the centers of FRONT and TOP faces. -1 if they are not adjacent
+    std::array<int8_t, INVALID*INVALID> orientation_by_centers;
+};
+
+/**
+  * @brief Returns index of a face element, in the order of FaceletsToString
+  */
+static size_t GetFaceletIndex(FaceElement face, size_t row, size_t col) {
+    return ((size_t)face*3 + row)*3 + col;
+}
+
+/**
+  * @brief Computes the layout of the pieces of a 3x3 cube
+  */
+static CubieLayout BuildCubieLayout() {
+    CubieLayout layout;
+    std::vector<std::array<int, 3>> corner_positions;
+    std::vector<std::array<int, 3>> edge_positions;
+    std::vector<std::array<int, 3>> positions;
+    std::vector<int> axes;
+
+    // Position of the piece of each face element, and axis of the face element
+    for(size_t i=0; i<NUM_FACELETS3; ++i) {
+        int location[3];
+        std::array<int, 3> position;
+        int axis = 0;
+        GetFaceletLocation((FaceElement)(i/9), i/3%3, i%3, 3, location);
+        for(int j=0; j<3; ++j) {
+            position[j] = location[j] / 2;
+            if(location[j] == 3 || location[j] == -3)
+                axis = j;
+        }
+        positions.push_back(position);
+        axes.push_back(axis);
+        layout.faces[i] = i/9;
+    }
+
+    layout.corner_by_colors.fill(-1);
+    layout.edge_by_colors.fill(-1);
+    size_t num_corners = 0;
+    size_t num_edges = 0;
+    for(size_t i=0; i<NUM_FACELETS3; ++i) {
+        const std::array<int, 3> &position = positions[i];
+        int num_nonzero = (position[0] != 0) + (position[1] != 0) + (position[2] != 0);
+        // Each piece is found from its face element on the reference axis
+        if(num_nonzero == 3 && axes[i] == 1) {
+            // Other face elements in the same rotation sense around the corner
+            int order[3] = {1, 2, 0};
+            if(position[0]*position[1]*position[2] < 0) {
+                order[1] = 0;
+                order[2] = 2;
+            }
+            int colors = 0;
+            for(int k=0; k<3; ++k) {
+                for(size_t j=0; j<NUM_FACELETS3; ++j) {
+                    if(positions[j] == position && axes[j] == order[k]) {
+                        layout.corners[num_corners][k] = j;
+                        colors |= 1 << (j/9);
+                    }
+                }
+            }
+            layout.corner_by_colors[colors] = num_corners++;
+        } else if(num_nonzero == 2 && (axes[i] == 1 || (axes[i] == 2 && position[1] == 0))) {
+            int colors = 1 << (i/9);
+            layout.edges[num_edges][0] = i;
+            for(size_t j=0; j<NUM_FACELETS3; ++j) {
+                if(j != i && positions[j] == position) {
+                    layout.edges[num_edges][1] = j;
+                    colors |= 1 << (j/9);
+                }
+            }
+            layout.edge_by_colors[colors] = num_edges++;
+        }
+    }
+    assert(num_corners == NUM_CORNERS3 && num_edges == NUM_EDGES3);
+
+    // Whole cube orientations, as seen from the centers, reached by turns around FRONT and TOP axes
+    std::array<int, NUM_FACELETS3> tags;
+    std::vector<RubikCube<int, 3>> orientations;
+    layout.orientation_by_centers.fill(-1);
+    for(size_t i=0; i<NUM_FACELETS3; ++i)
+        tags[i] = i;
+    orientations.push_back(RubikCube<int, 3>());
+    for(size_t i=0; i<NUM_FACELETS3; ++i)
+        orientations[0].SetFaceObject((FaceElement)(i/9), i/3%3, i%3, tags[i]);
+    orientations.reserve(NUM_ORIENTATIONS);
+    for(size_t i=0; i<orientations.size(); ++i) {
+        // Copied, since new orientations are added to the vector
+        RubikCube<int, 3> cube = orientations[i];
+        int key = cube.GetFaceElement(FRONT, 1, 1)*INVALID + cube.GetFaceElement(TOP, 1, 1);
+        layout.orientation_by_centers[key] = i;
+        for(size_t j=0; j<NUM_FACELETS3; ++j) {
+            int source = cube.GetFaceObject((FaceElement)(j/9), j/3%3, j%3);
+            layout.permutations[i][j] = source;
+        }
+
+        FaceElement axes_faces[2] = {FRONT, TOP};
+        for(int k=0; k<2; ++k) {
+            RubikCube<int, 3> next = cube;
+            for(size_t depth=0; depth<3; ++depth)
+                next.RotateFace(axes_faces[k], CLOCKWISE, depth);
+            int next_key = next.GetFaceElement(FRONT, 1, 1)*INVALID + next.GetFaceElement(TOP, 1, 1);
+            bool found = false;
+            for(size_t j=0; j<orientations.size() && !found; ++j)
+                found = orientations[j].GetFaceElement(FRONT, 1, 1)*INVALID + orientations[j].GetFaceElement(TOP, 1, 1) == next_key;
+            if(!found)
+                orientations.push_back(next);
+        }
+    }
+    assert(orientations.size() == NUM_ORIENTATIONS);
+
+    return layout;
+}
+
+/**
+  * @brief Returns the layout of the pieces of a 3x3 cube. It is computed on first use
+  */
+static const CubieLayout& GetCubieLayout() {
+    static const CubieLayout layout = BuildCubieLayout();
+    return layout;
+}
+
+CubieState3 GetSolvedCubies3() {
+    CubieState3 cubies;
+    for(size_t i=0; i<NUM_CORNERS3; ++i) {
+        cubies.corner_permutation[i] = i;
+        cubies.corner_twists[i] = 0;
+    }
+    for(size_t i=0; i<NUM_EDGES3; ++i) {
+        cubies.edge_permutation[i] = i;
+        cubies.edge_flips[i] = 0;
+    }
+    return cubies;
+}
+
+bool IsSliceEdge3(size_t edge) {
+    FaceElement reference = (FaceElement)(GetCubieLayout().edges[edge][0] / 9);
+    return reference != TOP && reference != BOTTOM;
+}
+
+/**
+  * @brief Finds the pieces of a 3x3 cube, like FaceletsToCubies3, and ranks their permutations
+  * @param corner_rank Output rank of the corner permutation
+  * @param edge_rank Output rank of the edge permutation
+  */
+static bool FindCubies3(const FaceElement *facelets, CubieState3 &cubies, unsigned &orientation,
+                        uint64_t &corner_rank, uint64_t &edge_rank) {
+    const CubieLayout &layout = GetCubieLayout();
+    FaceElement normalized[NUM_FACELETS3];
+    const FaceElement *pieces = facelets;
+    unsigned invalid = 0;
+    int corner_twist = 0;
+    int edge_flip = 0;
+    uint32_t found_corners = 0;
+    uint32_t found_edges = 0;
+
+    // Errors are accumulated without branches, since most states are valid
+    for(size_t i=0; i<NUM_FACELETS3; ++i)
+        invalid |= (unsigned)facelets[i] >= INVALID;
+    if(invalid)
+        return false;
+
+    // Whole cube orientation is removed, so centers are at their solved positions
+    int centers = layout.orientation_by_centers[facelets[GetFaceletIndex(FRONT, 1, 1)]*INVALID +
+                                                facelets[GetFaceletIndex(TOP, 1, 1)]];
+    if(centers < 0)
+        return false;
+    orientation = centers;
+    // Orientation 0 is the identity, which is the usual case
+    if(orientation != 0) {
+        for(size_t i=0; i<NUM_FACELETS3; ++i)
+            normalized[layout.permutations[orientation][i]] = facelets[i];
+        pieces = normalized;
+    }
+
+    // Twist is the position of the reference color of the piece in the slot. Pieces are valid if all of them are found
+    for(size_t i=0; i<NUM_CORNERS3; ++i) {
+        const std::array<uint8_t, 3> &slot = layout.corners[i];
+        int corner = layout.corner_by_colors[(1 << pieces[slot[0]]) | (1 << pieces[slot[1]]) | (1 << pieces[slot[2]])];
+        invalid |= corner < 0;
+        corner &= NUM_CORNERS3-1;
+        found_corners |= 1u << corner;
+        cubies.corner_permutation[i] = corner;
+
+        int reference = layout.faces[layout.corners[corner][0]];
+        int twist = (pieces[slot[1]] == reference) | (pieces[slot[2]] == reference) << 1;
+        cubies.corner_twists[i] = twist;
+        corner_twist += twist;
+    }
+
+    for(size_t i=0; i<NUM_EDGES3; ++i) {
+        const std::array<uint8_t, 2> &slot = layout.edges[i];
+        int edge = layout.edge_by_colors[(1 << pieces[slot[0]]) | (1 << pieces[slot[1]])];
+        invalid |= edge < 0;
+        edge &= 15;
+        found_edges |= 1u << edge;
+        cubies.edge_permutation[i] = edge;
+
+        int flip = pieces[slot[0]] != layout.faces[layout.edges[edge][0]];
+        cubies.edge_flips[i] = flip;
+        edge_flip += flip;
+    }
+    if(invalid || found_corners != (1u << NUM_CORNERS3) - 1 || found_edges != (1u << NUM_EDGES3) - 1)
+        return false;
+
+    int corner_parity;
+    int edge_parity;
+    corner_rank = RankPermutation(cubies.corner_permutation, corner_parity);
+    edge_rank = RankPermutation(cubies.edge_permutation, edge_parity);
+    return corner_twist % 3 == 0 && edge_flip % 2 == 0 && corner_parity == edge_parity;
+}
+
+bool FaceletsToCubies3(const FaceElement *facelets, CubieState3 &cubies, unsigned &orientation) {
+    uint64_t corner_rank;
+    uint64_t edge_rank;
+    return FindCubies3(facelets, cubies, orientation, corner_rank, edge_rank);
+}
+
+void CubiesToFacelets3(const CubieState3 &cubies, unsigned orientation, FaceElement *facelets) {
+    const CubieLayout &layout = GetCubieLayout();
+    FaceElement normalized[NUM_FACELETS3];
+    FaceElement *pieces = orientation == 0 ? facelets : normalized;
+
+    assert(orientation < NUM_ORIENTATIONS);
+    for(int face=0; face<INVALID; ++face)
+        pieces[GetFaceletIndex((FaceElement)face, 1, 1)] = (FaceElement)face;
+    for(size_t i=0; i<NUM_CORNERS3; ++i) {
+        const std::array<uint8_t, 3> &piece = layout.corners[cubies.corner_permutation[i]];
+        for(int k=0; k<3; ++k)
+            pieces[layout.corners[i][(k+cubies.corner_twists[i])%3]] = (FaceElement)layout.faces[piece[k]];
+    }
+    for(size_t i=0; i<NUM_EDGES3; ++i) {
+        const std::array<uint8_t, 2> &piece = layout.edges[cubies.edge_permutation[i]];
+        for(int k=0; k<2; ++k)
+            pieces[layout.edges[i][(k+cubies.edge_flips[i])%2]] = (FaceElement)layout.faces[piece[k]];
+    }
+
+    if(orientation != 0)
+        for(size_t i=0; i<NUM_FACELETS3; ++i)
+            facelets[i] = normalized[layout.permutations[orientation][i]];
+}
+
+bool EncodeFacelets3(const FaceElement *facelets, uint8_t *data) {
+    CubieState3 cubies;
+    unsigned orientation;
+    uint64_t corner_orientation = 0;
+    uint64_t edge_orientation = 0;
+    uint64_t corner_rank;
+    uint64_t edge_rank;
+
+    if(!FindCubies3(facelets, cubies, orientation, corner_rank, edge_rank))
+        return false;
+    // Orientation of the last piece is implied by the other ones
+    for(size_t i=0; i+1<NUM_CORNERS3; ++i)
+        corner_orientation = corner_orientation*3 + cubies.corner_twists[i];
+    for(size_t i=0; i+1<NUM_EDGES3; ++i)
+        edge_orientation = edge_orientation*2 + cubies.edge_flips[i];
+
+    uint64_t corners = ((uint64_t)orientation*CORNER_PERMUTATIONS + corner_rank) * CORNER_ORIENTATIONS + corner_orientation;
+    uint64_t edges = (edge_rank/2) * EDGE_ORIENTATIONS + edge_orientation;
+    uint64_t low = edges | (corners << EDGE_BITS);
+    for(size_t i=0; i<8; ++i)
+        data[i] = low >> (8*i);
+    data[8] = corners >> (64-EDGE_BITS);
+    return true;
+}
+
+bool DecodeFacelets3(const uint8_t *data, FaceElement *facelets) {
+    CubieState3 cubies;
+    uint64_t low = 0;
+    int corner_twist = 0;
+    int edge_flip = 0;
+
+    for(size_t i=8; i-- > 0;)
+        low = (low << 8) | data[i];
+    uint64_t edges = low & ((1ull << EDGE_BITS) - 1);
+    uint64_t corners = (low >> EDGE_BITS) | ((uint64_t)data[8] << (64-EDGE_BITS));
+
+    uint64_t edge_orientation = edges % EDGE_ORIENTATIONS;
+    uint64_t edge_rank = edges / EDGE_ORIENTATIONS;
+    uint64_t corner_orientation = corners % CORNER_ORIENTATIONS;
+    corners /= CORNER_ORIENTATIONS;
+    uint64_t corner_rank = corners % CORNER_PERMUTATIONS;
+    uint64_t orientation = corners / CORNER_PERMUTATIONS;
+    if(orientation >= NUM_ORIENTATIONS || edge_rank >= EDGE_PERMUTATIONS)
+        return false;
+
+    // Permutations which only differ in the last two elements share rank/2. Edge parity is the corner one
+    int corner_parity;
+    int edge_parity;
+    cubies.corner_permutation = UnrankPermutation<NUM_CORNERS3>(corner_rank, corner_parity);
+    cubies.edge_permutation = UnrankPermutation<NUM_EDGES3>(edge_rank*2, edge_parity);
+    if(edge_parity != corner_parity)
+        std::swap(cubies.edge_permutation[NUM_EDGES3-2], cubies.edge_permutation[NUM_EDGES3-1]);
+
+    // Orientation of the last piece is implied by the other ones
+    for(size_t i=NUM_CORNERS3-1; i-- > 0;) {
+        cubies.corner_twists[i] = corner_orientation % 3;
+        corner_orientation /= 3;
+        corner_twist += cubies.corner_twists[i];
+    }
+    cubies.corner_twists[NUM_CORNERS3-1] = (3 - corner_twist%3) % 3;
+    for(size_t i=NUM_EDGES3-1; i-- > 0;) {
+        cubies.edge_flips[i] = edge_orientation % 2;
+        edge_orientation /= 2;
+        edge_flip += cubies.edge_flips[i];
+    }
+    cubies.edge_flips[NUM_EDGES3-1] = edge_flip % 2;
+
+    CubiesToFacelets3(cubies, orientation, facelets);
+    return true;
+}
+
+size_t EncodeFaceletBlock3(const FaceElement *facelets, size_t num_states, uint8_t *data) {
+    for(size_t i=0; i<num_states; ++i)
+        if(!EncodeFacelets3(facelets + i*NUM_FACELETS3, data + i*STATE3_SIZE))
+            return i;
+    return num_states;
+}
+
+size_t DecodeFaceletBlock3(const uint8_t *data, size_t num_states, FaceElement *facelets) {
+    for(size_t i=0; i<num_states; ++i)
+        if(!DecodeFacelets3(data + i*STATE3_SIZE, facelets + i*NUM_FACELETS3))
+            return i;
+    return num_states;
+}
+
+void PackFacelets(const FaceElement *facelets, size_t num_facelets, uint8_t *data) {
+    size_t i = 0;
+    // 8 face elements fill 3 bytes
+    for(; i+8<=num_facelets; i+=8, data+=3) {
+        uint32_t bits = 0;
+        for(size_t k=0; k<8; ++k)
+            bits |= (uint32_t)facelets[i+k] << (3*k);
+        data[0] = bits;
+        data[1] = bits >> 8;
+        data[2] = bits >> 16;
+    }
+    if(i < num_facelets) {
+        uint32_t bits = 0;
+        for(size_t k=0; i+k<num_facelets; ++k)
+            bits |= (uint32_t)facelets[i+k] << (3*k);
+        for(size_t k=0; k<(3*(num_facelets-i) + 7) / 8; ++k)
+            data[k] = bits >> (8*k);
+    }
+}
+
+bool UnpackFacelets(const uint8_t *data, size_t num_facelets, FaceElement *facelets) {
+    unsigned invalid = 0;
+    for(size_t i=0; i<num_facelets; i+=8, data+=3) {
+        // Bytes past the last face element are not read
+        size_t count = std::min<size_t>(8, num_facelets-i);
+        uint32_t bits = data[0];
+        if(count > 2)
+            bits |= (uint32_t)data[1] << 8;
+        if(count > 5)
+            bits |= (uint32_t)data[2] << 16;
+        for(size_t k=0; k<count; ++k) {
+            unsigned value = (bits >> (3*k)) & 0x7;
+            invalid |= value >= INVALID;
+            facelets[i+k] = (FaceElement)value;
+        }
+    }
+    return !invalid;
+}
@@ -0,0 +1,310 @@
+#include <state_file.h>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+size_t GetColumnRecordSize(ColumnType type, size_t cube_size) {
+    size_t size;
+    switch(type) {
+    case COLUMN_STATE3:   size = STATE3_SIZE; break;
+    case COLUMN_FACELETS: size = GetPackedFaceletsSize(cube_size); break;
+    case COLUMN_UINT8:    size = 1; break;
+    case COLUMN_UINT16:   size = 2; break;
+    case COLUMN_UINT32:   size = 4; break;
+    case COLUMN_UINT64:   size = 8; break;
+    case COLUMN_FLOAT32:  size = 4; break;
+    default:              size = 0; break;
+    }
+    return size;
+}
+
+
+
+StateFileWriter::StateFileWriter(const std::string &filename, size_t cube_size, uint64_t num_records)
+    : filename(filename), cube_size(cube_size), num_records(num_records), fd(-1), closed(false)
+{
+    if(cube_size == 0)
+        throw std::invalid_argument("Invalid cube size");
+    fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+        throw std::runtime_error("Error opening " + filename);
+}
+
+StateFileWriter::~StateFileWriter() {
+    if(!closed) {
+        try {
+            Close();
+        } catch(const std::runtime_error &e) {
+        }
+    }
+}
+
+size_t StateFileWriter::AddColumn(const std::string &name, ColumnType type, size_t record_size) {
+    StateFileColumn column;
+    uint64_t offset = sizeof(StateFileHeader);
+
+    if(name.empty() || name.size() >= COLUMN_NAME_SIZE)
+        throw std::invalid_argument("Invalid column name '" + name + "'");
+    for(size_t i=0; i<columns.size(); ++i)
+        if(name == columns[i].name)
+            throw std::invalid_argument("Duplicated column '" + name + "'");
+    if(type < 0 || type >= NUM_COLUMN_TYPES)
+        throw std::invalid_argument("Invalid type of column '" + name + "'");
+    if(type == COLUMN_STATE3 && cube_size != 3)
+        throw std::invalid_argument("Coordinate encoding is only defined for 3x3 cubes");
+    if(type != COLUMN_BYTES)
+        record_size = GetColumnRecordSize(type, cube_size);
+    if(record_size == 0)
+        throw std::invalid_argument("Invalid record size of column '" + name + "'");
+
+    // Regions of the columns follow each other, so adding a column doesn't move the previous ones
+    if(!columns.empty())
+        offset = columns.back().offset + num_records * columns.back().record_size;
+    memset(&column, 0, sizeof(column));
+    strncpy(column.name, name.c_str(), COLUMN_NAME_SIZE-1);
+    column.type = type;
+    column.record_size = record_size;
+    column.offset = (offset + STATE_FILE_ALIGNMENT - 1) / STATE_FILE_ALIGNMENT * STATE_FILE_ALIGNMENT;
+    column.size = 0;
+    columns.push_back(column);
+    buffers.emplace_back();
+    buffers.back().reserve(std::max(STATE_FILE_BUFFER, record_size));
+    return columns.size()-1;
+}
+
+void StateFileWriter::Write(size_t column, const uint8_t *data, size_t size) {
+    // Bytes of the buffer are already counted in the size of the column
+    uint64_t offset = columns[column].offset + columns[column].size - buffers[column].size();
+    while(size > 0) {
+        ssize_t written = pwrite(fd, data, size, offset);
+        if(written <= 0)
+            throw std::runtime_error("Error writing " + filename);
+        data += written;
+        size -= written;
+        offset += written;
+    }
+}
+
+void StateFileWriter::Flush(size_t column) {
+    Write(column, buffers[column].data(), buffers[column].size());
+    buffers[column].clear();
+}
+
+void StateFileWriter::CheckSpace(size_t column, size_t num_records) const {
+    if(closed || num_records > this->num_records - columns[column].size / columns[column].record_size)
+        throw std::runtime_error(std::string("Column ") + columns[column].name + " has more records than the file");
+}
+
+uint8_t* StateFileWriter::Reserve(size_t column, size_t num_records) {
+    std::vector<uint8_t> &buffer = buffers[column];
+    size_t size = num_records * columns[column].record_size;
+    assert(size <= buffer.capacity());
+    CheckSpace(column, num_records);
+    if(buffer.size() + size > buffer.capacity())
+        Flush(column);
+    buffer.resize(buffer.size() + size);
+    columns[column].size += size;
+    return buffer.data() + buffer.size() - size;
+}
+
+void StateFileWriter::Append(size_t column, const void *record) {
+    assert(column < columns.size());
+    memcpy(Reserve(column, 1), record, columns[column].record_size);
+}
+
+void StateFileWriter::Append(size_t column, const void *records, size_t num_records) {
+    assert(column < columns.size());
+    size_t size = num_records * columns[column].record_size;
+    if(size <= buffers[column].capacity() - buffers[column].size()) {
+        memcpy(Reserve(column, num_records), records, size);
+        return;
+    }
+    // Blocks which don't fit in the buffer are written without copies
+    CheckSpace(column, num_records);
+    Flush(column);
+    Write(column, static_cast<const uint8_t*>(records), size);
+    columns[column].size += size;
+}
+
+void StateFileWriter::AppendFacelets(size_t column, const FaceElement *facelets, size_t num_states) {
+    assert(column < columns.size());
+    const size_t num_facelets = 6 * cube_size * cube_size;
+    const size_t record_size = columns[column].record_size;
+    const size_t block = buffers[column].capacity() / record_size;
+    ColumnType type = (ColumnType)columns[column].type;
+
+    if(type != COLUMN_STATE3 && type != COLUMN_FACELETS)
+        throw std::invalid_argument("Column doesn't hold cube states");
+    // States are encoded in place, a buffer at a time
+    for(size_t first=0; first<num_states; first+=block) {
+        size_t count = std::min(block, num_states - first);
+        uint8_t *data = Reserve(column, count);
+        size_t encoded = count;
+        if(type == COLUMN_STATE3) {
+            encoded = EncodeFaceletBlock3(facelets + first*num_facelets, count, data);
+        } else {
+            for(size_t i=0; i<count; ++i)
+                PackFacelets(facelets + (first+i)*num_facelets, num_facelets, data + i*record_size);
+        }
+        if(encoded < count) {
+            // Only the valid states are kept
+            buffers[column].resize(buffers[column].size() - (count-encoded)*record_size);
+            columns[column].size -= (count-encoded)*record_size;
+            throw std::invalid_argument("State " + std::to_string(first + encoded) + " is not valid");
+        }
+    }
+}
+
+void StateFileWriter::Close() {
+    StateFileHeader header;
+    uint64_t offset = sizeof(header);
+    bool failed = false;
+
+    if(closed)
+        return;
+    closed = true;
+    try {
+        for(size_t i=0; i<columns.size(); ++i) {
+            if(columns[i].size != num_records * columns[i].record_size)
+                throw std::runtime_error(std::string("Column ") + columns[i].name + " doesn't have all the records");
+            Flush(i);
+            offset = columns[i].offset + columns[i].size;
+        }
+    } catch(const std::runtime_error &e) {
+        close(fd);
+        unlink(filename.c_str());
+        throw;
+    }
+    buffers.clear();
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STATE_FILE_MAGIC, sizeof(header.magic));
+    header.version = STATE_FILE_VERSION;
+    header.cube_size = cube_size;
+    header.num_records = num_records;
+    header.directory_offset = (offset + STATE_FILE_ALIGNMENT - 1) / STATE_FILE_ALIGNMENT * STATE_FILE_ALIGNMENT;
+    header.num_columns = columns.size();
+    size_t directory_size = columns.size() * sizeof(StateFileColumn);
+    failed |= pwrite(fd, columns.data(), directory_size, header.directory_offset) != (ssize_t)directory_size;
+    failed |= pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header);
+    failed |= close(fd) != 0;
+    if(failed) {
+        unlink(filename.c_str());
+        throw std::runtime_error("Error writing " + filename);
+    }
+}
+
+
+
+StateFileReader::StateFileReader(const std::string &filename)
+    : fd(-1), mapping(nullptr), mapping_size(0)
+{
+    struct stat info;
+    void *address;
+
+    fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::runtime_error("Error opening " + filename);
+    if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(StateFileHeader)) {
+        close(fd);
+        throw std::runtime_error(filename + " is not a state file");
+    }
+    mapping_size = info.st_size;
+    address = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(address == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Error mapping " + filename);
+    }
+    mapping = static_cast<const uint8_t*>(address);
+    madvise(address, mapping_size, MADV_SEQUENTIAL);
+
+    // Every offset is validated, so records can be read without checks
+    header = reinterpret_cast<const StateFileHeader*>(mapping);
+    bool valid = memcmp(header->magic, STATE_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == STATE_FILE_VERSION && header->cube_size > 0 &&
+                 header->directory_offset <= mapping_size &&
+                 header->num_columns <= (mapping_size - header->directory_offset) / sizeof(StateFileColumn) &&
+                 header->directory_offset % alignof(StateFileColumn) == 0;
+    columns = reinterpret_cast<const StateFileColumn*>(mapping + header->directory_offset);
+    for(size_t i=0; i<header->num_columns && valid; ++i) {
+        const StateFileColumn &column = columns[i];
+        size_t expected_size = GetColumnRecordSize((ColumnType)column.type, header->cube_size);
+        valid = column.type < NUM_COLUMN_TYPES && column.record_size > 0 &&
+                (column.type == COLUMN_BYTES || column.record_size == expected_size) &&
+                memchr(column.name, 0, COLUMN_NAME_SIZE) != nullptr &&
+                column.offset <= mapping_size && column.size <= mapping_size - column.offset &&
+                column.size / column.record_size == header->num_records && column.size % column.record_size == 0;
+    }
+    if(!valid) {
+        munmap(address, mapping_size);
+        close(fd);
+        throw std::runtime_error(filename + " is not a valid state file");
+    }
+}
+
+StateFileReader::~StateFileReader() {
+    munmap(const_cast<uint8_t*>(mapping), mapping_size);
+    close(fd);
+}
+
+size_t StateFileReader::GetCubeSize() const {
+    return header->cube_size;
+}
+
+size_t StateFileReader::GetNumRecords() const {
+    return header->num_records;
+}
+
+size_t StateFileReader::GetNumColumns() const {
+    return header->num_columns;
+}
+
+size_t StateFileReader::FindColumn(const std::string &name) const {
+    for(size_t i=0; i<header->num_columns; ++i)
+        if(name == columns[i].name)
+            return i;
+    throw std::invalid_argument("There is no column '" + name + "'");
+}
+
+std::string StateFileReader::GetColumnName(size_t column) const {
+    assert(column < header->num_columns);
+    return columns[column].name;
+}
+
+ColumnType StateFileReader::GetColumnType(size_t column) const {
+    assert(column < header->num_columns);
+    return (ColumnType)columns[column].type;
+}
+
+size_t StateFileReader::GetRecordSize(size_t column) const {
+    assert(column < header->num_columns);
+    return columns[column].record_size;
+}
+
+const uint8_t* StateFileReader::GetRecord(size_t column, size_t index) const {
+    assert(column < header->num_columns);
+    assert(index < header->num_records);
+    return mapping + columns[column].offset + index*columns[column].record_size;
+}
+
+size_t StateFileReader::ReadFacelets(size_t column, size_t first, size_t num_states, FaceElement *facelets) const {
+    assert(first <= header->num_records && num_states <= header->num_records - first);
+    const size_t num_facelets = 6 * header->cube_size * header->cube_size;
+    const uint8_t *data = mapping + columns[column].offset + first*columns[column].record_size;
+
+    if(GetColumnType(column) == COLUMN_STATE3) {
+        if(header->cube_size != 3)
+            throw std::invalid_argument("Coordinate encoding is only defined for 3x3 cubes");
+        return DecodeFaceletBlock3(data, num_states, facelets);
+    }
+    if(GetColumnType(column) != COLUMN_FACELETS)
+        throw std::invalid_argument("Column doesn't hold cube states");
+    for(size_t i=0; i<num_states; ++i)
+        if(!UnpackFacelets(data + i*columns[column].record_size, num_facelets, facelets + i*num_facelets))
+            return i;
+    return num_states;
+}
@@ -0,0 +1,92 @@
+#include <state_set.h>
+#include <zobrist.h>
+#include <stdexcept>
+#include <cstring>
+
+/*    Offsets of the fields of a slot after the key    */
+static const size_t SLOT_VALUE = 0;
+static const size_t SLOT_USED = 1;
+
+StateSet::StateSet(size_t key_size, size_t capacity)
+    : key_size(key_size), slot_size(key_size + 2), num_states(0)
+{
+    size_t num_slots = 16;
+    if(key_size == 0)
+        throw std::invalid_argument("Keys of a state set shall have bytes");
+    while(num_slots / 4 * 3 < capacity)
+        num_slots *= 2;
+    slots.assign(num_slots * slot_size, 0);
+    mask = num_slots - 1;
+}
+
+uint64_t StateSet::Hash(const uint8_t *key) const {
+    uint64_t hash = ZOBRIST_SEED;
+    size_t i = 0;
+    for(; i+8<=key_size; i+=8) {
+        uint64_t word;
+        memcpy(&word, key + i, 8);
+        hash = ZobristMix(hash ^ word);
+    }
+    if(i < key_size) {
+        uint64_t word = 0;
+        memcpy(&word, key + i, key_size - i);
+        hash = ZobristMix(hash ^ word);
+    }
+    return hash;
+}
+
+uint8_t* StateSet::FindSlot(const uint8_t *key) {
+    return const_cast<uint8_t*>(static_cast<const StateSet*>(this)->FindSlot(key));
+}
+
+const uint8_t* StateSet::FindSlot(const uint8_t *key) const {
+    size_t index = Hash(key) & mask;
+    while(true) {
+        const uint8_t *slot = &slots[index * slot_size];
+        if(!slot[key_size + SLOT_USED] || memcmp(slot, key, key_size) == 0)
+            return slot;
+        index = (index + 1) & mask;
+    }
+}
+
+void StateSet::Grow() {
+    std::vector<uint8_t> old_slots(2 * slots.size(), 0);
+    old_slots.swap(slots);
+    mask = 2*mask + 1;
+    for(size_t i=0; i<old_slots.size(); i+=slot_size) {
+        if(old_slots[i + key_size + SLOT_USED])
+            memcpy(FindSlot(&old_slots[i]), &old_slots[i], slot_size);
+    }
+}
+
+bool StateSet::Insert(const uint8_t *key, uint8_t value) {
+    uint8_t *slot = FindSlot(key);
+    if(slot[key_size + SLOT_USED])
+        return false;
+    memcpy(slot, key, key_size);
+    slot[key_size + SLOT_VALUE] = value;
+    slot[key_size + SLOT_USED] = 1;
+    if(++num_states > (mask + 1) / 4 * 3)
+        Grow();
+    return true;
+}
+
+bool StateSet::Find(const uint8_t *key, uint8_t &value) const {
+    const uint8_t *slot = FindSlot(key);
+    if(!slot[key_size + SLOT_USED])
+        return false;
+    value = slot[key_size + SLOT_VALUE];
+    return true;
+}
+
+size_t StateSet::GetSize() const {
+    return num_states;
+}
+
+size_t StateSet::GetMemoryUsage() const {
+    return slots.size();
+}
+
+size_t StateSet::GetKeySize() const {
+    return key_size;
+}
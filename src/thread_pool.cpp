@@ -0,0 +1,41 @@
+#include <thread_pool.h>
+
+ThreadPool::ThreadPool(size_t num_threads)
+    : stopping(false)
+{
+    if(num_threads == 0)
+        num_threads = std::thread::hardware_concurrency();
+    if(num_threads == 0)
+        num_threads = 1;
+    for(size_t i=0; i<num_threads; ++i)
+        workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for(size_t i=0; i<workers.size(); ++i)
+        workers[i].join();
+}
+
+size_t ThreadPool::GetNumThreads() const {
+    return workers.size();
+}
+
+void ThreadPool::WorkerLoop() {
+    std::function<void()> task;
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if(tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
@@ -1,6 +1,7 @@
 #include <tools.h>
 #include <cmath>
 #include <ctime>
+#include <cstdio>
 
 size_t positive_mod(int numerator, size_t denominator) {
     int module = numerator % (int)denominator;
@@ -22,6 +23,38 @@ double get_current_time() {
     return t.tv_sec + t.tv_nsec/1000000000.0;
 }
 
+double get_monotonic_time() {
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec/1000000000.0;
+}
+
+size_t get_resident_memory() {
+    FILE *status = fopen("/proc/self/status", "r");
+    char line[256];
+    size_t resident_kb = 0;
+    if(!status)
+        return 0;
+    while(fgets(line, sizeof(line), status))
+        if(sscanf(line, "VmRSS: %zu kB", &resident_kb) == 1)
+            break;
+    fclose(status);
+    return resident_kb * 1024;
+}
+
+size_t get_huge_page_memory() {
+    FILE *status = fopen("/proc/self/smaps_rollup", "r");
+    char line[256];
+    size_t huge_kb = 0;
+    if(!status)
+        return 0;
+    while(fgets(line, sizeof(line), status))
+        if(sscanf(line, "AnonHugePages: %zu kB", &huge_kb) == 1)
+            break;
+    fclose(status);
+    return huge_kb * 1024;
+}
+
 double deg_to_radians(double angle) {
     return angle * M_PI / 180.0f;
 }
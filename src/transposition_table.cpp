@@ -0,0 +1,109 @@
+#include <transposition_table.h>
+#include <stdexcept>
+
+/*    Layout of the data word of an entry    */
+static const uint64_t ENTRY_VALID = 1ull << 63;
+static const unsigned ENTRY_DATA_SHIFT = 32;
+static const unsigned ENTRY_DEPTH_SHIFT = 48;
+static const unsigned ENTRY_GENERATION_SHIFT = 56;
+static const uint64_t ENTRY_GENERATION_MASK = 0x7f;
+
+static uint64_t PackEntry(const TranspositionEntry &entry, uint64_t generation) {
+    return ENTRY_VALID | (generation & ENTRY_GENERATION_MASK) << ENTRY_GENERATION_SHIFT |
+           (uint64_t)entry.depth << ENTRY_DEPTH_SHIFT | (uint64_t)entry.data << ENTRY_DATA_SHIFT | entry.value;
+}
+
+static TranspositionEntry UnpackEntry(uint64_t data) {
+    TranspositionEntry entry;
+    entry.value = (uint32_t)data;
+    entry.data = (uint16_t)(data >> ENTRY_DATA_SHIFT);
+    entry.depth = (uint8_t)(data >> ENTRY_DEPTH_SHIFT);
+    return entry;
+}
+
+static uint64_t GetEntryGeneration(uint64_t data) {
+    return (data >> ENTRY_GENERATION_SHIFT) & ENTRY_GENERATION_MASK;
+}
+
+TranspositionTable::TranspositionTable(size_t num_entries, ReplacementPolicy policy)
+    : policy(policy), generation(0)
+{
+    size_t num_buckets = 1;
+    if(num_entries == 0)
+        throw std::invalid_argument("Transposition table shall have entries");
+    while(num_buckets*BUCKET_SIZE < num_entries)
+        num_buckets *= 2;
+    buckets.reset(new Bucket[num_buckets]);
+    bucket_mask = num_buckets - 1;
+    Clear();
+}
+
+bool TranspositionTable::Probe(uint64_t key, TranspositionEntry &entry) const {
+    const Bucket &bucket = buckets[key & bucket_mask];
+    for(size_t i=0; i<BUCKET_SIZE; ++i) {
+        uint64_t data = bucket.slots[i].data.load(std::memory_order_relaxed);
+        uint64_t check = bucket.slots[i].check.load(std::memory_order_relaxed);
+        if((data & ENTRY_VALID) && (check ^ data) == key) {
+            entry = UnpackEntry(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::Store(uint64_t key, const TranspositionEntry &entry) {
+    Bucket &bucket = buckets[key & bucket_mask];
+    uint64_t current_generation = generation.load(std::memory_order_relaxed) & ENTRY_GENERATION_MASK;
+    // Low bits of the key select the bucket, so high ones select the slot
+    size_t victim = (key >> 32) % BUCKET_SIZE;
+    int victim_score = -1;
+
+    for(size_t i=0; i<BUCKET_SIZE; ++i) {
+        uint64_t data = bucket.slots[i].data.load(std::memory_order_relaxed);
+        uint64_t check = bucket.slots[i].check.load(std::memory_order_relaxed);
+        bool current = GetEntryGeneration(data) == current_generation;
+        if(!(data & ENTRY_VALID)) {
+            victim = i;
+            break;
+        }
+        if((check ^ data) == key) {
+            if(policy == REPLACE_SHALLOWER && current && UnpackEntry(data).depth > entry.depth)
+                return;
+            victim = i;
+            break;
+        }
+        if(policy == REPLACE_SHALLOWER) {
+            // Shallowest entry of the oldest generations
+            int score = (current ? 0 : 0x100) + 0xff - UnpackEntry(data).depth;
+            if(score > victim_score) {
+                victim = i;
+                victim_score = score;
+            }
+        }
+    }
+
+    uint64_t data = PackEntry(entry, current_generation);
+    bucket.slots[victim].check.store(key ^ data, std::memory_order_relaxed);
+    bucket.slots[victim].data.store(data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::NewGeneration() {
+    generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TranspositionTable::Clear() {
+    for(size_t i=0; i<=bucket_mask; ++i) {
+        for(size_t j=0; j<BUCKET_SIZE; ++j) {
+            buckets[i].slots[j].check.store(0, std::memory_order_relaxed);
+            buckets[i].slots[j].data.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+size_t TranspositionTable::GetNumEntries() const {
+    return (bucket_mask + 1) * BUCKET_SIZE;
+}
+
+ReplacementPolicy TranspositionTable::GetPolicy() const {
+    return policy;
+}